@@ -1,10 +1,13 @@
 from os import listdir
 import subprocess
+import sys
 
 TESTDIR = "tests/"
 RAELPATH = "build/rael"
 
 def main():
+    # arguments of this script are passed to rael, e.g `python3 runtests.py --closures`
+    flags = "".join(" " + flag for flag in sys.argv[1:])
     files = listdir(TESTDIR)
     failed = []
     i = 1
@@ -18,7 +21,7 @@ def main():
             else:
                 with open(TESTDIR + exp_file, "rb") as f:
                     try:
-                        output = subprocess.check_output("{} {}".format(RAELPATH, TESTDIR + file),
+                        output = subprocess.check_output("{}{} {}".format(RAELPATH, flags, TESTDIR + file),
                             shell=True, stderr=subprocess.STDOUT)
                     except subprocess.CalledProcessError as ex:
                         output = ex.output
@@ -0,0 +1,197 @@
+#include "rael.h"
+#include "rael_api.h"
+
+/*
+ * This is the implementation of the embedding API, which is declared in rael_api.h.
+ * A RaelObject is just a RaelValue that the API owns a reference to.
+ */
+
+struct RaelContext {
+    RaelInterpreter interpreter;
+    /* streams that ran in the context. they're kept alive because routines and blames point into them */
+    RaelStream **streams;
+    size_t amount_streams;
+};
+
+RaelContext *rael_context_new(int argc, char **argv) {
+    RaelContext *context = malloc(sizeof(RaelContext));
+
+    context->streams = NULL;
+    context->amount_streams = 0;
+    interpreter_construct(&context->interpreter, NULL, NULL, "rael", argv,
+                          argc > 0 ? (size_t)argc : 0, false);
+    return context;
+}
+
+void rael_context_delete(RaelContext *context) {
+    interpreter_destruct(&context->interpreter);
+
+    for (size_t i = 0; i < context->amount_streams; ++i) {
+        RaelStream *stream = context->streams[i];
+        free(stream->name);
+        stream_deref(stream);
+    }
+    free(context->streams);
+    free(context);
+}
+
+/* keep the stream until the context is deleted, and make it the current stream of the global instance */
+static void context_add_stream(RaelContext *context, RaelStream *stream) {
+    RaelInstance *instance = context->interpreter.instance;
+
+    context->streams = realloc(context->streams, (context->amount_streams + 1) * sizeof(RaelStream*));
+    context->streams[context->amount_streams++] = stream;
+
+    stream_ref(stream);
+    if (instance->stream)
+        stream_deref(instance->stream);
+    instance->stream = stream;
+}
+
+static RaelStream *context_new_string_stream(RaelContext *context, const char *code, const char *name) {
+    size_t length = strlen(code);
+    char *code_copy = malloc((length + 1) * sizeof(char));
+    RaelStream *stream;
+
+    memcpy(code_copy, code, (length + 1) * sizeof(char));
+    stream = stream_new(code_copy, length, true, name ? rael_cstr_duplicate((char*)name) : NULL);
+    context_add_stream(context, stream);
+    return stream;
+}
+
+static int context_run_stream(RaelContext *context, RaelStream *stream) {
+    RaelInterpreter *interpreter = &context->interpreter;
+    RaelInstance *instance = interpreter->instance;
+    struct Scope *scope = instance->scope;
+    RaelInstruction **volatile instructions = NULL;
+    jmp_buf exit_handler;
+
+    // syntax errors jump to the exit handler without setting an exit code
+    interpreter->exit_code = 1;
+    interpreter->exit_handler = &exit_handler;
+    if (setjmp(exit_handler)) {
+        interpreter_recover(interpreter, instance, scope);
+        interpreter->exit_handler = NULL;
+        instance->instructions = NULL;
+        if (instructions)
+            block_delete(instructions);
+        return interpreter->exit_code;
+    }
+
+    instructions = rael_parse(stream, &exit_handler);
+    instance->instructions = instructions;
+    interpreter_interpret(interpreter);
+
+    // routines keep their own references to the instructions they need
+    instance->instructions = NULL;
+    block_delete(instructions);
+    interpreter->exit_handler = NULL;
+    return 0;
+}
+
+int rael_context_run_file(RaelContext *context, const char *filename) {
+    RaelStream *stream;
+    char *name = rael_cstr_duplicate((char*)filename);
+
+    if (!(stream = rael_load_file(name))) {
+        perror(filename);
+        free(name);
+        return 1;
+    }
+    context_add_stream(context, stream);
+    return context_run_stream(context, stream);
+}
+
+int rael_context_run_string(RaelContext *context, const char *code, const char *name) {
+    return context_run_stream(context, context_new_string_stream(context, code, name));
+}
+
+RaelObject *rael_context_eval(RaelContext *context, const char *expression) {
+    RaelInterpreter *interpreter = &context->interpreter;
+    RaelInstance *instance = interpreter->instance;
+    struct Scope *scope = instance->scope;
+    RaelStream *stream = context_new_string_stream(context, expression, NULL);
+    struct Expr *volatile expr = NULL;
+    RaelValue *value;
+    jmp_buf exit_handler;
+
+    interpreter->exit_handler = &exit_handler;
+    if (setjmp(exit_handler)) {
+        interpreter_recover(interpreter, instance, scope);
+        interpreter->exit_handler = NULL;
+        if (expr)
+            expr_delete(expr);
+        return NULL;
+    }
+
+    if (!(expr = rael_parse_expr(stream, &exit_handler))) {
+        interpreter->exit_handler = NULL;
+        return NULL;
+    }
+    value = expr_eval(interpreter, expr, true);
+    expr_delete(expr);
+    interpreter->exit_handler = NULL;
+
+    return (RaelObject*)value;
+}
+
+static void context_set_value(RaelContext *context, const char *key, RaelValue *value) {
+    // set in the global scope, the scope of the first instance
+    scope_set(context->interpreter.instance->scope, rael_cstr_duplicate((char*)key), value, true);
+    value_deref(value);
+}
+
+void rael_context_set_int(RaelContext *context, const char *key, long value) {
+    context_set_value(context, key, number_newi((RaelInt)value));
+}
+
+void rael_context_set_float(RaelContext *context, const char *key, double value) {
+    context_set_value(context, key, number_newf((RaelFloat)value));
+}
+
+void rael_context_set_string(RaelContext *context, const char *key, const char *string) {
+    context_set_value(context, key, string_new_pure_cpy((char*)string, strlen(string)));
+}
+
+const char *rael_object_type_name(RaelObject *object) {
+    return ((RaelValue*)object)->type->name;
+}
+
+bool rael_object_to_int(RaelObject *object, long *out) {
+    RaelValue *value = (RaelValue*)object;
+
+    if (value->type != &RaelNumberType || !number_is_whole((RaelNumberValue*)value))
+        return false;
+    *out = (long)number_to_int((RaelNumberValue*)value);
+    return true;
+}
+
+bool rael_object_to_float(RaelObject *object, double *out) {
+    RaelValue *value = (RaelValue*)object;
+
+    if (value->type != &RaelNumberType)
+        return false;
+    *out = (double)number_to_float((RaelNumberValue*)value);
+    return true;
+}
+
+char *rael_object_to_cstr(RaelObject *object) {
+    RaelValue *casted = value_cast((RaelValue*)object, &RaelStringType);
+    char *cstr;
+
+    if (!casted)
+        return NULL;
+    if (casted->type != &RaelStringType) {
+        value_deref(casted);
+        return NULL;
+    }
+    cstr = string_to_cstr((RaelStringValue*)casted);
+    value_deref(casted);
+    return cstr;
+}
+
+void rael_object_release(RaelObject *object) {
+    // like free(), so the result of a failed rael_context_eval can be released without a check
+    if (object)
+        value_deref((RaelValue*)object);
+}
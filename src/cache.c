@@ -0,0 +1,942 @@
+#include "rael.h"
+
+/*
+ * The layout of a cache file:
+ *   magic, version, source length, source hash, payload hash (all 8 byte words)
+ *   payload: the string table (amount of strings, then every string's length and bytes),
+ *            and then the program's instructions.
+ * Numbers in the payload are written as LEB128 varints, and signed numbers are zigzag encoded.
+ */
+
+#define RAEL_CACHE_MAGIC 0x5241454c43ULL // "RAELC"
+#define RAEL_CACHE_VERSION 2
+#define RAEL_CACHE_HEADER_SIZE (5 * sizeof(uint64_t))
+
+/* instructions are stored as their index in this array */
+static RaelInstructionType *const instruction_types[] = {
+    NULL, // 0 ends a block
+    &RaelInstructionTypeLog,
+    &RaelInstructionTypeIf,
+    &RaelInstructionTypeLoop,
+    &RaelInstructionTypePureExpr,
+    &RaelInstructionTypeReturn,
+    &RaelInstructionTypeBreak,
+    &RaelInstructionTypeSkip,
+    &RaelInstructionTypeCatch,
+    &RaelInstructionTypeShow,
+    &RaelInstructionTypeLoad,
+    &RaelInstructionTypeYield
+};
+
+#define AMOUNT_INSTRUCTION_TYPES (sizeof(instruction_types) / sizeof(instruction_types[0]))
+
+struct CacheString {
+    const char *string;
+    size_t length;
+};
+
+typedef struct CacheWriter {
+    RaelStream *stream;
+    unsigned char *buffer;
+    size_t length, allocated;
+    /* the interned strings, and an open addressing table of their indices + 1 */
+    struct CacheString *strings;
+    size_t amount_strings, allocated_strings;
+    size_t *table;
+    size_t table_size;
+    /* the previous state that was written */
+    int64_t last_offset;
+} CacheWriter;
+
+typedef struct CacheReader {
+    RaelStream *stream;
+    const unsigned char *cur, *end;
+    struct CacheString *strings;
+    size_t amount_strings;
+    int64_t last_offset;
+    /* set if the payload ended early or had an unknown tag */
+    bool error;
+} CacheReader;
+
+/* FNV-1a */
+static uint64_t cache_hash(const void *data, size_t length) {
+    const unsigned char *bytes = data;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+char *rael_cache_path(const char *filename) {
+    size_t length = strlen(filename);
+    char *path = malloc((length + 2) * sizeof(char));
+
+    memcpy(path, filename, length * sizeof(char));
+    path[length] = 'c';
+    path[length + 1] = '\0';
+    return path;
+}
+
+/* writing */
+
+static void writer_write(CacheWriter *writer, const void *data, size_t length) {
+    if (length == 0)
+        return;
+    if (writer->length + length > writer->allocated) {
+        writer->allocated = (writer->length + length) * 2;
+        writer->buffer = realloc(writer->buffer, writer->allocated);
+    }
+    memcpy(writer->buffer + writer->length, data, length);
+    writer->length += length;
+}
+
+static void writer_byte(CacheWriter *writer, unsigned char byte) {
+    writer_write(writer, &byte, 1);
+}
+
+static void writer_varint(CacheWriter *writer, uint64_t number) {
+    while (number >= 0x80) {
+        writer_byte(writer, (unsigned char)(number | 0x80));
+        number >>= 7;
+    }
+    writer_byte(writer, (unsigned char)number);
+}
+
+static void writer_signed(CacheWriter *writer, int64_t number) {
+    writer_varint(writer, ((uint64_t)number << 1) ^ (uint64_t)(number >> 63));
+}
+
+static void writer_grow_table(CacheWriter *writer) {
+    size_t old_size = writer->table_size;
+    size_t *old_table = writer->table;
+
+    writer->table_size = old_size ? old_size * 2 : 64;
+    writer->table = calloc(writer->table_size, sizeof(size_t));
+    for (size_t i = 0; i < old_size; ++i) {
+        if (old_table[i]) {
+            struct CacheString *string = &writer->strings[old_table[i] - 1];
+            size_t idx = cache_hash(string->string, string->length) & (writer->table_size - 1);
+
+            while (writer->table[idx])
+                idx = (idx + 1) & (writer->table_size - 1);
+            writer->table[idx] = old_table[i];
+        }
+    }
+    free(old_table);
+}
+
+/* write the index of a string in the string table, and add it to the table if it isn't there */
+static void writer_string(CacheWriter *writer, const char *string, size_t length) {
+    size_t idx;
+
+    // keep the table at most half full
+    if ((writer->amount_strings + 1) * 2 > writer->table_size)
+        writer_grow_table(writer);
+
+    idx = cache_hash(string, length) & (writer->table_size - 1);
+    for (; writer->table[idx]; idx = (idx + 1) & (writer->table_size - 1)) {
+        struct CacheString *interned = &writer->strings[writer->table[idx] - 1];
+        if (interned->length == length && (length == 0 || memcmp(interned->string, string, length) == 0)) {
+            writer_varint(writer, writer->table[idx] - 1);
+            return;
+        }
+    }
+
+    if (writer->amount_strings == writer->allocated_strings) {
+        writer->allocated_strings = writer->allocated_strings ? writer->allocated_strings * 2 : 32;
+        writer->strings = realloc(writer->strings, writer->allocated_strings * sizeof(struct CacheString));
+    }
+    writer->strings[writer->amount_strings++] = (struct CacheString) {
+        .string = string,
+        .length = length
+    };
+    writer->table[idx] = writer->amount_strings;
+    writer_varint(writer, writer->amount_strings - 1);
+}
+
+static void writer_cstr(CacheWriter *writer, const char *string) {
+    writer_string(writer, string, strlen(string));
+}
+
+/*
+ * states are written relative to the previous state, because nodes that are next to each other
+ * are usually close in the source. the offset is written as its zigzag encoded difference + 1, or 0
+ * if the state isn't in the stream
+ */
+static void writer_state(CacheWriter *writer, struct State state) {
+    if (state.stream == writer->stream && state.offset <= writer->stream->length) {
+        int64_t offset = (int64_t)state.offset;
+        int64_t difference = offset - writer->last_offset;
+
+        writer_varint(writer, (((uint64_t)difference << 1) ^ (uint64_t)(difference >> 63)) + 1);
+        writer->last_offset = offset;
+    } else {
+        writer_varint(writer, 0);
+    }
+}
+
+static void writer_expr(CacheWriter *writer, struct Expr *expr);
+static void writer_block(CacheWriter *writer, RaelInstruction **block);
+
+/* write an expression that may be NULL. expression types start at 1, so 0 is NULL */
+static void writer_optional_expr(CacheWriter *writer, struct Expr *expr) {
+    if (expr)
+        writer_expr(writer, expr);
+    else
+        writer_varint(writer, 0);
+}
+
+static void writer_optional_block(CacheWriter *writer, RaelInstruction **block) {
+    writer_byte(writer, block != NULL);
+    if (block)
+        writer_block(writer, block);
+}
+
+static void writer_exprlist(CacheWriter *writer, RaelExprList *list) {
+    writer_varint(writer, list->amount_exprs);
+    for (size_t i = 0; i < list->amount_exprs; ++i) {
+        writer_state(writer, list->exprs[i].start_state);
+        writer_expr(writer, list->exprs[i].expr);
+    }
+}
+
+static void writer_value(CacheWriter *writer, struct ValueExpr *value) {
+    writer_varint(writer, value->type);
+    switch (value->type) {
+    case ValueTypeVoid:
+        break;
+    case ValueTypeNumber:
+        writer_byte(writer, value->as_number.is_float);
+        if (value->as_number.is_float)
+            writer_write(writer, &value->as_number.as_float, sizeof(RaelFloat));
+        else
+            writer_signed(writer, value->as_number.as_int);
+        break;
+    case ValueTypeString:
+        writer_string(writer, value->as_string.source, value->as_string.length);
+        break;
+    case ValueTypeRoutine:
+        writer_varint(writer, value->as_routine.amount_parameters);
+        for (size_t i = 0; i < value->as_routine.amount_parameters; ++i)
+            writer_cstr(writer, value->as_routine.parameters[i]);
+        writer_block(writer, value->as_routine.block);
+        writer_byte(writer, value->as_routine.is_generator);
+        break;
+    case ValueTypeStack:
+        writer_exprlist(writer, &value->as_stack.entries);
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+}
+
+static void writer_expr(CacheWriter *writer, struct Expr *expr) {
+    writer_varint(writer, expr->type);
+    writer_state(writer, expr->state);
+
+    switch (expr->type) {
+    case ExprTypeValue:
+        writer_value(writer, expr->as_value);
+        break;
+    case ExprTypeCall:
+        writer_expr(writer, expr->as_call.callable_expr);
+        writer_exprlist(writer, &expr->as_call.args);
+        break;
+    case ExprTypeKey:
+        writer_cstr(writer, expr->as_key);
+        break;
+    case ExprTypeAdd:
+    case ExprTypeSub:
+    case ExprTypeMul:
+    case ExprTypeDiv:
+    case ExprTypeMod:
+    case ExprTypeEquals:
+    case ExprTypeNotEqual:
+    case ExprTypeSmallerThan:
+    case ExprTypeBiggerThan:
+    case ExprTypeSmallerOrEqual:
+    case ExprTypeBiggerOrEqual:
+    case ExprTypeAt:
+    case ExprTypeRedirect:
+    case ExprTypeTo:
+    case ExprTypeAnd:
+    case ExprTypeOr:
+        writer_expr(writer, expr->lhs);
+        writer_expr(writer, expr->rhs);
+        break;
+    case ExprTypeSizeof:
+    case ExprTypeTypeof:
+    case ExprTypeGetString:
+    case ExprTypeNeg:
+    case ExprTypeNot:
+    case ExprTypeBlame:
+        writer_optional_expr(writer, expr->as_single);
+        break;
+    case ExprTypeSet:
+    case ExprTypeAddEqual:
+    case ExprTypeSubEqual:
+    case ExprTypeMulEqual:
+    case ExprTypeDivEqual:
+    case ExprTypeModEqual:
+        writer_varint(writer, expr->as_set.set_type);
+        switch (expr->as_set.set_type) {
+        case SetTypeKey:
+            writer_cstr(writer, expr->as_set.as_key);
+            break;
+        case SetTypeAtExpr:
+            writer_expr(writer, expr->as_set.as_at);
+            break;
+        case SetTypeMember:
+            writer_expr(writer, expr->as_set.as_member);
+            break;
+        default:
+            RAEL_UNREACHABLE();
+        }
+        writer_expr(writer, expr->as_set.expr);
+        break;
+    case ExprTypeMatch:
+        writer_expr(writer, expr->as_match.match_against);
+        writer_varint(writer, expr->as_match.amount_cases);
+        for (size_t i = 0; i < expr->as_match.amount_cases; ++i) {
+            writer_exprlist(writer, &expr->as_match.match_cases[i].match_exprs);
+            writer_block(writer, expr->as_match.match_cases[i].case_block);
+        }
+        writer_optional_block(writer, expr->as_match.else_block);
+        break;
+    case ExprTypeGetMember:
+        writer_expr(writer, expr->as_get_member.lhs);
+        writer_cstr(writer, expr->as_get_member.key);
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+}
+
+static void writer_instruction(CacheWriter *writer, RaelInstruction *instruction) {
+    RaelInstructionType *type = instruction->type;
+    size_t tag = 1;
+
+    while (instruction_types[tag] != type)
+        ++tag;
+    writer_varint(writer, tag);
+    writer_state(writer, instruction->state);
+
+    if (type == &RaelInstructionTypeLog || type == &RaelInstructionTypeShow) {
+        writer_exprlist(writer, &((RaelCsvInstruction*)instruction)->csv);
+    } else if (type == &RaelInstructionTypeIf) {
+        struct IfInstructionInfo *info = &((RaelIfInstruction*)instruction)->info;
+
+        writer_expr(writer, info->condition);
+        writer_byte(writer, info->if_type);
+        if (info->if_type == IfTypeBlock)
+            writer_block(writer, info->if_block);
+        else
+            writer_instruction(writer, info->if_instruction);
+        writer_byte(writer, info->else_type);
+        if (info->else_type == ElseTypeBlock)
+            writer_block(writer, info->else_block);
+        else if (info->else_type == ElseTypeInstruction)
+            writer_instruction(writer, info->else_instruction);
+    } else if (type == &RaelInstructionTypeLoop) {
+        struct LoopInstructionInfo *info = &((RaelLoopInstruction*)instruction)->info;
+
+        writer_byte(writer, info->type);
+        switch (info->type) {
+        case LoopWhile:
+            writer_expr(writer, info->while_condition);
+            break;
+        case LoopThrough:
+            writer_cstr(writer, info->iterate.key);
+            writer_expr(writer, info->iterate.expr);
+            writer_optional_expr(writer, info->iterate.secondary_condition);
+            break;
+        case LoopForever:
+            break;
+        default:
+            RAEL_UNREACHABLE();
+        }
+        writer_block(writer, info->block);
+    } else if (type == &RaelInstructionTypePureExpr) {
+        writer_expr(writer, ((RaelPureInstruction*)instruction)->expr);
+    } else if (type == &RaelInstructionTypeReturn) {
+        writer_optional_expr(writer, ((RaelReturnInstruction*)instruction)->return_expr);
+        writer_byte(writer, ((RaelReturnInstruction*)instruction)->is_tail_call);
+    } else if (type == &RaelInstructionTypeCatch) {
+        RaelCatchInstruction *inst = (RaelCatchInstruction*)instruction;
+
+        writer_expr(writer, inst->catch_expr);
+        writer_block(writer, inst->handle_block);
+        writer_optional_block(writer, inst->else_block);
+        writer_byte(writer, inst->value_key != NULL);
+        if (inst->value_key)
+            writer_cstr(writer, inst->value_key);
+    } else if (type == &RaelInstructionTypeLoad) {
+        writer_cstr(writer, ((RaelLoadInstruction*)instruction)->module_name);
+    } else if (type == &RaelInstructionTypeYield) {
+        writer_expr(writer, ((RaelYieldInstruction*)instruction)->yield_expr);
+    }
+}
+
+static void writer_block(CacheWriter *writer, RaelInstruction **block) {
+    for (size_t i = 0; block[i]; ++i)
+        writer_instruction(writer, block[i]);
+    writer_varint(writer, 0);
+}
+
+bool rael_cache_store(const char *path, RaelInstruction **program, RaelStream *stream) {
+    CacheWriter writer = {
+        .stream = stream,
+        .buffer = NULL,
+        .length = 0,
+        .allocated = 0,
+        .strings = NULL,
+        .amount_strings = 0,
+        .allocated_strings = 0,
+        .table = NULL,
+        .table_size = 0,
+        .last_offset = 0
+    };
+    CacheWriter strings = writer;
+    uint64_t header[5];
+    char *temp_path;
+    FILE *file;
+    bool written;
+
+    writer_block(&writer, program);
+
+    // the string table goes before the program, so the strings are known when the program is read
+    writer_varint(&strings, writer.amount_strings);
+    for (size_t i = 0; i < writer.amount_strings; ++i) {
+        writer_varint(&strings, writer.strings[i].length);
+        writer_write(&strings, writer.strings[i].string, writer.strings[i].length);
+    }
+    writer_write(&strings, writer.buffer, writer.length);
+
+    header[0] = RAEL_CACHE_MAGIC;
+    header[1] = RAEL_CACHE_VERSION;
+    header[2] = stream->length;
+    header[3] = cache_hash(stream->base, stream->length);
+    header[4] = cache_hash(strings.buffer, strings.length);
+
+    // write to a temporary file first, so a program that reads the cache at the same time never sees half of it
+    temp_path = malloc((strlen(path) + 5) * sizeof(char));
+    sprintf(temp_path, "%s.tmp", path);
+    if ((file = fopen(temp_path, "wb"))) {
+        written = fwrite(header, sizeof(header), 1, file) == 1 &&
+                  fwrite(strings.buffer, 1, strings.length, file) == strings.length;
+        written = fclose(file) == 0 && written;
+        if (written)
+            written = rename(temp_path, path) == 0;
+        if (!written)
+            remove(temp_path);
+    } else {
+        written = false;
+    }
+
+    free(temp_path);
+    free(writer.buffer);
+    free(writer.strings);
+    free(writer.table);
+    free(strings.buffer);
+    return written;
+}
+
+/* reading */
+
+static unsigned char reader_byte(CacheReader *reader) {
+    if (reader->cur == reader->end) {
+        reader->error = true;
+        return 0;
+    }
+    return *reader->cur++;
+}
+
+static uint64_t reader_varint(CacheReader *reader) {
+    uint64_t number = 0;
+
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        unsigned char byte = reader_byte(reader);
+
+        number |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            break;
+    }
+    return number;
+}
+
+static int64_t reader_signed(CacheReader *reader) {
+    uint64_t number = reader_varint(reader);
+    return (int64_t)(number >> 1) ^ -(int64_t)(number & 1);
+}
+
+static struct CacheString reader_string(CacheReader *reader) {
+    uint64_t idx = reader_varint(reader);
+
+    if (idx >= reader->amount_strings) {
+        reader->error = true;
+        return (struct CacheString) { .string = "", .length = 0 };
+    }
+    return reader->strings[idx];
+}
+
+/* read a string from the string table and copy it into a heap allocated cstring */
+static char *reader_cstr(CacheReader *reader) {
+    struct CacheString string = reader_string(reader);
+    char *cstr = malloc((string.length + 1) * sizeof(char));
+
+    memcpy(cstr, string.string, string.length * sizeof(char));
+    cstr[string.length] = '\0';
+    return cstr;
+}
+
+static struct State reader_state(CacheReader *reader) {
+    struct State state;
+    uint64_t encoded = reader_varint(reader);
+    int64_t offset;
+
+    if (encoded == 0) {
+        memset(&state, 0, sizeof(struct State));
+        return state;
+    }
+    --encoded;
+    offset = reader->last_offset + ((int64_t)(encoded >> 1) ^ -(int64_t)(encoded & 1));
+    if (offset < 0 || (uint64_t)offset > reader->stream->length) {
+        reader->error = true;
+        offset = 0;
+    }
+    reader->last_offset = offset;
+
+    state.stream = reader->stream;
+    state.offset = (uint32_t)offset;
+    return state;
+}
+
+static struct Expr *reader_optional_expr(CacheReader *reader);
+static RaelInstruction **reader_block(CacheReader *reader);
+
+/* read an expression. if the payload is invalid, a Void value is returned so the tree can still be deleted */
+static struct Expr *reader_expr(CacheReader *reader) {
+    struct Expr *expr = reader_optional_expr(reader);
+
+    if (!expr) {
+        reader->error = true;
+        expr = expr_new(ExprTypeValue);
+        memset(&expr->state, 0, sizeof(struct State));
+        expr->as_value = value_expr_new(ValueTypeVoid);
+    }
+    return expr;
+}
+
+static RaelInstruction **reader_optional_block(CacheReader *reader) {
+    return reader_byte(reader) ? reader_block(reader) : NULL;
+}
+
+static RaelExprList reader_exprlist(CacheReader *reader) {
+    RaelExprList list;
+
+    list.amount_exprs = reader_varint(reader);
+    // every entry takes at least two bytes, which also stops huge allocations on an invalid payload
+    if (list.amount_exprs > (size_t)(reader->end - reader->cur) / 2) {
+        reader->error = true;
+        list.amount_exprs = 0;
+    }
+    list.exprs = list.amount_exprs > 0 ? malloc(list.amount_exprs * sizeof(struct RaelExprListEntry)) : NULL;
+    for (size_t i = 0; i < list.amount_exprs; ++i) {
+        list.exprs[i].start_state = reader_state(reader);
+        list.exprs[i].expr = reader_expr(reader);
+    }
+    return list;
+}
+
+static struct ValueExpr *reader_value(CacheReader *reader) {
+    enum ValueExprType type = (enum ValueExprType)reader_varint(reader);
+    struct ValueExpr *value;
+
+    switch (type) {
+    case ValueTypeNumber:
+        value = value_expr_new(ValueTypeNumber);
+        if ((value->as_number.is_float = reader_byte(reader))) {
+            if ((size_t)(reader->end - reader->cur) < sizeof(RaelFloat)) {
+                reader->error = true;
+                value->as_number.as_float = 0;
+            } else {
+                memcpy(&value->as_number.as_float, reader->cur, sizeof(RaelFloat));
+                reader->cur += sizeof(RaelFloat);
+            }
+        } else {
+            value->as_number.as_int = (RaelInt)reader_signed(reader);
+        }
+        break;
+    case ValueTypeString: {
+        struct CacheString string = reader_string(reader);
+
+        value = value_expr_new(ValueTypeString);
+        value->as_string.length = string.length;
+        value->as_string.interned = NULL;
+        // empty strings have no buffer, like in the parser
+        if (string.length == 0) {
+            value->as_string.source = NULL;
+        } else {
+            value->as_string.source = malloc(string.length * sizeof(char));
+            memcpy(value->as_string.source, string.string, string.length * sizeof(char));
+        }
+        break;
+    }
+    case ValueTypeRoutine: {
+        struct ASTRoutineValue *routine;
+
+        value = value_expr_new(ValueTypeRoutine);
+        routine = &value->as_routine;
+        routine->amount_parameters = reader_varint(reader);
+        if (routine->amount_parameters > (size_t)(reader->end - reader->cur)) {
+            reader->error = true;
+            routine->amount_parameters = 0;
+        }
+        routine->parameters = routine->amount_parameters > 0 ? malloc(routine->amount_parameters * sizeof(char*)) : NULL;
+        for (size_t i = 0; i < routine->amount_parameters; ++i)
+            routine->parameters[i] = reader_cstr(reader);
+        routine->block = reader_block(reader);
+        routine->is_generator = reader_byte(reader);
+        break;
+    }
+    case ValueTypeStack:
+        value = value_expr_new(ValueTypeStack);
+        value->as_stack.entries = reader_exprlist(reader);
+        break;
+    case ValueTypeVoid:
+        value = value_expr_new(ValueTypeVoid);
+        break;
+    default:
+        reader->error = true;
+        value = value_expr_new(ValueTypeVoid);
+    }
+
+    return value;
+}
+
+static struct Expr *reader_optional_expr(CacheReader *reader) {
+    enum ExprType type = (enum ExprType)reader_varint(reader);
+    struct Expr *expr;
+
+    if (type == 0 || type > ExprTypeGetMember) {
+        if (type != 0)
+            reader->error = true;
+        return NULL;
+    }
+
+    expr = expr_new(type);
+    expr->state = reader_state(reader);
+    switch (type) {
+    case ExprTypeValue:
+        expr->as_value = reader_value(reader);
+        break;
+    case ExprTypeCall:
+        expr->as_call.callable_expr = reader_expr(reader);
+        expr->as_call.args = reader_exprlist(reader);
+        break;
+    case ExprTypeKey:
+        expr->as_key = reader_cstr(reader);
+        break;
+    case ExprTypeAdd:
+    case ExprTypeSub:
+    case ExprTypeMul:
+    case ExprTypeDiv:
+    case ExprTypeMod:
+    case ExprTypeEquals:
+    case ExprTypeNotEqual:
+    case ExprTypeSmallerThan:
+    case ExprTypeBiggerThan:
+    case ExprTypeSmallerOrEqual:
+    case ExprTypeBiggerOrEqual:
+    case ExprTypeAt:
+    case ExprTypeRedirect:
+    case ExprTypeTo:
+    case ExprTypeAnd:
+    case ExprTypeOr:
+        expr->lhs = reader_expr(reader);
+        expr->rhs = reader_expr(reader);
+        break;
+    case ExprTypeBlame:
+        expr->as_single = reader_optional_expr(reader);
+        break;
+    case ExprTypeSizeof:
+    case ExprTypeTypeof:
+    case ExprTypeGetString:
+    case ExprTypeNeg:
+    case ExprTypeNot:
+        expr->as_single = reader_expr(reader);
+        break;
+    case ExprTypeSet:
+    case ExprTypeAddEqual:
+    case ExprTypeSubEqual:
+    case ExprTypeMulEqual:
+    case ExprTypeDivEqual:
+    case ExprTypeModEqual:
+        switch (reader_varint(reader)) {
+        case SetTypeAtExpr:
+            expr->as_set.set_type = SetTypeAtExpr;
+            expr->as_set.as_at = reader_expr(reader);
+            break;
+        case SetTypeMember:
+            expr->as_set.set_type = SetTypeMember;
+            expr->as_set.as_member = reader_expr(reader);
+            break;
+        case SetTypeKey:
+            expr->as_set.set_type = SetTypeKey;
+            expr->as_set.as_key = reader_cstr(reader);
+            break;
+        default:
+            reader->error = true;
+            expr->as_set.set_type = SetTypeKey;
+            expr->as_set.as_key = reader_cstr(reader);
+        }
+        expr->as_set.expr = reader_expr(reader);
+        break;
+    case ExprTypeMatch: {
+        struct MatchExpr *match = &expr->as_match;
+
+        match->match_against = reader_expr(reader);
+        match->amount_cases = reader_varint(reader);
+        if (match->amount_cases > (size_t)(reader->end - reader->cur)) {
+            reader->error = true;
+            match->amount_cases = 0;
+        }
+        match->match_cases = match->amount_cases > 0 ? malloc(match->amount_cases * sizeof(struct MatchCase)) : NULL;
+        for (size_t i = 0; i < match->amount_cases; ++i) {
+            match->match_cases[i].match_exprs = reader_exprlist(reader);
+            match->match_cases[i].case_block = reader_block(reader);
+        }
+        match->else_block = reader_optional_block(reader);
+        break;
+    }
+    case ExprTypeGetMember:
+        expr->as_get_member.lhs = reader_expr(reader);
+        expr->as_get_member.key = reader_cstr(reader);
+        expr->as_get_member.cache.map.version = 0;
+        expr->as_get_member.cache.map.node = NULL;
+        expr->as_get_member.cache.shape = NULL;
+        expr->as_get_member.cache.type = NULL;
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+
+    return expr;
+}
+
+/* read an instruction. returns NULL at the end of a block, or if the payload is invalid */
+static RaelInstruction *reader_instruction(CacheReader *reader) {
+    uint64_t tag = reader_varint(reader);
+    RaelInstructionType *type;
+    RaelInstruction *instruction;
+    struct State state;
+
+    if (tag == 0 || tag >= AMOUNT_INSTRUCTION_TYPES) {
+        if (tag != 0)
+            reader->error = true;
+        return NULL;
+    }
+    type = instruction_types[tag];
+    state = reader_state(reader);
+
+    if (type == &RaelInstructionTypeLog || type == &RaelInstructionTypeShow) {
+        RaelCsvInstruction *inst = (RaelCsvInstruction*)instruction_new(type, sizeof(RaelCsvInstruction));
+
+        inst->csv = reader_exprlist(reader);
+        instruction = (RaelInstruction*)inst;
+    } else if (type == &RaelInstructionTypeIf) {
+        RaelIfInstruction *inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeIf, RaelIfInstruction);
+        struct IfInstructionInfo *info = &inst->info;
+
+        info->condition = reader_expr(reader);
+        // a missing instruction is replaced by an empty block
+        if (reader_byte(reader) == IfTypeInstruction && (info->if_instruction = reader_instruction(reader))) {
+            info->if_type = IfTypeInstruction;
+        } else {
+            info->if_type = IfTypeBlock;
+            info->if_block = reader_block(reader);
+        }
+        switch (reader_byte(reader)) {
+        case ElseTypeBlock:
+            info->else_type = ElseTypeBlock;
+            info->else_block = reader_block(reader);
+            break;
+        case ElseTypeInstruction:
+            info->else_type = (info->else_instruction = reader_instruction(reader)) ? ElseTypeInstruction : ElseTypeNone;
+            break;
+        default:
+            info->else_type = ElseTypeNone;
+        }
+        instruction = (RaelInstruction*)inst;
+    } else if (type == &RaelInstructionTypeLoop) {
+        RaelLoopInstruction *inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeLoop, RaelLoopInstruction);
+        struct LoopInstructionInfo *info = &inst->info;
+
+        switch (reader_byte(reader)) {
+        case LoopWhile:
+            info->type = LoopWhile;
+            info->while_condition = reader_expr(reader);
+            break;
+        case LoopThrough:
+            info->type = LoopThrough;
+            info->iterate.key = reader_cstr(reader);
+            info->iterate.expr = reader_expr(reader);
+            info->iterate.secondary_condition = reader_optional_expr(reader);
+            break;
+        default:
+            info->type = LoopForever;
+        }
+        info->block = reader_block(reader);
+        jit_state_new(&inst->jit);
+        instruction = (RaelInstruction*)inst;
+    } else if (type == &RaelInstructionTypePureExpr) {
+        RaelPureInstruction *inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypePureExpr, RaelPureInstruction);
+
+        inst->expr = reader_expr(reader);
+        instruction = (RaelInstruction*)inst;
+    } else if (type == &RaelInstructionTypeReturn) {
+        RaelReturnInstruction *inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeReturn, RaelReturnInstruction);
+
+        inst->return_expr = reader_optional_expr(reader);
+        inst->is_tail_call = reader_byte(reader);
+        instruction = (RaelInstruction*)inst;
+    } else if (type == &RaelInstructionTypeCatch) {
+        RaelCatchInstruction *inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeCatch, RaelCatchInstruction);
+
+        inst->catch_expr = reader_expr(reader);
+        inst->handle_block = reader_block(reader);
+        inst->else_block = reader_optional_block(reader);
+        inst->value_key = reader_byte(reader) ? reader_cstr(reader) : NULL;
+        instruction = (RaelInstruction*)inst;
+    } else if (type == &RaelInstructionTypeLoad) {
+        RaelLoadInstruction *inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeLoad, RaelLoadInstruction);
+
+        inst->module_name = reader_cstr(reader);
+        instruction = (RaelInstruction*)inst;
+    } else if (type == &RaelInstructionTypeYield) {
+        RaelYieldInstruction *inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeYield, RaelYieldInstruction);
+
+        inst->yield_expr = reader_expr(reader);
+        instruction = (RaelInstruction*)inst;
+    } else {
+        // break and skip
+        instruction = instruction_new(type, sizeof(RaelInstruction));
+    }
+
+    instruction->state = state;
+    return instruction;
+}
+
+static RaelInstruction **reader_block(CacheReader *reader) {
+    RaelInstruction **block;
+    size_t allocated = 4, idx = 0;
+
+    block = malloc(allocated * sizeof(RaelInstruction*));
+    while ((block[idx] = reader_instruction(reader))) {
+        if (++idx == allocated)
+            block = realloc(block, (allocated *= 2) * sizeof(RaelInstruction*));
+    }
+    return realloc(block, (idx + 1) * sizeof(RaelInstruction*));
+}
+
+static RaelInstruction **cache_decode(RaelStream *stream, const unsigned char *data, size_t length) {
+    uint64_t header[5];
+    CacheReader reader;
+    RaelInstruction **program;
+
+    if (length < RAEL_CACHE_HEADER_SIZE)
+        return NULL;
+
+    memcpy(header, data, sizeof(header));
+    if (header[0] != RAEL_CACHE_MAGIC || header[1] != RAEL_CACHE_VERSION || header[2] != stream->length ||
+        header[3] != cache_hash(stream->base, stream->length) ||
+        header[4] != cache_hash(data + RAEL_CACHE_HEADER_SIZE, length - RAEL_CACHE_HEADER_SIZE)) {
+        return NULL;
+    }
+
+    reader.stream = stream;
+    reader.cur = data + RAEL_CACHE_HEADER_SIZE;
+    reader.end = data + length;
+    reader.last_offset = 0;
+    reader.error = false;
+
+    // the strings point into the cache, and are copied when the program needs them
+    reader.amount_strings = reader_varint(&reader);
+    if (reader.amount_strings > (size_t)(reader.end - reader.cur))
+        return NULL;
+    reader.strings = malloc(reader.amount_strings * sizeof(struct CacheString));
+    for (size_t i = 0; i < reader.amount_strings; ++i) {
+        reader.strings[i].length = reader_varint(&reader);
+        if (reader.strings[i].length > (size_t)(reader.end - reader.cur)) {
+            free(reader.strings);
+            return NULL;
+        }
+        reader.strings[i].string = (const char*)reader.cur;
+        reader.cur += reader.strings[i].length;
+    }
+
+    program = reader_block(&reader);
+    free(reader.strings);
+
+    if (reader.error || reader.cur != reader.end) {
+        block_delete(program);
+        return NULL;
+    }
+    return program;
+}
+
+#ifdef __unix__
+RaelInstruction **rael_cache_load(const char *path, RaelStream *stream) {
+    RaelInstruction **program;
+    unsigned char *data;
+    off_t length;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) == -1)
+        return NULL;
+    length = lseek(fd, 0, SEEK_END);
+    if (length <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    data = mmap(NULL, (size_t)length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    program = cache_decode(stream, data, (size_t)length);
+    munmap(data, (size_t)length);
+    return program;
+}
+#else
+RaelInstruction **rael_cache_load(const char *path, RaelStream *stream) {
+    RaelInstruction **program;
+    unsigned char *data;
+    long length;
+    FILE *file;
+
+    if (!(file = fopen(path, "rb")))
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length <= 0 || !(data = malloc((size_t)length))) {
+        fclose(file);
+        return NULL;
+    }
+    if (fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+
+    program = cache_decode(stream, data, (size_t)length);
+    free(data);
+    return program;
+}
+#endif
@@ -0,0 +1,25 @@
+#ifndef RAEL_CACHE_H
+#define RAEL_CACHE_H
+
+#include "parser.h"
+#include "stream.h"
+
+#include <stdbool.h>
+
+/*
+ * A program cache is a compact binary form of a parsed program, stored next to its source
+ * (program.rael is cached in program.raelc). Strings and keys are stored once in a string table,
+ * and are referenced by their index. The cache stores a hash of the source it was made from,
+ * so it's only used while the source doesn't change.
+ */
+
+/* returns a heap allocated path of the cache of a source file */
+char *rael_cache_path(const char *filename);
+
+/* load the program of `stream` from its cache. returns NULL if the cache doesn't exist or isn't valid */
+RaelInstruction **rael_cache_load(const char *path, RaelStream *stream);
+
+/* store a program that was parsed from `stream`. returns false if it couldn't be written */
+bool rael_cache_store(const char *path, RaelInstruction **program, RaelStream *stream);
+
+#endif // RAEL_CACHE_H
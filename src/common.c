@@ -26,15 +26,23 @@ RaelFloat rael_float_abs(RaelFloat f) {
 }
 
 void rael_show_error_tag(char* const filename, struct State state) {
+    size_t line, column;
+
+    stream_position(state.stream, state.offset, &line, &column);
     if (filename)
-        printf("Error [%s:%zu:%zu]: ", filename, state.line, state.column);
+        printf("Error [%s:%zu:%zu]: ", filename, line, column);
     else
-        printf("Error [%zu:%zu]: ", state.line, state.column);
+        printf("Error [%zu:%zu]: ", line, column);
 }
 
 void rael_show_line_state(struct State state) {
-    size_t line_length = state.column - 1;
-    char *line_start = state.stream_pos.cur - line_length;
+    size_t line, column;
+    size_t line_length;
+    char *line_start;
+
+    stream_position(state.stream, state.offset, &line, &column);
+    line_length = column - 1;
+    line_start = state.stream->base + state.offset - line_length;
 
     // show the line
     printf("| ");
@@ -59,9 +67,8 @@ void rael_show_line_state(struct State state) {
 
 void rael_show_error_message(char* const filename, struct State state, const char* const error_message, va_list va) {
     // advance all whitespace
-    while (state.stream_pos.cur[0] == ' ' || state.stream_pos.cur[0] == '\t') {
-        ++state.column;
-        ++state.stream_pos.cur;
+    while (state.stream->base[state.offset] == ' ' || state.stream->base[state.offset] == '\t') {
+        ++state.offset;
     }
     rael_show_error_tag(filename, state);
     vprintf(error_message, va);
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <float.h>
 
 /* declare constants for Rael */
@@ -39,9 +40,14 @@ struct RaelHybridNumber {
     };
 };
 
+/*
+ * a position in a stream. only the offset is stored, and the line and column are computed
+ * from the stream's line table when they're needed (which is only when an error is shown)
+ */
 struct State {
-    RaelStreamPtr stream_pos;
-    size_t line, column;
+    /* NULL if the state isn't in a stream */
+    RaelStream *stream;
+    uint32_t offset;
 };
 
 typedef struct RaelArgument {
@@ -0,0 +1,760 @@
+#include "rael.h"
+
+typedef struct CEmitter {
+    /* the functions are written to the output directly */
+    FILE *out;
+    /* the code that builds the syntax tree, which is copied to the output after the functions */
+    FILE *build;
+    RaelStream *stream;
+    /* used to give every node of the tree a different C variable */
+    size_t next_id;
+} CEmitter;
+
+static const char *const expr_type_names[] = {
+    [ExprTypeValue] = "ExprTypeValue",
+    [ExprTypeCall] = "ExprTypeCall",
+    [ExprTypeKey] = "ExprTypeKey",
+    [ExprTypeAdd] = "ExprTypeAdd",
+    [ExprTypeSub] = "ExprTypeSub",
+    [ExprTypeMul] = "ExprTypeMul",
+    [ExprTypeDiv] = "ExprTypeDiv",
+    [ExprTypeMod] = "ExprTypeMod",
+    [ExprTypeNeg] = "ExprTypeNeg",
+    [ExprTypeEquals] = "ExprTypeEquals",
+    [ExprTypeNotEqual] = "ExprTypeNotEqual",
+    [ExprTypeSmallerThan] = "ExprTypeSmallerThan",
+    [ExprTypeBiggerThan] = "ExprTypeBiggerThan",
+    [ExprTypeSmallerOrEqual] = "ExprTypeSmallerOrEqual",
+    [ExprTypeBiggerOrEqual] = "ExprTypeBiggerOrEqual",
+    [ExprTypeAt] = "ExprTypeAt",
+    [ExprTypeRedirect] = "ExprTypeRedirect",
+    [ExprTypeSizeof] = "ExprTypeSizeof",
+    [ExprTypeTypeof] = "ExprTypeTypeof",
+    [ExprTypeGetString] = "ExprTypeGetString",
+    [ExprTypeTo] = "ExprTypeTo",
+    [ExprTypeBlame] = "ExprTypeBlame",
+    [ExprTypeSet] = "ExprTypeSet",
+    [ExprTypeAddEqual] = "ExprTypeAddEqual",
+    [ExprTypeSubEqual] = "ExprTypeSubEqual",
+    [ExprTypeMulEqual] = "ExprTypeMulEqual",
+    [ExprTypeDivEqual] = "ExprTypeDivEqual",
+    [ExprTypeModEqual] = "ExprTypeModEqual",
+    [ExprTypeAnd] = "ExprTypeAnd",
+    [ExprTypeOr] = "ExprTypeOr",
+    [ExprTypeNot] = "ExprTypeNot",
+    [ExprTypeMatch] = "ExprTypeMatch",
+    [ExprTypeGetMember] = "ExprTypeGetMember"
+};
+
+static size_t emit_expr(CEmitter *emitter, struct Expr *expr);
+static size_t emit_block(CEmitter *emitter, RaelInstruction **block);
+
+/* write a C string literal. if `line_length` isn't 0, the literal is split to lines of that length */
+static void emit_string_literal(FILE *out, const char *string, size_t length, size_t line_length) {
+    fputc('"', out);
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = (unsigned char)string[i];
+
+        if (line_length > 0 && i > 0 && i % line_length == 0)
+            fputs("\"\n    \"", out);
+        // '?' is escaped so it can't start a trigraph
+        if (c == '"' || c == '\\' || c == '?')
+            fprintf(out, "\\%c", c);
+        else if (c >= ' ' && c <= '~')
+            fputc(c, out);
+        else
+            fprintf(out, "\\%03o", c);
+    }
+    fputc('"', out);
+}
+
+static void emit_state(CEmitter *emitter, struct State state) {
+    if (state.stream == emitter->stream && state.offset <= emitter->stream->length) {
+        fprintf(emitter->build, "rael_state(%lu)", (unsigned long)state.offset);
+    } else {
+        fputs("rael_no_state()", emitter->build);
+    }
+}
+
+/* write a call that allocates a copy of the string */
+static void emit_heap_string(CEmitter *emitter, const char *string, size_t length) {
+    fputs("rael_string(", emitter->build);
+    emit_string_literal(emitter->build, string, length, 0);
+    fprintf(emitter->build, ", %zu)", length);
+}
+
+static void emit_heap_cstr(CEmitter *emitter, const char *string) {
+    emit_heap_string(emitter, string, strlen(string));
+}
+
+static bool expr_is_int_literal(struct Expr *expr) {
+    return expr->type == ExprTypeValue && expr->as_value->type == ValueTypeNumber &&
+           !expr->as_value->as_number.is_float;
+}
+
+static const char *arithmetic_operator(enum ExprType type) {
+    switch (type) {
+    case ExprTypeAdd: return "+";
+    case ExprTypeSub: return "-";
+    case ExprTypeMul: return "*";
+    // divisions and modulos have special cases, so the runtime does them
+    default: return NULL;
+    }
+}
+
+static const char *comparison_operator(enum ExprType type) {
+    switch (type) {
+    case ExprTypeEquals: return "==";
+    case ExprTypeNotEqual: return "!=";
+    case ExprTypeSmallerThan: return "<";
+    case ExprTypeBiggerThan: return ">";
+    case ExprTypeSmallerOrEqual: return "<=";
+    case ExprTypeBiggerOrEqual: return ">=";
+    default: return NULL;
+    }
+}
+
+/*
+ * write the evaluation function of an arithmetic expression, where its operation is inlined for ints.
+ * if the rhs is an int literal, it's inlined too and is only evaluated when the lhs isn't an int
+ */
+static void emit_arithmetic_eval(CEmitter *emitter, struct Expr *expr, size_t id) {
+    FILE *out = emitter->out;
+    const char *operator = arithmetic_operator(expr->type);
+
+    fprintf(out, "static RaelValue *rael_eval_%zu(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {\n", id);
+    fputs("    (void)can_explode;\n", out);
+    fputs("    RaelValue *lhs = expr_eval(interpreter, expr->lhs, true);\n", out);
+    if (operator && expr_is_int_literal(expr->rhs)) {
+        fputs("    RaelValue *rhs, *value;\n\n", out);
+        fputs("    if (lhs->type == &RaelNumberType && !((RaelNumberValue*)lhs)->is_float) {\n", out);
+        fprintf(out, "        value = number_newi(((RaelNumberValue*)lhs)->as_int %s %ldL);\n",
+                operator, (long)expr->rhs->as_value->as_number.as_int);
+        fputs("        value_deref(lhs);\n", out);
+        fputs("        return value;\n", out);
+        fputs("    }\n", out);
+        fputs("    rhs = expr_eval(interpreter, expr->rhs, true);\n", out);
+    } else {
+        fputs("    RaelValue *rhs = expr_eval(interpreter, expr->rhs, true);\n", out);
+        fputs("    RaelValue *value;\n\n", out);
+        if (operator) {
+            fputs("    if (lhs->type == &RaelNumberType && !((RaelNumberValue*)lhs)->is_float &&\n", out);
+            fputs("        rhs->type == &RaelNumberType && !((RaelNumberValue*)rhs)->is_float) {\n", out);
+            fprintf(out, "        value = number_newi(((RaelNumberValue*)lhs)->as_int %s ((RaelNumberValue*)rhs)->as_int);\n", operator);
+            fputs("        value_deref(lhs);\n", out);
+            fputs("        value_deref(rhs);\n", out);
+            fputs("        return value;\n", out);
+            fputs("    }\n", out);
+        }
+    }
+    fputs("    value = expr_eval_arithmetic(expr, lhs, rhs);\n", out);
+    fputs("    value_deref(lhs);\n", out);
+    fputs("    value_deref(rhs);\n", out);
+    fputs("    return value;\n", out);
+    fputs("}\n\n", out);
+}
+
+/* write the evaluation function of a comparison expression, like emit_arithmetic_eval */
+static void emit_comparison_eval(CEmitter *emitter, struct Expr *expr, size_t id) {
+    FILE *out = emitter->out;
+    const char *operator = comparison_operator(expr->type);
+
+    fprintf(out, "static RaelValue *rael_eval_%zu(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {\n", id);
+    fputs("    (void)can_explode;\n", out);
+    fputs("    RaelValue *lhs = expr_eval(interpreter, expr->lhs, true);\n", out);
+    if (expr_is_int_literal(expr->rhs)) {
+        fputs("    RaelValue *rhs, *value;\n", out);
+        fputs("    bool result;\n\n", out);
+        fputs("    if (lhs->type == &RaelNumberType && !((RaelNumberValue*)lhs)->is_float) {\n", out);
+        fprintf(out, "        result = ((RaelNumberValue*)lhs)->as_int %s %ldL;\n",
+                operator, (long)expr->rhs->as_value->as_number.as_int);
+        fputs("        value_deref(lhs);\n", out);
+        fputs("        return number_newi(result);\n", out);
+        fputs("    }\n", out);
+        fputs("    rhs = expr_eval(interpreter, expr->rhs, true);\n", out);
+    } else {
+        fputs("    RaelValue *rhs = expr_eval(interpreter, expr->rhs, true);\n", out);
+        fputs("    RaelValue *value;\n", out);
+        fputs("    bool result;\n\n", out);
+        fputs("    if (lhs->type == &RaelNumberType && !((RaelNumberValue*)lhs)->is_float &&\n", out);
+        fputs("        rhs->type == &RaelNumberType && !((RaelNumberValue*)rhs)->is_float) {\n", out);
+        fprintf(out, "        result = ((RaelNumberValue*)lhs)->as_int %s ((RaelNumberValue*)rhs)->as_int;\n", operator);
+        fputs("        value_deref(lhs);\n", out);
+        fputs("        value_deref(rhs);\n", out);
+        fputs("        return number_newi(result);\n", out);
+        fputs("    }\n", out);
+    }
+    fputs("    if (!(value = expr_eval_comparison(expr, lhs, rhs, &result)))\n", out);
+    fputs("        value = number_newi(result);\n", out);
+    fputs("    value_deref(lhs);\n", out);
+    fputs("    value_deref(rhs);\n", out);
+    fputs("    return value;\n", out);
+    fputs("}\n\n", out);
+}
+
+/* write the expressions of the list, and then the array of its entries. returns the id of the array */
+static size_t emit_exprlist(CEmitter *emitter, RaelExprList *list) {
+    size_t *ids = malloc(list->amount_exprs * sizeof(size_t));
+    size_t id;
+
+    for (size_t i = 0; i < list->amount_exprs; ++i)
+        ids[i] = emit_expr(emitter, list->exprs[i].expr);
+
+    id = emitter->next_id++;
+    if (list->amount_exprs == 0) {
+        fprintf(emitter->build, "    struct RaelExprListEntry *l%zu = NULL;\n", id);
+    } else {
+        fprintf(emitter->build, "    struct RaelExprListEntry *l%zu = malloc(%zu * sizeof(struct RaelExprListEntry));\n",
+                id, list->amount_exprs);
+    }
+    for (size_t i = 0; i < list->amount_exprs; ++i) {
+        fprintf(emitter->build, "    l%zu[%zu].expr = e%zu;\n", id, i, ids[i]);
+        fprintf(emitter->build, "    l%zu[%zu].start_state = ", id, i);
+        emit_state(emitter, list->exprs[i].start_state);
+        fputs(";\n", emitter->build);
+    }
+
+    free(ids);
+    return id;
+}
+
+/* write the value of a ExprTypeValue expression. returns its id */
+static size_t emit_value(CEmitter *emitter, struct ValueExpr *value) {
+    FILE *build = emitter->build;
+    size_t list_id = 0, block_id = 0, id;
+
+    switch (value->type) {
+    case ValueTypeRoutine:
+        block_id = emit_block(emitter, value->as_routine.block);
+        break;
+    case ValueTypeStack:
+        list_id = emit_exprlist(emitter, &value->as_stack.entries);
+        break;
+    default:
+        break;
+    }
+
+    id = emitter->next_id++;
+    switch (value->type) {
+    case ValueTypeVoid:
+        fprintf(build, "    struct ValueExpr *v%zu = value_expr_new(ValueTypeVoid);\n", id);
+        break;
+    case ValueTypeNumber: {
+        struct RaelHybridNumber number = value->as_number;
+
+        fprintf(build, "    struct ValueExpr *v%zu = value_expr_new(ValueTypeNumber);\n", id);
+        fprintf(build, "    v%zu->as_number.is_float = %s;\n", id, number.is_float ? "true" : "false");
+        if (!number.is_float)
+            fprintf(build, "    v%zu->as_number.as_int = %ldL;\n", id, (long)number.as_int);
+        else if (isinf(number.as_float))
+            fprintf(build, "    v%zu->as_number.as_float = HUGE_VAL;\n", id);
+        else
+            // hexadecimal floats are exact
+            fprintf(build, "    v%zu->as_number.as_float = %a;\n", id, (double)number.as_float);
+        break;
+    }
+    case ValueTypeString:
+        fprintf(build, "    struct ValueExpr *v%zu = value_expr_new(ValueTypeString);\n", id);
+        fprintf(build, "    v%zu->as_string.length = %zu;\n", id, value->as_string.length);
+        fprintf(build, "    v%zu->as_string.interned = NULL;\n", id);
+        // empty strings have no buffer, like in the parser
+        if (value->as_string.length == 0) {
+            fprintf(build, "    v%zu->as_string.source = NULL;\n", id);
+        } else {
+            fprintf(build, "    v%zu->as_string.source = ", id);
+            emit_heap_string(emitter, value->as_string.source, value->as_string.length);
+            fputs(";\n", build);
+        }
+        break;
+    case ValueTypeRoutine: {
+        struct ASTRoutineValue *routine = &value->as_routine;
+
+        fprintf(build, "    struct ValueExpr *v%zu = value_expr_new(ValueTypeRoutine);\n", id);
+        fprintf(build, "    v%zu->as_routine.amount_parameters = %zu;\n", id, routine->amount_parameters);
+        if (routine->amount_parameters == 0) {
+            fprintf(build, "    v%zu->as_routine.parameters = NULL;\n", id);
+        } else {
+            fprintf(build, "    v%zu->as_routine.parameters = malloc(%zu * sizeof(char*));\n", id, routine->amount_parameters);
+        }
+        for (size_t i = 0; i < routine->amount_parameters; ++i) {
+            fprintf(build, "    v%zu->as_routine.parameters[%zu] = ", id, i);
+            emit_heap_cstr(emitter, routine->parameters[i]);
+            fputs(";\n", build);
+        }
+        fprintf(build, "    v%zu->as_routine.block = b%zu;\n", id, block_id);
+        fprintf(build, "    v%zu->as_routine.is_generator = %s;\n", id, routine->is_generator ? "true" : "false");
+        break;
+    }
+    case ValueTypeStack:
+        fprintf(build, "    struct ValueExpr *v%zu = value_expr_new(ValueTypeStack);\n", id);
+        fprintf(build, "    v%zu->as_stack.entries.amount_exprs = %zu;\n", id, value->as_stack.entries.amount_exprs);
+        fprintf(build, "    v%zu->as_stack.entries.exprs = l%zu;\n", id, list_id);
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+
+    return id;
+}
+
+static size_t emit_expr(CEmitter *emitter, struct Expr *expr) {
+    FILE *build = emitter->build;
+    size_t child_ids[2] = {0, 0}, id;
+    size_t *case_list_ids = NULL, *case_block_ids = NULL;
+
+    // the children are written first, so they're defined when the expression is built
+    switch (expr->type) {
+    case ExprTypeValue:
+        child_ids[0] = emit_value(emitter, expr->as_value);
+        break;
+    case ExprTypeCall:
+        child_ids[0] = emit_expr(emitter, expr->as_call.callable_expr);
+        child_ids[1] = emit_exprlist(emitter, &expr->as_call.args);
+        break;
+    case ExprTypeKey:
+        break;
+    case ExprTypeAdd:
+    case ExprTypeSub:
+    case ExprTypeMul:
+    case ExprTypeDiv:
+    case ExprTypeMod:
+    case ExprTypeEquals:
+    case ExprTypeNotEqual:
+    case ExprTypeSmallerThan:
+    case ExprTypeBiggerThan:
+    case ExprTypeSmallerOrEqual:
+    case ExprTypeBiggerOrEqual:
+    case ExprTypeAt:
+    case ExprTypeRedirect:
+    case ExprTypeTo:
+    case ExprTypeAnd:
+    case ExprTypeOr:
+        child_ids[0] = emit_expr(emitter, expr->lhs);
+        child_ids[1] = emit_expr(emitter, expr->rhs);
+        break;
+    case ExprTypeSizeof:
+    case ExprTypeTypeof:
+    case ExprTypeGetString:
+    case ExprTypeNeg:
+    case ExprTypeNot:
+    case ExprTypeBlame:
+        if (expr->as_single)
+            child_ids[0] = emit_expr(emitter, expr->as_single);
+        break;
+    case ExprTypeSet:
+    case ExprTypeAddEqual:
+    case ExprTypeSubEqual:
+    case ExprTypeMulEqual:
+    case ExprTypeDivEqual:
+    case ExprTypeModEqual:
+        if (expr->as_set.set_type == SetTypeAtExpr)
+            child_ids[0] = emit_expr(emitter, expr->as_set.as_at);
+        else if (expr->as_set.set_type == SetTypeMember)
+            child_ids[0] = emit_expr(emitter, expr->as_set.as_member);
+        child_ids[1] = emit_expr(emitter, expr->as_set.expr);
+        break;
+    case ExprTypeMatch: {
+        struct MatchExpr *match = &expr->as_match;
+
+        child_ids[0] = emit_expr(emitter, match->match_against);
+        if (match->else_block)
+            child_ids[1] = emit_block(emitter, match->else_block);
+        case_list_ids = malloc(match->amount_cases * sizeof(size_t));
+        case_block_ids = malloc(match->amount_cases * sizeof(size_t));
+        for (size_t i = 0; i < match->amount_cases; ++i) {
+            case_list_ids[i] = emit_exprlist(emitter, &match->match_cases[i].match_exprs);
+            case_block_ids[i] = emit_block(emitter, match->match_cases[i].case_block);
+        }
+        break;
+    }
+    case ExprTypeGetMember:
+        child_ids[0] = emit_expr(emitter, expr->as_get_member.lhs);
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+
+    id = emitter->next_id++;
+    fprintf(build, "    struct Expr *e%zu = expr_new(%s);\n", id, expr_type_names[expr->type]);
+    fprintf(build, "    e%zu->state = ", id);
+    emit_state(emitter, expr->state);
+    fputs(";\n", build);
+
+    switch (expr->type) {
+    case ExprTypeValue:
+        fprintf(build, "    e%zu->as_value = v%zu;\n", id, child_ids[0]);
+        break;
+    case ExprTypeCall:
+        fprintf(build, "    e%zu->as_call.callable_expr = e%zu;\n", id, child_ids[0]);
+        fprintf(build, "    e%zu->as_call.args.amount_exprs = %zu;\n", id, expr->as_call.args.amount_exprs);
+        fprintf(build, "    e%zu->as_call.args.exprs = l%zu;\n", id, child_ids[1]);
+        break;
+    case ExprTypeKey:
+        fprintf(build, "    e%zu->as_key = ", id);
+        emit_heap_cstr(emitter, expr->as_key);
+        fputs(";\n", build);
+        break;
+    case ExprTypeAdd:
+    case ExprTypeSub:
+    case ExprTypeMul:
+    case ExprTypeDiv:
+    case ExprTypeMod:
+        fprintf(build, "    e%zu->lhs = e%zu;\n", id, child_ids[0]);
+        fprintf(build, "    e%zu->rhs = e%zu;\n", id, child_ids[1]);
+        fprintf(build, "    e%zu->eval = rael_eval_%zu;\n", id, id);
+        emit_arithmetic_eval(emitter, expr, id);
+        break;
+    case ExprTypeEquals:
+    case ExprTypeNotEqual:
+    case ExprTypeSmallerThan:
+    case ExprTypeBiggerThan:
+    case ExprTypeSmallerOrEqual:
+    case ExprTypeBiggerOrEqual:
+        fprintf(build, "    e%zu->lhs = e%zu;\n", id, child_ids[0]);
+        fprintf(build, "    e%zu->rhs = e%zu;\n", id, child_ids[1]);
+        fprintf(build, "    e%zu->eval = rael_eval_%zu;\n", id, id);
+        emit_comparison_eval(emitter, expr, id);
+        break;
+    case ExprTypeAt:
+    case ExprTypeRedirect:
+    case ExprTypeTo:
+    case ExprTypeAnd:
+    case ExprTypeOr:
+        fprintf(build, "    e%zu->lhs = e%zu;\n", id, child_ids[0]);
+        fprintf(build, "    e%zu->rhs = e%zu;\n", id, child_ids[1]);
+        break;
+    case ExprTypeSizeof:
+    case ExprTypeTypeof:
+    case ExprTypeGetString:
+    case ExprTypeNeg:
+    case ExprTypeNot:
+    case ExprTypeBlame:
+        if (expr->as_single)
+            fprintf(build, "    e%zu->as_single = e%zu;\n", id, child_ids[0]);
+        else
+            fprintf(build, "    e%zu->as_single = NULL;\n", id);
+        break;
+    case ExprTypeSet:
+    case ExprTypeAddEqual:
+    case ExprTypeSubEqual:
+    case ExprTypeMulEqual:
+    case ExprTypeDivEqual:
+    case ExprTypeModEqual:
+        switch (expr->as_set.set_type) {
+        case SetTypeKey:
+            fprintf(build, "    e%zu->as_set.set_type = SetTypeKey;\n", id);
+            fprintf(build, "    e%zu->as_set.as_key = ", id);
+            emit_heap_cstr(emitter, expr->as_set.as_key);
+            fputs(";\n", build);
+            break;
+        case SetTypeAtExpr:
+            fprintf(build, "    e%zu->as_set.set_type = SetTypeAtExpr;\n", id);
+            fprintf(build, "    e%zu->as_set.as_at = e%zu;\n", id, child_ids[0]);
+            break;
+        case SetTypeMember:
+            fprintf(build, "    e%zu->as_set.set_type = SetTypeMember;\n", id);
+            fprintf(build, "    e%zu->as_set.as_member = e%zu;\n", id, child_ids[0]);
+            break;
+        default:
+            RAEL_UNREACHABLE();
+        }
+        fprintf(build, "    e%zu->as_set.expr = e%zu;\n", id, child_ids[1]);
+        break;
+    case ExprTypeMatch: {
+        struct MatchExpr *match = &expr->as_match;
+
+        fprintf(build, "    e%zu->as_match.match_against = e%zu;\n", id, child_ids[0]);
+        fprintf(build, "    e%zu->as_match.amount_cases = %zu;\n", id, match->amount_cases);
+        if (match->amount_cases == 0) {
+            fprintf(build, "    e%zu->as_match.match_cases = NULL;\n", id);
+        } else {
+            fprintf(build, "    e%zu->as_match.match_cases = malloc(%zu * sizeof(struct MatchCase));\n", id, match->amount_cases);
+        }
+        for (size_t i = 0; i < match->amount_cases; ++i) {
+            fprintf(build, "    e%zu->as_match.match_cases[%zu].match_exprs.amount_exprs = %zu;\n",
+                    id, i, match->match_cases[i].match_exprs.amount_exprs);
+            fprintf(build, "    e%zu->as_match.match_cases[%zu].match_exprs.exprs = l%zu;\n", id, i, case_list_ids[i]);
+            fprintf(build, "    e%zu->as_match.match_cases[%zu].case_block = b%zu;\n", id, i, case_block_ids[i]);
+        }
+        if (match->else_block)
+            fprintf(build, "    e%zu->as_match.else_block = b%zu;\n", id, child_ids[1]);
+        else
+            fprintf(build, "    e%zu->as_match.else_block = NULL;\n", id);
+        free(case_list_ids);
+        free(case_block_ids);
+        break;
+    }
+    case ExprTypeGetMember:
+        fprintf(build, "    e%zu->as_get_member.lhs = e%zu;\n", id, child_ids[0]);
+        fprintf(build, "    e%zu->as_get_member.key = ", id);
+        emit_heap_cstr(emitter, expr->as_get_member.key);
+        fputs(";\n", build);
+        fprintf(build, "    e%zu->as_get_member.cache.map.version = 0;\n", id);
+        fprintf(build, "    e%zu->as_get_member.cache.map.node = NULL;\n", id);
+        fprintf(build, "    e%zu->as_get_member.cache.shape = NULL;\n", id);
+        fprintf(build, "    e%zu->as_get_member.cache.type = NULL;\n", id);
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+
+    return id;
+}
+
+/* write a reference to an optional expression, which is NULL if the expression doesn't exist */
+static void emit_optional_expr_ref(FILE *out, struct Expr *expr, size_t id) {
+    if (expr)
+        fprintf(out, "e%zu", id);
+    else
+        fputs("NULL", out);
+}
+
+static size_t emit_instruction(CEmitter *emitter, RaelInstruction *instruction) {
+    FILE *build = emitter->build;
+    RaelInstructionType *type = instruction->type;
+    size_t ids[4] = {0, 0, 0, 0}, id;
+
+    if (type == &RaelInstructionTypeLog || type == &RaelInstructionTypeShow) {
+        RaelCsvInstruction *inst = (RaelCsvInstruction*)instruction;
+
+        ids[0] = emit_exprlist(emitter, &inst->csv);
+        id = emitter->next_id++;
+        fprintf(build, "    RaelCsvInstruction *i%zu = RAEL_INSTRUCTION_NEW(%s, RaelCsvInstruction);\n",
+                id, type == &RaelInstructionTypeLog ? "RaelInstructionTypeLog" : "RaelInstructionTypeShow");
+        fprintf(build, "    i%zu->csv.amount_exprs = %zu;\n", id, inst->csv.amount_exprs);
+        fprintf(build, "    i%zu->csv.exprs = l%zu;\n", id, ids[0]);
+    } else if (type == &RaelInstructionTypeIf) {
+        struct IfInstructionInfo *info = &((RaelIfInstruction*)instruction)->info;
+
+        ids[0] = emit_expr(emitter, info->condition);
+        if (info->if_type == IfTypeBlock)
+            ids[1] = emit_block(emitter, info->if_block);
+        else
+            ids[1] = emit_instruction(emitter, info->if_instruction);
+        if (info->else_type == ElseTypeBlock)
+            ids[2] = emit_block(emitter, info->else_block);
+        else if (info->else_type == ElseTypeInstruction)
+            ids[2] = emit_instruction(emitter, info->else_instruction);
+
+        id = emitter->next_id++;
+        fprintf(build, "    RaelIfInstruction *i%zu = RAEL_INSTRUCTION_NEW(RaelInstructionTypeIf, RaelIfInstruction);\n", id);
+        fprintf(build, "    i%zu->info.condition = e%zu;\n", id, ids[0]);
+        if (info->if_type == IfTypeBlock) {
+            fprintf(build, "    i%zu->info.if_type = IfTypeBlock;\n", id);
+            fprintf(build, "    i%zu->info.if_block = b%zu;\n", id, ids[1]);
+        } else {
+            fprintf(build, "    i%zu->info.if_type = IfTypeInstruction;\n", id);
+            fprintf(build, "    i%zu->info.if_instruction = (RaelInstruction*)i%zu;\n", id, ids[1]);
+        }
+        switch (info->else_type) {
+        case ElseTypeNone:
+            fprintf(build, "    i%zu->info.else_type = ElseTypeNone;\n", id);
+            break;
+        case ElseTypeBlock:
+            fprintf(build, "    i%zu->info.else_type = ElseTypeBlock;\n", id);
+            fprintf(build, "    i%zu->info.else_block = b%zu;\n", id, ids[2]);
+            break;
+        case ElseTypeInstruction:
+            fprintf(build, "    i%zu->info.else_type = ElseTypeInstruction;\n", id);
+            fprintf(build, "    i%zu->info.else_instruction = (RaelInstruction*)i%zu;\n", id, ids[2]);
+            break;
+        default:
+            RAEL_UNREACHABLE();
+        }
+    } else if (type == &RaelInstructionTypeLoop) {
+        struct LoopInstructionInfo *info = &((RaelLoopInstruction*)instruction)->info;
+
+        switch (info->type) {
+        case LoopWhile:
+            ids[0] = emit_expr(emitter, info->while_condition);
+            break;
+        case LoopThrough:
+            ids[0] = emit_expr(emitter, info->iterate.expr);
+            if (info->iterate.secondary_condition)
+                ids[1] = emit_expr(emitter, info->iterate.secondary_condition);
+            break;
+        case LoopForever:
+            break;
+        default:
+            RAEL_UNREACHABLE();
+        }
+        ids[2] = emit_block(emitter, info->block);
+
+        id = emitter->next_id++;
+        fprintf(build, "    RaelLoopInstruction *i%zu = RAEL_INSTRUCTION_NEW(RaelInstructionTypeLoop, RaelLoopInstruction);\n", id);
+        switch (info->type) {
+        case LoopWhile:
+            fprintf(build, "    i%zu->info.type = LoopWhile;\n", id);
+            fprintf(build, "    i%zu->info.while_condition = e%zu;\n", id, ids[0]);
+            break;
+        case LoopThrough:
+            fprintf(build, "    i%zu->info.type = LoopThrough;\n", id);
+            fprintf(build, "    i%zu->info.iterate.key = ", id);
+            emit_heap_cstr(emitter, info->iterate.key);
+            fputs(";\n", build);
+            fprintf(build, "    i%zu->info.iterate.expr = e%zu;\n", id, ids[0]);
+            fprintf(build, "    i%zu->info.iterate.secondary_condition = ", id);
+            emit_optional_expr_ref(build, info->iterate.secondary_condition, ids[1]);
+            fputs(";\n", build);
+            break;
+        case LoopForever:
+            fprintf(build, "    i%zu->info.type = LoopForever;\n", id);
+            break;
+        default:
+            RAEL_UNREACHABLE();
+        }
+        fprintf(build, "    i%zu->info.block = b%zu;\n", id, ids[2]);
+        fprintf(build, "    jit_state_new(&i%zu->jit);\n", id);
+    } else if (type == &RaelInstructionTypePureExpr) {
+        ids[0] = emit_expr(emitter, ((RaelPureInstruction*)instruction)->expr);
+        id = emitter->next_id++;
+        fprintf(build, "    RaelPureInstruction *i%zu = RAEL_INSTRUCTION_NEW(RaelInstructionTypePureExpr, RaelPureInstruction);\n", id);
+        fprintf(build, "    i%zu->expr = e%zu;\n", id, ids[0]);
+    } else if (type == &RaelInstructionTypeReturn) {
+        RaelReturnInstruction *inst = (RaelReturnInstruction*)instruction;
+
+        if (inst->return_expr)
+            ids[0] = emit_expr(emitter, inst->return_expr);
+        id = emitter->next_id++;
+        fprintf(build, "    RaelReturnInstruction *i%zu = RAEL_INSTRUCTION_NEW(RaelInstructionTypeReturn, RaelReturnInstruction);\n", id);
+        fprintf(build, "    i%zu->return_expr = ", id);
+        emit_optional_expr_ref(build, inst->return_expr, ids[0]);
+        fputs(";\n", build);
+        fprintf(build, "    i%zu->is_tail_call = %s;\n", id, inst->is_tail_call ? "true" : "false");
+    } else if (type == &RaelInstructionTypeBreak || type == &RaelInstructionTypeSkip) {
+        id = emitter->next_id++;
+        fprintf(build, "    RaelInstruction *i%zu = RAEL_INSTRUCTION_NEW(%s, RaelInstruction);\n",
+                id, type == &RaelInstructionTypeBreak ? "RaelInstructionTypeBreak" : "RaelInstructionTypeSkip");
+    } else if (type == &RaelInstructionTypeCatch) {
+        RaelCatchInstruction *inst = (RaelCatchInstruction*)instruction;
+
+        ids[0] = emit_expr(emitter, inst->catch_expr);
+        ids[1] = emit_block(emitter, inst->handle_block);
+        if (inst->else_block)
+            ids[2] = emit_block(emitter, inst->else_block);
+        id = emitter->next_id++;
+        fprintf(build, "    RaelCatchInstruction *i%zu = RAEL_INSTRUCTION_NEW(RaelInstructionTypeCatch, RaelCatchInstruction);\n", id);
+        fprintf(build, "    i%zu->catch_expr = e%zu;\n", id, ids[0]);
+        fprintf(build, "    i%zu->handle_block = b%zu;\n", id, ids[1]);
+        if (inst->else_block)
+            fprintf(build, "    i%zu->else_block = b%zu;\n", id, ids[2]);
+        else
+            fprintf(build, "    i%zu->else_block = NULL;\n", id);
+        fprintf(build, "    i%zu->value_key = ", id);
+        if (inst->value_key)
+            emit_heap_cstr(emitter, inst->value_key);
+        else
+            fputs("NULL", build);
+        fputs(";\n", build);
+    } else if (type == &RaelInstructionTypeLoad) {
+        id = emitter->next_id++;
+        fprintf(build, "    RaelLoadInstruction *i%zu = RAEL_INSTRUCTION_NEW(RaelInstructionTypeLoad, RaelLoadInstruction);\n", id);
+        fprintf(build, "    i%zu->module_name = ", id);
+        emit_heap_cstr(emitter, ((RaelLoadInstruction*)instruction)->module_name);
+        fputs(";\n", build);
+    } else if (type == &RaelInstructionTypeYield) {
+        ids[0] = emit_expr(emitter, ((RaelYieldInstruction*)instruction)->yield_expr);
+        id = emitter->next_id++;
+        fprintf(build, "    RaelYieldInstruction *i%zu = RAEL_INSTRUCTION_NEW(RaelInstructionTypeYield, RaelYieldInstruction);\n", id);
+        fprintf(build, "    i%zu->yield_expr = e%zu;\n", id, ids[0]);
+    } else {
+        RAEL_UNREACHABLE();
+        return 0;
+    }
+
+    fprintf(build, "    ((RaelInstruction*)i%zu)->state = ", id);
+    emit_state(emitter, instruction->state);
+    fputs(";\n", build);
+    return id;
+}
+
+/* write the instructions of the block, and then the NULL terminated block itself. returns its id */
+static size_t emit_block(CEmitter *emitter, RaelInstruction **block) {
+    size_t amount = 0, *ids, id;
+
+    while (block[amount])
+        ++amount;
+
+    ids = malloc(amount * sizeof(size_t));
+    for (size_t i = 0; i < amount; ++i)
+        ids[i] = emit_instruction(emitter, block[i]);
+
+    id = emitter->next_id++;
+    fprintf(emitter->build, "    RaelInstruction **b%zu = malloc(%zu * sizeof(RaelInstruction*));\n", id, amount + 1);
+    for (size_t i = 0; i < amount; ++i)
+        fprintf(emitter->build, "    b%zu[%zu] = (RaelInstruction*)i%zu;\n", id, i, ids[i]);
+    fprintf(emitter->build, "    b%zu[%zu] = NULL;\n", id, amount);
+
+    free(ids);
+    return id;
+}
+
+bool rael_emit_c(FILE *out, RaelInstruction **program, RaelStream *stream) {
+    CEmitter emitter;
+    size_t program_id;
+    int c;
+
+    emitter.out = out;
+    emitter.stream = stream;
+    emitter.next_id = 0;
+    if (!(emitter.build = tmpfile()))
+        return false;
+
+    fputs("/* generated by rael --emit-c */\n", out);
+    fputs("#include \"rael.h\"\n\n", out);
+
+    // the source is kept for error messages, which show the lines that errors happened in
+    fputs("static char rael_source[] =\n    ", out);
+    emit_string_literal(out, stream->base, stream->length, 64);
+    fputs(";\n\n", out);
+
+    fputs("static RaelStream *rael_stream;\n\n", out);
+    fputs("static inline struct State rael_state(uint32_t offset) {\n", out);
+    fputs("    struct State state;\n", out);
+    fputs("    state.stream = rael_stream;\n", out);
+    fputs("    state.offset = offset;\n", out);
+    fputs("    return state;\n", out);
+    fputs("}\n\n", out);
+    fputs("static inline struct State rael_no_state(void) {\n", out);
+    fputs("    struct State state;\n", out);
+    fputs("    memset(&state, 0, sizeof(struct State));\n", out);
+    fputs("    return state;\n", out);
+    fputs("}\n\n", out);
+    fputs("static inline char *rael_string(const char *string, size_t length) {\n", out);
+    fputs("    char *copy = malloc((length + 1) * sizeof(char));\n", out);
+    fputs("    memcpy(copy, string, length * sizeof(char));\n", out);
+    fputs("    copy[length] = '\\0';\n", out);
+    fputs("    return copy;\n", out);
+    fputs("}\n\n", out);
+
+    // the evaluation functions are written to the output while the tree is written to the build file
+    program_id = emit_block(&emitter, program);
+
+    fputs("static RaelInstruction **rael_build_program(void) {\n", out);
+    rewind(emitter.build);
+    while ((c = fgetc(emitter.build)) != EOF)
+        fputc(c, out);
+    fclose(emitter.build);
+    fprintf(out, "    return b%zu;\n", program_id);
+    fputs("}\n\n", out);
+
+    fputs("int main(int argc, char **argv) {\n", out);
+    fputs("    RaelInstruction **program;\n", out);
+    fputs("    RaelInterpreter interpreter;\n\n", out);
+    fputs("    rael_stream = stream_new(rael_source, sizeof(rael_source) - 1, false, ", out);
+    if (stream->name)
+        emit_string_literal(out, stream->name, strlen(stream->name), 0);
+    else
+        fputs("NULL", out);
+    fputs(");\n", out);
+    fputs("    program = rael_build_program();\n", out);
+    fputs("    interpreter_construct(&interpreter, program, rael_stream, argv[0], argv + 1, (size_t)(argc - 1), false);\n", out);
+    fputs("    // the expressions that weren't compiled are evaluated with closures\n", out);
+    fputs("    interpreter.closures = true;\n", out);
+    fputs("    interpreter_interpret(&interpreter);\n", out);
+    fputs("    interpreter_destruct(&interpreter);\n", out);
+    fputs("    return 0;\n", out);
+    fputs("}\n", out);
+
+    return !ferror(out);
+}
@@ -0,0 +1,21 @@
+#ifndef RAEL_EMITC_H
+#define RAEL_EMITC_H
+
+#include "parser.h"
+#include "stream.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/*
+ * The C emitter compiles a parsed program ahead of time into a C file. The C file rebuilds the
+ * program's syntax tree without lexing or parsing it, and runs it with the runtime in build/librael.a.
+ * Arithmetic and comparison expressions get their own evaluation functions, where the operation and
+ * int literal operands are inlined, and the rest of the expressions are evaluated with closures.
+ * Dynamic features (like :System:Eval) still work, because the parser is a part of the runtime.
+ */
+
+/* write the C program to `out`. returns false if it couldn't be written */
+bool rael_emit_c(FILE *out, RaelInstruction **program, RaelStream *stream);
+
+#endif // RAEL_EMITC_H
@@ -19,6 +19,91 @@ RaelModuleDecl rael_module_declarations[] = {
     { "Encodings", module_encodings_new }
 };
 
+/* the amount of arguments in a chunk, unless a call needs more than that */
+#define ARGUMENT_CHUNK_CAPACITY 256
+
+void argument_stack_new(RaelArgumentStack *out) {
+    out->chunk = NULL;
+}
+
+void argument_stack_delete(RaelArgumentStack *stack) {
+    RaelArgumentChunk *chunk = stack->chunk, *next;
+
+    if (!chunk)
+        return;
+    // go to the first chunk, and free all of the chunks from there
+    while (chunk->prev)
+        chunk = chunk->prev;
+    for (; chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
+    }
+    stack->chunk = NULL;
+}
+
+/* empty the stack without freeing its chunks */
+static void argument_stack_reset(RaelArgumentStack *stack) {
+    if (!stack->chunk)
+        return;
+    for (RaelArgumentChunk *chunk = stack->chunk; chunk; chunk = chunk->next)
+        chunk->used = 0;
+    while (stack->chunk->prev) {
+        stack->chunk = stack->chunk->prev;
+        stack->chunk->used = 0;
+    }
+}
+
+static RaelArgumentChunk *argument_chunk_new(RaelArgumentChunk *prev, size_t capacity) {
+    RaelArgumentChunk *chunk = malloc(sizeof(RaelArgumentChunk) + capacity * sizeof(RaelArgument));
+
+    chunk->prev = prev;
+    chunk->next = NULL;
+    chunk->used = 0;
+    chunk->capacity = capacity;
+    return chunk;
+}
+
+void interpreter_push_arguments(RaelInterpreter* const interpreter, size_t amount, RaelArgumentList *out) {
+    RaelArgumentStack *stack = interpreter->arguments;
+    RaelArgumentChunk *chunk = stack->chunk;
+
+    if (!chunk) {
+        chunk = stack->chunk = argument_chunk_new(NULL, amount > ARGUMENT_CHUNK_CAPACITY ? amount : ARGUMENT_CHUNK_CAPACITY);
+    } else if (chunk->capacity - chunk->used < amount) {
+        // the arguments of a call are always in the same chunk, so move to the next chunk
+        if (chunk->next && chunk->next->capacity < amount) {
+            // the chunks after the top of the stack are empty
+            RaelArgumentStack rest = { chunk->next };
+            chunk->next->prev = NULL;
+            argument_stack_delete(&rest);
+            chunk->next = NULL;
+        }
+        if (!chunk->next)
+            chunk->next = argument_chunk_new(chunk, amount > ARGUMENT_CHUNK_CAPACITY ? amount : ARGUMENT_CHUNK_CAPACITY);
+        chunk = stack->chunk = chunk->next;
+    }
+
+    out->arguments = &chunk->arguments[chunk->used];
+    out->amount_arguments = 0;
+    out->amount_allocated = amount;
+    chunk->used += amount;
+}
+
+void interpreter_pop_arguments(RaelInterpreter* const interpreter, RaelArgumentList *args) {
+    RaelArgumentStack *stack = interpreter->arguments;
+
+    for (size_t i = 0; i < args->amount_arguments; ++i)
+        value_deref(args->arguments[i].value);
+    if (args->amount_allocated == 0)
+        return;
+
+    // the arguments must be at the top of the stack
+    assert(args->arguments + args->amount_allocated == &stack->chunk->arguments[stack->chunk->used]);
+    stack->chunk->used -= args->amount_allocated;
+    if (stack->chunk->used == 0 && stack->chunk->prev)
+        stack->chunk = stack->chunk->prev;
+}
+
 void interpreter_push_scope(RaelInterpreter* const interpreter) {
     struct Scope *new_scope = scope_new(interpreter->instance->scope);
     interpreter->instance->scope = new_scope;
@@ -77,6 +162,8 @@ RaelInstance *instance_new(RaelInstance *previous_instance, RaelStream *stream,
     instance->instructions = instructions;
     instance->interrupt = ProgramInterruptNone;
     instance->returned_value = NULL;
+    instance->tail_callable = NULL;
+    instance->borrowed = false;
     instance->inherit_scope = scope ? true : false;
     instance->scope = scope ? scope : scope_new(NULL);
     instance->stream = stream;
@@ -110,6 +197,7 @@ void instance_delete(RaelInstance *instance) {
 
 /* Add an existing instance to the top of the interpreter */
 void interpreter_push_instance(RaelInterpreter* const interpreter, RaelInstance *instance) {
+    instance->borrowed = true;
     instance->prev = interpreter->instance;
     interpreter->instance = instance;
 }
@@ -152,12 +240,25 @@ void interpreter_construct(RaelInterpreter *out, RaelInstruction **instructions,
 
     out->main_stream = stream;
     out->instance = NULL;
+    out->generator = NULL;
 
-    // seed the random number generator
-    srand(seed);
+    // seed the random number generator (splitmix64, so that even a zero seed gives a usable state)
     out->seed = seed;
-
+    out->random_state = (uint64_t)seed + 0x9E3779B97F4A7C15ULL;
+    out->random_state = (out->random_state ^ (out->random_state >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    out->random_state = (out->random_state ^ (out->random_state >> 27)) * 0x94D049BB133111EBULL;
+    out->random_state ^= out->random_state >> 31;
+    if (out->random_state == 0)
+        out->random_state = 1;
+
+    argument_stack_new(&out->main_arguments);
+    out->arguments = &out->main_arguments;
+
+    out->exit_handler = NULL;
+    out->exit_code = 0;
     out->warn_undefined = warn_undefined;
+    out->closures = false;
+    out->jit = false;
 
     // create a new instance
     interpreter_new_instance(out, stream, instructions, false, false);
@@ -168,6 +269,9 @@ void interpreter_destruct(RaelInterpreter* const interpreter) {
     // deallocate all of the scopes
     while (interpreter->instance)
         interpreter_delete_instance(interpreter);
+    argument_stack_delete(&interpreter->main_arguments);
+    scope_free_pool();
+    varmap_free_pool();
 }
 
 /* make the interpreter run its instructions */
@@ -183,13 +287,72 @@ void interpreter_interpret(RaelInterpreter *interpreter) {
     instance->idx = 0;
 }
 
+/* xorshift64* generator. Every interpreter has its own state, so interpreters don't affect each other */
+uint64_t interpreter_random(RaelInterpreter* const interpreter) {
+    uint64_t x = interpreter->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    interpreter->random_state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * stop running the program with an exit code. if the interpreter has an exit handler
+ * (e.g when it's embedded), jump to it instead of exiting the process
+ */
+void interpreter_exit(RaelInterpreter* const interpreter, int exit_code) {
+    if (interpreter->exit_handler) {
+        interpreter->exit_code = exit_code;
+        longjmp(*interpreter->exit_handler, 1);
+    }
+    interpreter_destruct(interpreter);
+    exit(exit_code);
+}
+
+/*
+ * return the interpreter to a known state after jumping to its exit handler.
+ * instances above `instance` are removed, and `instance`'s scope is reset to `scope`.
+ * values that were in use by the aborted evaluation are leaked
+ */
+void interpreter_recover(RaelInterpreter* const interpreter, RaelInstance *instance, struct Scope *scope) {
+    struct Scope *ancestor;
+
+    while (interpreter->instance != instance) {
+        // borrowed instances are deleted by the values that own them
+        if (interpreter->instance->borrowed)
+            interpreter_pop_instance(interpreter);
+        else
+            interpreter_delete_instance(interpreter);
+    }
+
+    // pop the scopes that were pushed on top of the scope, if it's still in the scope chain
+    for (ancestor = instance->scope; ancestor && ancestor != scope; ancestor = ancestor->parent)
+        ;
+    if (ancestor) {
+        while (instance->scope != scope)
+            interpreter_pop_scope(interpreter);
+    } else {
+        instance->scope = scope;
+    }
+
+    instance->interrupt = ProgramInterruptNone;
+    instance->returned_value = NULL;
+    instance->tail_callable = NULL;
+    instance->idx = 0;
+    // a generator that was stopped by the error can't be resumed
+    interpreter->generator = NULL;
+    // nothing uses the arguments that were pushed before the error
+    interpreter->arguments = &interpreter->main_arguments;
+    argument_stack_reset(&interpreter->main_arguments);
+}
+
 void interpreter_error(RaelInterpreter* const interpreter, struct State state, const char* const error_message, ...) {
     va_list va;
     va_start(va, error_message);
     rael_show_error_message(interpreter->instance->stream->name, state, error_message, va);
     va_end(va);
-    interpreter_destruct(interpreter);
-    exit(1);
+    interpreter_exit(interpreter, 1);
 }
 
 static RaelValue *rael_readline(RaelInterpreter* const interpreter, struct State state) {
@@ -213,6 +376,18 @@ static RaelValue *rael_readline(RaelInterpreter* const interpreter, struct State
     return string_new_pure(string, allocated, true);
 }
 
+/* string literals are interned, so evaluating them doesn't allocate and they are compared by pointer */
+static RaelValue *string_literal_eval(struct ASTStringValue *string) {
+    RaelValue *interned = __atomic_load_n(&string->interned, __ATOMIC_ACQUIRE);
+
+    if (!interned) {
+        // interning the same contents always returns the same value, so threads can race here
+        interned = string_intern(string->source, string->length);
+        __atomic_store_n(&string->interned, interned, __ATOMIC_RELEASE);
+    }
+    return interned;
+}
+
 static RaelValue *value_eval(RaelInterpreter* const interpreter, struct ValueExpr *value) {
     RaelValue *out_value;
 
@@ -225,27 +400,27 @@ static RaelValue *value_eval(RaelInterpreter* const interpreter, struct ValueExp
         }
         break;
     case ValueTypeString:
-        out_value = string_new_pure(
-            value->as_string.source,
-            value->as_string.length,
-            false // flags not to deallocate string, because there is still a reference in the ast
-        );
+        out_value = string_literal_eval(&value->as_string);
         break;
     case ValueTypeRoutine: {
         const struct ASTRoutineValue ast_routine = value->as_routine;
         RaelRoutineValue *new_routine = RAEL_VALUE_NEW(RaelRoutineType, RaelRoutineValue);
+        size_t block_length;
 
-        // reference the block
-        for (size_t i = 0; ast_routine.block[i]; ++i)
-            instruction_ref(ast_routine.block[i]);
+        // copy and reference the block, so the routine can outlive the ast it was defined in
+        for (block_length = 0; ast_routine.block[block_length]; ++block_length)
+            instruction_ref(ast_routine.block[block_length]);
+        new_routine->block = malloc((block_length + 1) * sizeof(RaelInstruction*));
+        memcpy(new_routine->block, ast_routine.block, (block_length + 1) * sizeof(RaelInstruction*));
 
         // copy parameters
         new_routine->parameters = malloc(ast_routine.amount_parameters * sizeof(char*));
         for (size_t i = 0; i < ast_routine.amount_parameters; ++i)
             new_routine->parameters[i] = rael_cstr_duplicate(ast_routine.parameters[i]);
 
-        new_routine->block = ast_routine.block;
         new_routine->amount_parameters = ast_routine.amount_parameters;
+        new_routine->is_generator = ast_routine.is_generator;
+        jit_state_new(&new_routine->jit);
         new_routine->scope = interpreter->instance->scope;
 
         scope_ref(new_routine->scope);
@@ -311,6 +486,25 @@ static RaelValue *value_verify_uint(RaelValue *number, struct State number_state
     return blame;
 }
 
+/*
+ * returns an unshared copy of a shared string that a key is set on. if the string is stored in a variable,
+ * the variable stores the copy instead, so the key stays on the variable's string like on any other string
+ */
+static RaelValue *unshare_variable(RaelInterpreter* const interpreter, struct Expr *expr, RaelStringValue *string) {
+    RaelValue *copy = string_new_unshared(string);
+
+    if (expr->type == ExprTypeKey) {
+        RaelValue **variable = scope_get_ptr(interpreter->instance->scope, expr->as_key);
+
+        // shared strings are immortal, so the variable's reference doesn't need to be dropped
+        if (variable && *variable == (RaelValue*)string) {
+            value_ref(copy);
+            *variable = copy;
+        }
+    }
+    return copy;
+}
+
 static RaelValue *eval_stack_set(RaelInterpreter* const interpreter, struct Expr *at_expr, struct Expr *value_expr) {
     RaelValue *stack;
     RaelValue *idx;
@@ -330,18 +524,18 @@ static RaelValue *eval_stack_set(RaelInterpreter* const interpreter, struct Expr
         value_deref(idx);
         return value;
     }
-    // evaluate the rhs of the setting expression
+    // evaluate the rhs of the setting expression. the stack takes its own reference, and this one is returned
     value = expr_eval(interpreter, value_expr, true);
 
     // if you were out of range
     if (!stack_set((RaelStackValue*)stack, (size_t)number_to_int((RaelNumberValue*)idx), value)) {
         value_deref(stack);
         value_deref(idx);
+        value_deref(value);
         return BLAME_NEW_CSTR_ST("Index too big", at_expr->rhs->state);
     }
     value_deref(stack);
     value_deref(idx);
-    value_ref(value);
     return value;
 }
 
@@ -349,7 +543,7 @@ static RaelValue *eval_at_operation_set(RaelInterpreter* const interpreter, stru
                                         RaelBinaryOperationFunction operation, struct State operator_state) {
     RaelValue *stack;
     RaelValue *idx;
-    RaelValue **value_ptr;
+    RaelValue *element;
     RaelValue *result;
     RaelValue *value;
 
@@ -366,13 +560,13 @@ static RaelValue *eval_at_operation_set(RaelInterpreter* const interpreter, stru
         value_deref(idx);
         return result;
     }
-    value_ptr = stack_get_ptr((RaelStackValue*)stack, (size_t)number_to_int((RaelNumberValue*)idx));
 
     value = expr_eval(interpreter, value_expr, true);
 
     // if in range of stack
-    if (value_ptr) {
-        result = operation(*value_ptr, value);
+    if ((element = stack_get((RaelStackValue*)stack, (size_t)number_to_int((RaelNumberValue*)idx)))) {
+        result = operation(element, value);
+        value_deref(element);
         // if the operation failed, set the return value to be an error
         if (!result) {
             result = BLAME_NEW_CSTR("Invalid operation between values (types don't match)");
@@ -385,13 +579,8 @@ static RaelValue *eval_at_operation_set(RaelInterpreter* const interpreter, stru
     if (blame_validate(result)) {
         blame_set_state((RaelBlameValue*)result, operator_state);
     } else {
-        // besides the calculated value being returned from the expression, it is also set in the stack,
-        // so its refcount should be incremented
-        value_ref(result);
-        // dereference the old value in the stack
-        value_deref(*value_ptr);
-        // set the new value
-        *value_ptr = result;
+        // the calculated value is returned from the expression, and the stack takes its own reference
+        stack_set((RaelStackValue*)stack, (size_t)number_to_int((RaelNumberValue*)idx), result);
     }
 
     value_deref(stack);
@@ -448,7 +637,7 @@ static RaelValue *eval_get_member_operation_set(RaelInterpreter *interpreter, st
 
     get_member_lhs = expr_eval(interpreter, get_member->lhs, true);
     // try to get the pointer to the value you modify
-    lhs_ptr = varmap_get_ptr(&get_member_lhs->keys, get_member->key);
+    lhs_ptr = value_get_key_ptr(get_member_lhs, get_member->key);
     value_deref(get_member_lhs);
     // if there is a value at that key, get its value and do the operation
     if (lhs_ptr) {
@@ -543,198 +732,330 @@ static RaelValue *expr_match_eval(RaelInterpreter *interpreter, struct MatchExpr
     return return_value;
 }
 
-RaelValue *expr_eval(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
-    RaelValue *lhs;
-    RaelValue *rhs;
-    RaelValue *single;
+/*
+ * evaluate the arguments of a call. if `on_stack` is true they're pushed on the argument stack,
+ * and need to be removed with interpreter_pop_arguments
+ */
+static void eval_call_arguments(RaelInterpreter* const interpreter, RaelExprList *exprlist, RaelArgumentList *out,
+                                bool on_stack) {
+    if (on_stack)
+        interpreter_push_arguments(interpreter, exprlist->amount_exprs, out);
+    else
+        arguments_new(out, exprlist->amount_exprs);
+
+    for (size_t i = 0; i < exprlist->amount_exprs; ++i) {
+        struct RaelExprListEntry *entry = &exprlist->exprs[i];
+        RaelValue *arg_value = expr_eval(interpreter, entry->expr, true);
+        struct State arg_state = entry->start_state;
+
+        // add the argument
+        arguments_add(out, arg_value, arg_state);
+        value_deref(arg_value);
+    }
+}
+
+/* show the error of a blame that wasn't handled, and exit */
+static void interpreter_explode(RaelInterpreter* const interpreter, RaelBlameValue *blame) {
+    struct State state;
+    assert(blame->state_defined);
+    state = blame->original_place;
+
+    // remove preceding whitespace
+    while (state.stream->base[state.offset] == ' ' || state.stream->base[state.offset] == '\t') {
+        ++state.offset;
+    }
+
+    rael_show_error_tag(interpreter->instance->stream->name, state);
+    if (blame->message)
+        value_log(blame->message);
+    printf("\n");
+    rael_show_line_state(state);
+    // dereference the blame value
+    value_deref((RaelValue*)blame);
+    interpreter_exit(interpreter, 1);
+}
+
+/* returns the specialisation that fits two operands */
+static enum ExprQuickening quickening_from_operands(RaelValue *lhs, RaelValue *rhs) {
+    if (lhs->type == &RaelNumberType && rhs->type == &RaelNumberType) {
+        bool lhs_float = ((RaelNumberValue*)lhs)->is_float;
+        bool rhs_float = ((RaelNumberValue*)rhs)->is_float;
+
+        if (!lhs_float && !rhs_float)
+            return ExprQuickeningIntInt;
+        if (lhs_float && rhs_float)
+            return ExprQuickeningFloatFloat;
+    } else if (lhs->type == &RaelStringType && rhs->type == &RaelStringType) {
+        return ExprQuickeningStringString;
+    }
+    return ExprQuickeningGeneric;
+}
+
+/*
+ * specialise a binary expression by the first operands it sees, and check that later operands still fit.
+ * operands that don't fit turn the expression generic for good, so it doesn't keep switching
+ */
+static enum ExprQuickening expr_quicken(struct Expr *expr, RaelValue *lhs, RaelValue *rhs) {
+    enum ExprQuickening quickening;
+
+    if (expr->quickening == ExprQuickeningGeneric)
+        return ExprQuickeningGeneric;
+    quickening = quickening_from_operands(lhs, rhs);
+    if (expr->quickening == ExprQuickeningNone)
+        expr->quickening = quickening;
+    else if (expr->quickening != quickening)
+        expr->quickening = ExprQuickeningGeneric;
+    return expr->quickening;
+}
+
+/* do an arithmetic operation on two ints. returns NULL if there's no fast path for it */
+static RaelValue *quick_arithmetic_int(enum ExprType type, RaelInt a, RaelInt b) {
+    switch (type) {
+    case ExprTypeAdd: return number_newi(a + b);
+    case ExprTypeSub: return number_newi(a - b);
+    case ExprTypeMul: return number_newi(a * b);
+    // divisions with a remainder give a float
+    case ExprTypeDiv: return b != 0 && a % b == 0 ? number_newi(a / b) : NULL;
+    case ExprTypeMod: return b != 0 ? number_newi(((a % b) + b) % b) : NULL;
+    default: return NULL;
+    }
+}
+
+/* compare two ints with a comparison expression's operator */
+static bool quick_comparison_int(enum ExprType type, RaelInt a, RaelInt b) {
+    switch (type) {
+    case ExprTypeEquals: return a == b;
+    case ExprTypeNotEqual: return a != b;
+    case ExprTypeSmallerThan: return a < b;
+    case ExprTypeBiggerThan: return a > b;
+    case ExprTypeSmallerOrEqual: return a <= b;
+    case ExprTypeBiggerOrEqual: return a >= b;
+    default:
+        RAEL_UNREACHABLE();
+        return false;
+    }
+}
+
+/* do an arithmetic operation on operands that fit its specialisation. returns NULL if there's no fast path for it */
+static RaelValue *quick_arithmetic(enum ExprType type, enum ExprQuickening quickening, RaelValue *lhs, RaelValue *rhs) {
+    switch (quickening) {
+    case ExprQuickeningIntInt:
+        return quick_arithmetic_int(type, ((RaelNumberValue*)lhs)->as_int, ((RaelNumberValue*)rhs)->as_int);
+    case ExprQuickeningFloatFloat: {
+        RaelFloat a = ((RaelNumberValue*)lhs)->as_float, b = ((RaelNumberValue*)rhs)->as_float;
+
+        switch (type) {
+        case ExprTypeAdd: return number_newf(a + b);
+        case ExprTypeSub: return number_newf(a - b);
+        case ExprTypeMul: return number_newf(a * b);
+        case ExprTypeDiv: return b != 0.0 ? number_newf(a / b) : NULL;
+        case ExprTypeMod: return b != 0.0 ? number_newf(fmod(fmod(a, b) + b, b)) : NULL;
+        default: return NULL;
+        }
+    }
+    case ExprQuickeningStringString:
+        return type == ExprTypeAdd ? string_add((RaelStringValue*)lhs, rhs) : NULL;
+    default:
+        return NULL;
+    }
+}
+
+/* do a comparison on operands that fit its specialisation. returns false if there's no fast path for it */
+static bool quick_comparison(enum ExprType type, enum ExprQuickening quickening, RaelValue *lhs, RaelValue *rhs, bool *out) {
+    switch (quickening) {
+    case ExprQuickeningIntInt:
+        *out = quick_comparison_int(type, ((RaelNumberValue*)lhs)->as_int, ((RaelNumberValue*)rhs)->as_int);
+        return true;
+    case ExprQuickeningFloatFloat: {
+        RaelFloat a = ((RaelNumberValue*)lhs)->as_float, b = ((RaelNumberValue*)rhs)->as_float;
+
+        switch (type) {
+        case ExprTypeEquals: *out = a == b; return true;
+        case ExprTypeNotEqual: *out = a != b; return true;
+        case ExprTypeSmallerThan: *out = a < b; return true;
+        case ExprTypeBiggerThan: *out = a > b; return true;
+        case ExprTypeSmallerOrEqual: *out = a <= b; return true;
+        case ExprTypeBiggerOrEqual: *out = a >= b; return true;
+        default: return false;
+        }
+    }
+    default:
+        return false;
+    }
+}
+
+/* evaluate an arithmetic expression (+, -, *, /, %) on its evaluated operands */
+RaelValue *expr_eval_arithmetic(struct Expr *expr, RaelValue *lhs, RaelValue *rhs) {
     RaelValue *value;
 
+    if ((value = quick_arithmetic(expr->type, expr_quicken(expr, lhs, rhs), lhs, rhs)))
+        return value;
+
     switch (expr->type) {
-    case ExprTypeValue:
-        value = value_eval(interpreter, expr->as_value);
-        break;
-    case ExprTypeKey:
-        value = scope_get(interpreter->instance->scope, expr->as_key, interpreter->warn_undefined);
-        break;
     case ExprTypeAdd:
-        lhs = expr_eval(interpreter, expr->lhs, true);
-        rhs = expr_eval(interpreter, expr->rhs, true);
-
         // try to add the values
-        value = values_add(lhs, rhs);
-        if (!value) {
+        if (!(value = values_add(lhs, rhs)))
             value = BLAME_NEW_CSTR("Invalid operation (+) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
-        value_deref(lhs);
-        value_deref(rhs);
         break;
     case ExprTypeSub:
-        lhs = expr_eval(interpreter, expr->lhs, true);
-        rhs = expr_eval(interpreter, expr->rhs, true);
-        // try to add the values
-        value = values_sub(lhs, rhs);
-        if (!value) {
+        if (!(value = values_sub(lhs, rhs)))
             value = BLAME_NEW_CSTR("Invalid operation (-) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
-        value_deref(lhs);
-        value_deref(rhs);
         break;
     case ExprTypeMul:
-        lhs = expr_eval(interpreter, expr->lhs, true);
-        rhs = expr_eval(interpreter, expr->rhs, true);
-        // try to multiply the values
-        value = values_mul(lhs, rhs);
-        if (!value) {
+        if (!(value = values_mul(lhs, rhs)))
             value = BLAME_NEW_CSTR("Invalid operation (*) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
-        value_deref(lhs);
-        value_deref(rhs);
         break;
     case ExprTypeDiv:
-        lhs = expr_eval(interpreter, expr->lhs, true);
-        rhs = expr_eval(interpreter, expr->rhs, true);
-
-        // try to divide the values
-        value = values_div(lhs, rhs);
-        if (!value) {
+        if (!(value = values_div(lhs, rhs)))
             value = BLAME_NEW_CSTR("Invalid operation (/) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
-        value_deref(lhs);
-        value_deref(rhs);
         break;
     case ExprTypeMod:
-        lhs = expr_eval(interpreter, expr->lhs, true);
-        rhs = expr_eval(interpreter, expr->rhs, true);
-
-        // try to modulo the values
-        value = values_mod(lhs, rhs);
-        if (!value) {
+        if (!(value = values_mod(lhs, rhs)))
             value = BLAME_NEW_CSTR("Invalid operation (%) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
-        value_deref(lhs);
-        value_deref(rhs);
         break;
-    case ExprTypeEquals:
-        lhs = expr_eval(interpreter, expr->lhs, true);
-        rhs = expr_eval(interpreter, expr->rhs, true);
-
-        // create an integer from the boolean result of the comparison
-        value = number_newi(values_eq(lhs, rhs));
+    default:
+        RAEL_UNREACHABLE();
+        return NULL;
+    }
+    if (blame_validate(value))
+        blame_set_state((RaelBlameValue*)value, expr->state);
+    return value;
+}
 
-        value_deref(lhs);
-        value_deref(rhs);
-        break;
-    case ExprTypeNotEqual:
-        lhs = expr_eval(interpreter, expr->lhs, true);
-        rhs = expr_eval(interpreter, expr->rhs, true);
+/*
+ * evaluate a comparison expression on its evaluated operands.
+ * returns NULL and sets `out` to the result, or returns a blame if the operands can't be compared
+ */
+RaelValue *expr_eval_comparison(struct Expr *expr, RaelValue *lhs, RaelValue *rhs, bool *out) {
+    RaelValue *value;
 
-        // create an integer from the boolean result of the comparison
-        value = number_newi(!values_eq(lhs, rhs));
+    if (quick_comparison(expr->type, expr_quicken(expr, lhs, rhs), lhs, rhs, out))
+        return NULL;
 
-        value_deref(lhs);
-        value_deref(rhs);
-        break;
+    switch (expr->type) {
+    case ExprTypeEquals:
+        *out = values_eq(lhs, rhs);
+        return NULL;
+    case ExprTypeNotEqual:
+        *out = !values_eq(lhs, rhs);
+        return NULL;
     case ExprTypeSmallerThan:
-        lhs = expr_eval(interpreter, expr->lhs, true);
-        rhs = expr_eval(interpreter, expr->rhs, true);
-
         // try to compare
-        value = values_smaller(lhs, rhs);
-        if (!value) {
+        if (!(value = values_smaller(lhs, rhs)))
             value = BLAME_NEW_CSTR("Invalid operation (<) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
-        value_deref(lhs);
-        value_deref(rhs);
         break;
     case ExprTypeBiggerThan:
+        if (!(value = values_bigger(lhs, rhs)))
+            value = BLAME_NEW_CSTR("Invalid operation (>) on types");
+        break;
+    case ExprTypeSmallerOrEqual:
+        if (!(value = values_smaller_eq(lhs, rhs)))
+            value = BLAME_NEW_CSTR("Invalid operation (<=) on types");
+        break;
+    case ExprTypeBiggerOrEqual:
+        if (!(value = values_bigger_eq(lhs, rhs)))
+            value = BLAME_NEW_CSTR("Invalid operation (>=) on types");
+        break;
+    default:
+        RAEL_UNREACHABLE();
+        return NULL;
+    }
+    if (blame_validate(value)) {
+        blame_set_state((RaelBlameValue*)value, expr->state);
+        return value;
+    }
+    *out = value_truthy(value);
+    value_deref(value);
+    return NULL;
+}
+
+bool expr_eval_condition(RaelInterpreter* const interpreter, struct Expr* const expr) {
+    RaelValue *lhs, *rhs, *value;
+    bool result = false;
+
+    switch (expr->type) {
+    case ExprTypeEquals:
+    case ExprTypeNotEqual:
+    case ExprTypeSmallerThan:
+    case ExprTypeBiggerThan:
+    case ExprTypeSmallerOrEqual:
+    case ExprTypeBiggerOrEqual:
         lhs = expr_eval(interpreter, expr->lhs, true);
         rhs = expr_eval(interpreter, expr->rhs, true);
-
-        // try to compare
-        value = values_bigger(lhs, rhs);
-        if (!value) {
-            value = BLAME_NEW_CSTR("Invalid operation (>) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
+        value = expr_eval_comparison(expr, lhs, rhs, &result);
         value_deref(lhs);
         value_deref(rhs);
+        if (value)
+            interpreter_explode(interpreter, (RaelBlameValue*)value);
+        return result;
+    case ExprTypeAnd:
+        return expr_eval_condition(interpreter, expr->lhs) && expr_eval_condition(interpreter, expr->rhs);
+    case ExprTypeOr:
+        return expr_eval_condition(interpreter, expr->lhs) || expr_eval_condition(interpreter, expr->rhs);
+    case ExprTypeNot:
+        return !expr_eval_condition(interpreter, expr->lhs);
+    default:
+        value = expr_eval(interpreter, expr, true);
+        result = value_truthy(value);
+        value_deref(value);
+        return result;
+    }
+}
+
+/* evaluate an expression by walking its tree */
+static RaelValue *expr_eval_tree(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    RaelValue *lhs;
+    RaelValue *rhs;
+    RaelValue *single;
+    RaelValue *value;
+
+    switch (expr->type) {
+    case ExprTypeValue:
+        value = value_eval(interpreter, expr->as_value);
         break;
-    case ExprTypeSmallerOrEqual:
+    case ExprTypeKey:
+        value = scope_get(interpreter->instance->scope, expr->as_key, interpreter->warn_undefined);
+        break;
+    case ExprTypeAdd:
+    case ExprTypeSub:
+    case ExprTypeMul:
+    case ExprTypeDiv:
+    case ExprTypeMod:
         lhs = expr_eval(interpreter, expr->lhs, true);
         rhs = expr_eval(interpreter, expr->rhs, true);
-
-        // try to compare
-        value = values_smaller_eq(lhs, rhs);
-        if (!value) {
-            value = BLAME_NEW_CSTR("Invalid operation (<=) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
+        value = expr_eval_arithmetic(expr, lhs, rhs);
         value_deref(lhs);
         value_deref(rhs);
         break;
-    case ExprTypeBiggerOrEqual:
-        // eval lhs and rhs in lhs >= rhs
+    case ExprTypeEquals:
+    case ExprTypeNotEqual:
+    case ExprTypeSmallerThan:
+    case ExprTypeBiggerThan:
+    case ExprTypeSmallerOrEqual:
+    case ExprTypeBiggerOrEqual: {
+        bool result;
+
         lhs = expr_eval(interpreter, expr->lhs, true);
         rhs = expr_eval(interpreter, expr->rhs, true);
-        // try to compare
-        value = values_bigger_eq(lhs, rhs);
-        if (!value) {
-            value = BLAME_NEW_CSTR("Invalid operation (>=) on types");
-        }
-        if (blame_validate(value)) {
-            blame_set_state((RaelBlameValue*)value, expr->state);
-        }
+        // create an integer from the boolean result of the comparison, unless it's a blame
+        if (!(value = expr_eval_comparison(expr, lhs, rhs, &result)))
+            value = number_newi(result);
         value_deref(lhs);
         value_deref(rhs);
         break;
+    }
     case ExprTypeCall: {
         struct CallExpr call = expr->as_call;
         RaelValue *callable = expr_eval(interpreter, call.callable_expr, true);
         RaelArgumentList args;
 
         if (value_is_callable(callable)) {
-            RaelExprList *exprlist = &call.args;
-
-            // initialize args with a good overhead
-            arguments_new(&args, exprlist->amount_exprs);
-
-            for (size_t i = 0; i < exprlist->amount_exprs; ++i) {
-                struct RaelExprListEntry *entry = &exprlist->exprs[i];
-                RaelValue *arg_value = expr_eval(interpreter, entry->expr, true);
-                struct State arg_state = entry->start_state;
-
-                // add the argument
-                arguments_add(&args, arg_value, arg_state);
-                value_deref(arg_value);
-            }
-            arguments_finalize(&args); // finish
+            eval_call_arguments(interpreter, &call.args, &args, true);
 
             // call and remove arguments immediately afterwards
             value = value_call(callable, &args, interpreter);
             assert(value);
-            arguments_delete(&args);
+            interpreter_pop_arguments(interpreter, &args);
         } else {
             value = BLAME_NEW_CSTR("Tried to call a non-callable");
         }
@@ -880,10 +1201,16 @@ RaelValue *expr_eval(RaelInterpreter* const interpreter, struct Expr* const expr
 
             // get the value to put the member in
             lhs = expr_eval(interpreter, get_member.lhs, true);
+            // shared strings (literals and chars) can't have keys, so they're copied before they're given one
+            if (lhs->type == &RaelStringType && lhs->reference_count == RAEL_REFCOUNT_IMMORTAL)
+                lhs = unshare_variable(interpreter, get_member.lhs, (RaelStringValue*)lhs);
             // get the member's value
             value = expr_eval(interpreter, set.expr, true);
             // set the member
-            value_set_key(lhs, rael_cstr_duplicate(get_member.key), value);
+            if (!value_set_key(lhs, rael_cstr_duplicate(get_member.key), value)) {
+                value_deref(value);
+                value = BLAME_NEW_CSTR_ST("Can't set keys of a shared value", get_member.lhs->state);
+            }
 
             value_deref(lhs);
             break;
@@ -908,48 +1235,11 @@ RaelValue *expr_eval(RaelInterpreter* const interpreter, struct Expr* const expr
     case ExprTypeModEqual:
         value = eval_set_operation_expr(interpreter, &expr->as_set, expr->state, values_mod);
         break;
-    case ExprTypeAnd: {
-        int result = 0;
-        lhs = expr_eval(interpreter, expr->lhs, true);
-
-        if (value_truthy(lhs) == true) {
-            rhs = expr_eval(interpreter, expr->rhs, true);
-            result = value_truthy(rhs) == true;
-            value_deref(rhs);
-        }
-        value_deref(lhs);
-
-        value = number_newi(result);
-        break;
-    }
-    case ExprTypeOr: {
-        int result = 0;
-        lhs = expr_eval(interpreter, expr->lhs, true);
-
-        if (value_truthy(lhs) == true) {
-            result = 1;
-        } else {
-            rhs = expr_eval(interpreter, expr->rhs, true);
-            result = value_truthy(rhs) == true;
-            value_deref(rhs);
-        }
-        value_deref(lhs);
-
-        value = number_newi(result);
-        break;
-    }
-    case ExprTypeNot: {
-        bool negative;
-        // eval the inside of the '!' expr
-        single = expr_eval(interpreter, expr->lhs, true);
-        // take the opposite of the value's boolean representation
-        negative = !value_truthy(single);
-        // deallocate the now unused inside value
-        value_deref(single);
-        // create a new number value from the opposite of `single`
-        value = number_newi(negative);
+    case ExprTypeAnd:
+    case ExprTypeOr:
+    case ExprTypeNot:
+        value = number_newi(expr_eval_condition(interpreter, expr));
         break;
-    }
     case ExprTypeTypeof: {
         RaelValue *val = expr_eval(interpreter, expr->as_single, true);
         value = (RaelValue*)val->type;
@@ -969,37 +1259,182 @@ RaelValue *expr_eval(RaelInterpreter* const interpreter, struct Expr* const expr
     case ExprTypeGetMember:
         lhs = expr_eval(interpreter, expr->as_get_member.lhs, true);
         // get key from value
-        value = value_get_key(lhs, expr->as_get_member.key, interpreter);
+        value = value_get_key(lhs, expr->as_get_member.key, &expr->as_get_member.cache, interpreter);
         value_deref(lhs);
         break;
     default:
         RAEL_UNREACHABLE();
     }
 
-    if (can_explode && blame_validate(value)) {
-        // explode (error)
-        RaelBlameValue *blame = (RaelBlameValue*)value;
-        struct State state;
-        assert(blame->state_defined);
-        state = blame->original_place;
+    return value;
+}
+
+/*
+ * Closure compilation.
+ *
+ * When the interpreter runs with closures enabled, every expression is given an evaluation function
+ * the first time it's evaluated, which is chosen by the shape of the expression (for example
+ * "a variable plus an int literal"). Later evaluations call that function directly instead of going
+ * through the switch of expr_eval_tree. Expressions without a specialised function use expr_eval_tree.
+ */
+
+static RaelValue *closure_int_literal(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)interpreter;
+    (void)can_explode;
+    return number_newi(expr->as_value->as_number.as_int);
+}
+
+static RaelValue *closure_float_literal(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)interpreter;
+    (void)can_explode;
+    return number_newf(expr->as_value->as_number.as_float);
+}
+
+static RaelValue *closure_string_literal(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)interpreter;
+    (void)can_explode;
+    return string_literal_eval(&expr->as_value->as_string);
+}
+
+static RaelValue *closure_key(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)can_explode;
+    return scope_get(interpreter->instance->scope, expr->as_key, interpreter->warn_undefined);
+}
+
+static RaelValue *closure_arithmetic(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)can_explode;
+    RaelValue *lhs = expr_eval(interpreter, expr->lhs, true);
+    RaelValue *rhs = expr_eval(interpreter, expr->rhs, true);
+    RaelValue *value = expr_eval_arithmetic(expr, lhs, rhs);
+
+    value_deref(lhs);
+    value_deref(rhs);
+    return value;
+}
+
+/* an arithmetic operation whose rhs is an int literal */
+static RaelValue *closure_arithmetic_int_literal(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)can_explode;
+    RaelValue *lhs = expr_eval(interpreter, expr->lhs, true);
+    RaelValue *rhs, *value;
 
-        // remove preceding whitespace
-        while (state.stream_pos.cur[0] == ' ' || state.stream_pos.cur[0] == '\t') {
-            ++state.column;
-            ++state.stream_pos.cur;
+    if (lhs->type == &RaelNumberType && !((RaelNumberValue*)lhs)->is_float &&
+        (value = quick_arithmetic_int(expr->type, ((RaelNumberValue*)lhs)->as_int, expr->rhs->as_value->as_number.as_int))) {
+        value_deref(lhs);
+        return value;
+    }
+    rhs = expr_eval(interpreter, expr->rhs, true);
+    value = expr_eval_arithmetic(expr, lhs, rhs);
+    value_deref(lhs);
+    value_deref(rhs);
+    return value;
+}
+
+static RaelValue *closure_comparison(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)can_explode;
+    RaelValue *lhs = expr_eval(interpreter, expr->lhs, true);
+    RaelValue *rhs = expr_eval(interpreter, expr->rhs, true);
+    RaelValue *value;
+    bool result;
+
+    if (!(value = expr_eval_comparison(expr, lhs, rhs, &result)))
+        value = number_newi(result);
+    value_deref(lhs);
+    value_deref(rhs);
+    return value;
+}
+
+/* a comparison whose rhs is an int literal */
+static RaelValue *closure_comparison_int_literal(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)can_explode;
+    RaelValue *lhs = expr_eval(interpreter, expr->lhs, true);
+    RaelValue *rhs, *value;
+    bool result;
+
+    if (lhs->type == &RaelNumberType && !((RaelNumberValue*)lhs)->is_float) {
+        result = quick_comparison_int(expr->type, ((RaelNumberValue*)lhs)->as_int, expr->rhs->as_value->as_number.as_int);
+        value_deref(lhs);
+        return number_newi(result);
+    }
+    rhs = expr_eval(interpreter, expr->rhs, true);
+    if (!(value = expr_eval_comparison(expr, lhs, rhs, &result)))
+        value = number_newi(result);
+    value_deref(lhs);
+    value_deref(rhs);
+    return value;
+}
+
+static RaelValue *closure_condition(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)can_explode;
+    return number_newi(expr_eval_condition(interpreter, expr));
+}
+
+static RaelValue *closure_get_member(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    (void)can_explode;
+    RaelValue *lhs = expr_eval(interpreter, expr->as_get_member.lhs, true);
+    RaelValue *value = value_get_key(lhs, expr->as_get_member.key, &expr->as_get_member.cache, interpreter);
+
+    value_deref(lhs);
+    return value;
+}
+
+static bool expr_is_int_literal(struct Expr *expr) {
+    return expr->type == ExprTypeValue && expr->as_value->type == ValueTypeNumber && !expr->as_value->as_number.is_float;
+}
+
+/* choose the evaluation function of an expression */
+static RaelExprEvalFunc expr_compile(struct Expr *expr) {
+    switch (expr->type) {
+    case ExprTypeValue:
+        switch (expr->as_value->type) {
+        case ValueTypeNumber:
+            return expr->as_value->as_number.is_float ? closure_float_literal : closure_int_literal;
+        case ValueTypeString:
+            return closure_string_literal;
+        default:
+            return expr_eval_tree;
         }
+    case ExprTypeKey:
+        return closure_key;
+    case ExprTypeAdd:
+    case ExprTypeSub:
+    case ExprTypeMul:
+    case ExprTypeDiv:
+    case ExprTypeMod:
+        return expr_is_int_literal(expr->rhs) ? closure_arithmetic_int_literal : closure_arithmetic;
+    case ExprTypeEquals:
+    case ExprTypeNotEqual:
+    case ExprTypeSmallerThan:
+    case ExprTypeBiggerThan:
+    case ExprTypeSmallerOrEqual:
+    case ExprTypeBiggerOrEqual:
+        return expr_is_int_literal(expr->rhs) ? closure_comparison_int_literal : closure_comparison;
+    case ExprTypeAnd:
+    case ExprTypeOr:
+    case ExprTypeNot:
+        return closure_condition;
+    case ExprTypeGetMember:
+        return closure_get_member;
+    default:
+        return expr_eval_tree;
+    }
+}
 
-        rael_show_error_tag(interpreter->instance->stream->name, state);
-        if (blame->message)
-            value_log(blame->message);
-        printf("\n");
-        rael_show_line_state(state);
-        // dereference the blame value
-        value_deref(value);
-        interpreter_destruct(interpreter);
-        exit(1);
+RaelValue *expr_eval(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode) {
+    RaelValue *value;
+
+    if (expr->eval) {
+        value = expr->eval(interpreter, expr, can_explode);
+    } else if (interpreter->closures) {
+        expr->eval = expr_compile(expr);
+        value = expr->eval(interpreter, expr, can_explode);
+    } else {
+        value = expr_eval_tree(interpreter, expr, can_explode);
     }
 
+    if (can_explode && blame_validate(value))
+        interpreter_explode(interpreter, (RaelBlameValue*)value);
+
     return value;
 }
 
@@ -1015,17 +1450,54 @@ void block_run(RaelInterpreter* const interpreter, RaelInstruction **block, bool
         interpreter_pop_scope(interpreter);
 }
 
+/* if there is a secondary loop condition, return whether it is truthy */
+static bool loop_through_check_condition(RaelInterpreter *interpreter, RaelLoopInstruction *inst) {
+    struct Expr *secondary_condition = inst->info.iterate.secondary_condition;
+
+    if (!secondary_condition)
+        return true;
+    return expr_eval_condition(interpreter, secondary_condition);
+}
+
+/* run the block of a loop through with an iteration value, and return whether the loop should continue */
+static bool loop_through_run_iteration(RaelInterpreter *interpreter, RaelLoopInstruction *inst, RaelValue *iteration_value) {
+    bool continue_loop = true;
+
+    // push the new scope
+    interpreter_push_scope(interpreter);
+
+    // set the iteration value and deref, because the value is already referenced in scope_set_local
+    scope_set_local(interpreter->instance->scope, rael_cstr_duplicate(inst->info.iterate.key), iteration_value, true);
+    value_deref(iteration_value);
+
+    // run the block of code
+    jit_block_run(interpreter, &inst->jit, inst->info.block);
+
+    // check for program interrupts
+    if (interpreter->instance->interrupt == ProgramInterruptBreak) {
+        interpreter->instance->interrupt = ProgramInterruptNone;
+        continue_loop = false;
+    } else if (interpreter->instance->interrupt == ProgramInterruptReturn) {
+        continue_loop = false;
+    } else if (interpreter->instance->interrupt == ProgramInterruptSkip) {
+        interpreter->instance->interrupt = ProgramInterruptNone;
+    }
+    interpreter_pop_scope(interpreter);
+
+    return continue_loop;
+}
+
 void interpreter_interpret_inst_loop(RaelInterpreter *interpreter, RaelLoopInstruction *inst) {
     switch (inst->info.type) {
     case LoopWhile: {
         bool continue_loop;
         do {
-            RaelValue *condition;
+            // a hot loop is compiled as a whole, and the compiled loop runs the rest of the iterations
+            if (jit_loop_run(interpreter, &inst->jit, (RaelInstruction*)inst))
+                break;
             interpreter_push_scope(interpreter);
 
-            condition = expr_eval(interpreter, inst->info.while_condition, true);
-            continue_loop = value_truthy(condition);
-            value_deref(condition);
+            continue_loop = expr_eval_condition(interpreter, inst->info.while_condition);
             // if you can inst, run the block
             if (continue_loop) {
                 block_run(interpreter, inst->info.block, false);
@@ -1045,54 +1517,42 @@ void interpreter_interpret_inst_loop(RaelInterpreter *interpreter, RaelLoopInstr
     case LoopThrough: {
         bool continue_loop = true;
         RaelValue *iterator = expr_eval(interpreter, inst->info.iterate.expr, true);
-        struct Expr *secondary_condition = inst->info.iterate.secondary_condition;
-
-        if (!value_is_iterable(iterator)) {
-            value_deref(iterator);
-            interpreter_error(interpreter, inst->info.iterate.expr->state, "Expected an iterable");
-        }
-
-        // calculate length every time because values can always shrink/grow
-        for (size_t i = 0; continue_loop && i < value_length(iterator); ++i) {
-            RaelValue *iteration_value;
 
-            // if there is a secondary loop condition, exit the loop
-            if (secondary_condition) {
-                RaelValue *secondary = expr_eval(interpreter, secondary_condition, true);
-                bool is_truthy = value_truthy(secondary);
-                value_deref(secondary);
-                if (!is_truthy)
+        if (value_is_iterable(iterator)) {
+            // calculate length every time because values can always shrink/grow
+            for (size_t i = 0; continue_loop && i < value_length(iterator); ++i) {
+                if (!loop_through_check_condition(interpreter, inst))
                     break;
+                continue_loop = loop_through_run_iteration(interpreter, inst, value_get(iterator, i));
             }
-
-            // push the new scope and calculate the iterated value
-            interpreter_push_scope(interpreter);
-            iteration_value = value_get(iterator, i);
-
-            // set the iteration value and deref, because the value is already referenced in scope_set_local
-            scope_set_local(interpreter->instance->scope, rael_cstr_duplicate(inst->info.iterate.key), iteration_value, true);
-            value_deref(iteration_value);
-
-            // run the block of code
-            block_run(interpreter, inst->info.block, false);
-
-            // check for program interrupts
-            if (interpreter->instance->interrupt == ProgramInterruptBreak) {
-                interpreter->instance->interrupt = ProgramInterruptNone;
-                continue_loop = false;
-            } else if (interpreter->instance->interrupt == ProgramInterruptReturn) {
-                continue_loop = false;
-            } else if (interpreter->instance->interrupt == ProgramInterruptSkip) {
-                interpreter->instance->interrupt = ProgramInterruptNone;
+        } else if (value_is_iterator(iterator)) {
+            // iterators produce their values until they are exhausted
+            while (continue_loop && loop_through_check_condition(interpreter, inst)) {
+                RaelValue *iteration_value = value_iter_next(iterator);
+                if (!iteration_value)
+                    break;
+                // lazy iterators produce a blame when they fail
+                if (blame_validate(iteration_value)) {
+                    value_deref(iterator);
+                    blame_set_state((RaelBlameValue*)iteration_value, inst->info.iterate.expr->state);
+                    interpreter_explode(interpreter, (RaelBlameValue*)iteration_value);
+                }
+                continue_loop = loop_through_run_iteration(interpreter, inst, iteration_value);
             }
-            interpreter_pop_scope(interpreter);
+        } else {
+            value_deref(iterator);
+            interpreter_error(interpreter, inst->info.iterate.expr->state, "Expected an iterable");
         }
         value_deref(iterator);
         break;
     }
     case LoopForever:
         for (;;) {
-            block_run(interpreter, inst->info.block, true);
+            if (jit_loop_run(interpreter, &inst->jit, (RaelInstruction*)inst))
+                break;
+            interpreter_push_scope(interpreter);
+            block_run(interpreter, inst->info.block, false);
+            interpreter_pop_scope(interpreter);
             if (interpreter->instance->interrupt == ProgramInterruptBreak) {
                 interpreter->instance->interrupt = ProgramInterruptNone;
                 break;
@@ -1131,25 +1591,20 @@ void interpreter_interpret_inst_show(RaelInterpreter *interpreter, RaelCsvInstru
 }
 
 void interpreter_interpret_inst_if(RaelInterpreter *interpreter, RaelIfInstruction *inst) {
-    RaelValue *condition;
     bool is_true;
 
     switch (inst->info.if_type) {
     case IfTypeBlock:
         interpreter_push_scope(interpreter);
         // evaluate condition and check if it is true then dereference the condition
-        condition = expr_eval(interpreter, inst->info.condition, true);
-        is_true = value_truthy(condition);
-        value_deref(condition);
+        is_true = expr_eval_condition(interpreter, inst->info.condition);
         if (is_true) {
             block_run(interpreter, inst->info.if_block, false);
         }
         interpreter_pop_scope(interpreter);
         break;
     case IfTypeInstruction:
-        condition = expr_eval(interpreter, inst->info.condition, true);
-        is_true = value_truthy(condition);
-        value_deref(condition);
+        is_true = expr_eval_condition(interpreter, inst->info.condition);
         if (is_true) {
             interpreter_interpret_inst(interpreter, inst->info.if_instruction);
         }
@@ -1179,6 +1634,42 @@ void interpreter_interpret_inst_pure(RaelInterpreter *interpreter, RaelPureInstr
 }
 
 void interpreter_interpret_inst_return(RaelInterpreter *interpreter, RaelReturnInstruction *inst) {
+    if (inst->is_tail_call) {
+        struct Expr *call_expr = inst->return_expr;
+        RaelValue *callable = expr_eval(interpreter, call_expr->as_call.callable_expr, true);
+
+        // routines are called by the returning routine after its scope is removed, instead of nesting the call
+        if (callable->type == &RaelRoutineType && !((RaelRoutineValue*)callable)->is_generator) {
+            RaelArgumentList tail_args;
+
+            // the arguments outlive the call of the returning routine, so they aren't on the argument stack.
+            // they're only stored after they're evaluated, because an argument can make a tail call too
+            eval_call_arguments(interpreter, &call_expr->as_call.args, &tail_args, false);
+            interpreter->instance->tail_args = tail_args;
+            interpreter->instance->tail_callable = callable;
+            interpreter->instance->tail_state = call_expr->state;
+            interpreter->instance->returned_value = NULL;
+            interpreter->instance->interrupt = ProgramInterruptReturn;
+            return;
+        }
+
+        // other callables are called like in a regular call expression
+        if (value_is_callable(callable)) {
+            RaelArgumentList args;
+
+            eval_call_arguments(interpreter, &call_expr->as_call.args, &args, true);
+            interpreter->instance->returned_value = value_call(callable, &args, interpreter);
+            interpreter_pop_arguments(interpreter, &args);
+        } else {
+            interpreter->instance->returned_value = BLAME_NEW_CSTR("Tried to call a non-callable");
+        }
+        if (blame_validate(interpreter->instance->returned_value))
+            blame_set_state((RaelBlameValue*)interpreter->instance->returned_value, call_expr->state);
+        value_deref(callable);
+        interpreter->instance->interrupt = ProgramInterruptReturn;
+        return;
+    }
+
     // if there is a return value, return it, and if there isn't, return a Void
     if (inst->return_expr) {
         interpreter->instance->returned_value = expr_eval(interpreter, inst->return_expr, false);
@@ -1188,6 +1679,10 @@ void interpreter_interpret_inst_return(RaelInterpreter *interpreter, RaelReturnI
     interpreter->instance->interrupt = ProgramInterruptReturn;
 }
 
+void interpreter_interpret_inst_yield(RaelInterpreter *interpreter, RaelYieldInstruction *inst) {
+    generator_yield(interpreter, expr_eval(interpreter, inst->yield_expr, true));
+}
+
 void interpreter_interpret_inst_break(RaelInterpreter *interpreter, RaelInstruction *inst) {
     (void)inst;
     interpreter->instance->interrupt = ProgramInterruptBreak;
@@ -4,6 +4,9 @@
 #include "common.h"
 #include "parser.h"
 
+#include <setjmp.h>
+#include <stdint.h>
+
 typedef struct RaelInterpreter RaelInterpreter;
 typedef struct RaelInstance RaelInstance;
 typedef RaelValue* (*RaelNewModuleFunc)(RaelInterpreter *interpreter);
@@ -17,6 +20,21 @@ enum ProgramInterrupt {
     ProgramInterruptSkip
 };
 
+/*
+ * The arguments of calls are pushed on a stack of chunks, and argument lists of calls are views into it,
+ * so calls don't allocate their argument lists. Chunks never move, and they are kept for the next calls.
+ */
+typedef struct RaelArgumentChunk {
+    struct RaelArgumentChunk *prev, *next;
+    size_t used, capacity;
+    RaelArgument arguments[];
+} RaelArgumentChunk;
+
+typedef struct RaelArgumentStack {
+    /* the chunk at the top of the stack */
+    RaelArgumentChunk *chunk;
+} RaelArgumentStack;
+
 struct RaelInstance {
     /* Store previous instance */
     RaelInstance *prev;
@@ -25,11 +43,17 @@ struct RaelInstance {
     RaelInstruction **instructions;
     size_t idx;
 
+    /* If true, the instance is owned by a value and was only pushed to the interpreter */
+    bool borrowed;
     /* If true, the scope is inherited from a different instance */
     bool inherit_scope;
     struct Scope *scope;
     enum ProgramInterrupt interrupt;
     RaelValue *returned_value;
+    /* a call that was returned from a routine, which the routine makes after it returns (a tail call) */
+    RaelValue *tail_callable;
+    RaelArgumentList tail_args;
+    struct State tail_state;
     bool inherit_modules;
     RaelValue **module_cache;
 };
@@ -41,10 +65,25 @@ struct RaelInterpreter {
 
     RaelStream *main_stream;
     RaelInstance *instance;
+    /* the generator that is currently running, if there is one */
+    struct RaelGeneratorValue *generator;
+    /* the argument stack in use, which is either `main_arguments` or the stack of the running generator */
+    RaelArgumentStack *arguments;
+    RaelArgumentStack main_arguments;
     unsigned int seed;
+    /* state of the interpreter's own pseudo random number generator */
+    uint64_t random_state;
+
+    /* if defined, fatal errors jump here instead of exiting the process */
+    jmp_buf *exit_handler;
+    int exit_code;
 
     // warnings
     bool warn_undefined;
+    /* evaluate expressions with closure compiled functions instead of walking their trees */
+    bool closures;
+    /* compile hot routines and loops to native code */
+    bool jit;
 };
 
 typedef struct RaelModuleDecl {
@@ -76,6 +115,12 @@ void interpreter_destruct(RaelInterpreter* const interpreter);
 
 void interpreter_interpret(RaelInterpreter *interpreter);
 
+void interpreter_exit(RaelInterpreter* const interpreter, int exit_code);
+
+void interpreter_recover(RaelInterpreter* const interpreter, RaelInstance *instance, struct Scope *scope);
+
+uint64_t interpreter_random(RaelInterpreter* const interpreter);
+
 void interpreter_push_instance(RaelInterpreter* const interpreter, RaelInstance *instance);
 
 void interpreter_pop_instance(RaelInterpreter* const interpreter);
@@ -85,12 +130,34 @@ void interpreter_new_instance(RaelInterpreter* const interpreter, RaelStream *st
 
 void interpreter_delete_instance(RaelInterpreter* const interpreter);
 
+/* reserve `amount` arguments on the argument stack, and make `out` an empty argument list that uses them */
+void interpreter_push_arguments(RaelInterpreter* const interpreter, size_t amount, RaelArgumentList *out);
+
+/* dereference the arguments of a list from interpreter_push_arguments, and release their space */
+void interpreter_pop_arguments(RaelInterpreter* const interpreter, RaelArgumentList *args);
+
+void argument_stack_new(RaelArgumentStack *out);
+
+void argument_stack_delete(RaelArgumentStack *stack);
+
 void interpreter_push_scope(RaelInterpreter* const interpreter);
 
 void interpreter_pop_scope(RaelInterpreter* const interpreter);
 
 RaelValue *expr_eval(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode);
 
+/* evaluate an expression and return whether it's truthy. comparisons don't create a value */
+bool expr_eval_condition(RaelInterpreter* const interpreter, struct Expr* const expr);
+
+/* evaluate an arithmetic expression (+, -, *, /, %) on its evaluated operands */
+RaelValue *expr_eval_arithmetic(struct Expr *expr, RaelValue *lhs, RaelValue *rhs);
+
+/*
+ * evaluate a comparison expression on its evaluated operands.
+ * returns NULL and sets `out` to the result, or returns a blame if the operands can't be compared
+ */
+RaelValue *expr_eval_comparison(struct Expr *expr, RaelValue *lhs, RaelValue *rhs, bool *out);
+
 void block_run(RaelInterpreter* const interpreter, RaelInstruction **block, bool create_new_scope);
 
 /* instance functions */
@@ -0,0 +1,628 @@
+/* MAP_ANONYMOUS isn't a part of the POSIX version that rael.h asks for */
+#define _DEFAULT_SOURCE
+#include "rael.h"
+
+#include <pthread.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define RAEL_JIT_X86_64
+#endif
+
+typedef void (*RaelJitEntry)(RaelInterpreter *interpreter);
+
+struct RaelJitCode {
+    RaelJitEntry entry;
+    unsigned char *memory;
+    size_t size;
+};
+
+bool jit_supported(void) {
+#ifdef RAEL_JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+void jit_state_new(RaelJitState *out) {
+    out->hotness = 0;
+    out->code = NULL;
+    out->failed = false;
+}
+
+void jit_state_delete(RaelJitState *state) {
+    if (state->code) {
+        munmap(state->code->memory, state->code->size);
+        free(state->code);
+        state->code = NULL;
+    }
+}
+
+#ifdef RAEL_JIT_X86_64
+
+/*
+ * Compiled code keeps the interpreter in rbx, and has a frame of JIT_SLOTS slots (at rsp) for the
+ * temporary results of whole number expressions, which are calculated in rax and rcx.
+ *
+ * Loops, ifs, whole number comparisons and assignments of whole number expressions to variables
+ * are compiled to native code. Variables are read and written through jit_load_int and jit_store_int,
+ * and when one of them fails (the variable isn't a whole number, or its number is shared), or when a
+ * modulo's rhs isn't positive, the expression is evaluated by the interpreter instead, which is
+ * correct because nothing was changed before that. Other instructions call their run function.
+ */
+#define JIT_SLOTS 16
+#define JIT_FRAME_SIZE (JIT_SLOTS * 8)
+
+/* condition codes of x86 jumps */
+enum JitCondition {
+    JitConditionEqual = 0x4,
+    JitConditionNotEqual = 0x5,
+    JitConditionLess = 0xc,
+    JitConditionGreaterOrEqual = 0xd,
+    JitConditionLessOrEqual = 0xe,
+    JitConditionGreater = 0xf
+};
+
+typedef struct JitBuffer {
+    unsigned char *bytes;
+    size_t length, allocated;
+} JitBuffer;
+
+/* the positions of the rel32 offsets of jumps to a place that wasn't emitted yet */
+typedef struct JitJumps {
+    size_t *positions;
+    size_t amount, allocated;
+} JitJumps;
+
+/* the perf map is shared by all of the threads of the process */
+static pthread_mutex_t perf_map_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *perf_map = NULL;
+
+/* name the code in /tmp/perf-<pid>.map, so perf can show which block it belongs to */
+static void perf_map_add(RaelJitCode *code, RaelInterpreter *interpreter, struct State *state) {
+    char *stream_name = interpreter->instance->stream ? interpreter->instance->stream->name : NULL;
+    size_t line = 0, column;
+
+    if (state && state->stream)
+        stream_position(state->stream, state->offset, &line, &column);
+
+    pthread_mutex_lock(&perf_map_lock);
+    if (!perf_map) {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)getpid());
+        perf_map = fopen(path, "a");
+    }
+    if (perf_map) {
+        fprintf(perf_map, "%" PRIxPTR " %zx rael:%s:%zu\n", (uintptr_t)code->memory, code->size,
+                stream_name ? stream_name : "<string>", line);
+        fflush(perf_map);
+    }
+    pthread_mutex_unlock(&perf_map_lock);
+}
+
+/* read a variable that is set to a whole number */
+static bool jit_load_int(RaelInterpreter *interpreter, char *key, RaelInt *out) {
+    RaelValue **variable = scope_get_ptr(interpreter->instance->scope, key);
+
+    if (!variable || (*variable)->type != &RaelNumberType || ((RaelNumberValue*)*variable)->is_float)
+        return false;
+    *out = ((RaelNumberValue*)*variable)->as_int;
+    return true;
+}
+
+/*
+ * set a variable to a whole number by changing its number, if nothing else references the number.
+ * the number has no other owners and no keys, so it's the same as replacing it with a new one
+ */
+static bool jit_store_int(RaelInterpreter *interpreter, char *key, RaelInt value) {
+    RaelValue **variable = scope_get_ptr(interpreter->instance->scope, key);
+    RaelNumberValue *number;
+
+    if (!variable || (*variable)->type != &RaelNumberType || (*variable)->reference_count != 1
+        || value_has_side_keys(*variable))
+        return false;
+    number = (RaelNumberValue*)*variable;
+    number->is_float = false;
+    number->as_int = value;
+    return true;
+}
+
+static void emit_bytes(JitBuffer *buffer, const unsigned char *bytes, size_t amount) {
+    if (buffer->length + amount > buffer->allocated) {
+        buffer->allocated = (buffer->length + amount) * 2;
+        buffer->bytes = realloc(buffer->bytes, buffer->allocated);
+    }
+    memcpy(buffer->bytes + buffer->length, bytes, amount);
+    buffer->length += amount;
+}
+
+#define EMIT(buffer, ...) emit_bytes(buffer, (const unsigned char[]){ __VA_ARGS__ }, \
+                                     sizeof((const unsigned char[]){ __VA_ARGS__ }))
+
+static void emit_u32(JitBuffer *buffer, uint32_t value) {
+    emit_bytes(buffer, (unsigned char*)&value, sizeof(uint32_t));
+}
+
+static void emit_u64(JitBuffer *buffer, uint64_t value) {
+    emit_bytes(buffer, (unsigned char*)&value, sizeof(uint64_t));
+}
+
+/* emit a rel32 offset that is patched when the jumps are placed */
+static void jumps_add(JitBuffer *buffer, JitJumps *jumps) {
+    if (jumps->amount >= jumps->allocated) {
+        jumps->allocated = jumps->allocated ? jumps->allocated * 2 : 4;
+        jumps->positions = realloc(jumps->positions, jumps->allocated * sizeof(size_t));
+    }
+    jumps->positions[jumps->amount++] = buffer->length;
+    emit_u32(buffer, 0);
+}
+
+/* make the jumps go to the end of the code, and delete them */
+static void jumps_place(JitBuffer *buffer, JitJumps *jumps) {
+    for (size_t i = 0; i < jumps->amount; ++i) {
+        // offsets are relative to the end of the jump
+        uint32_t offset = (uint32_t)(buffer->length - (jumps->positions[i] + sizeof(uint32_t)));
+        memcpy(buffer->bytes + jumps->positions[i], &offset, sizeof(uint32_t));
+    }
+    free(jumps->positions);
+    jumps->positions = NULL;
+    jumps->amount = jumps->allocated = 0;
+}
+
+/* jcc rel32 */
+static void emit_jump_if(JitBuffer *buffer, enum JitCondition condition, JitJumps *to) {
+    EMIT(buffer, 0x0f, 0x80 | condition);
+    jumps_add(buffer, to);
+}
+
+/* jmp rel32 */
+static void emit_jump(JitBuffer *buffer, JitJumps *to) {
+    EMIT(buffer, 0xe9);
+    jumps_add(buffer, to);
+}
+
+/* jmp rel32 to code that was already emitted */
+static void emit_jump_back(JitBuffer *buffer, size_t target) {
+    EMIT(buffer, 0xe9);
+    emit_u32(buffer, (uint32_t)(target - (buffer->length + sizeof(uint32_t))));
+}
+
+/* mov rdi, rbx; mov rsi, imm64 (if there are two arguments); mov rax, imm64; call rax */
+static void emit_call(JitBuffer *buffer, void *function, void *second_argument) {
+    EMIT(buffer, 0x48, 0x89, 0xdf);
+    if (second_argument) {
+        EMIT(buffer, 0x48, 0xbe);
+        emit_u64(buffer, (uint64_t)(uintptr_t)second_argument);
+    }
+    EMIT(buffer, 0x48, 0xb8);
+    emit_u64(buffer, (uint64_t)(uintptr_t)function);
+    EMIT(buffer, 0xff, 0xd0);
+}
+
+/* test al, al; je rel32. used after calls that return a bool */
+static void emit_jump_if_false(JitBuffer *buffer, JitJumps *to) {
+    EMIT(buffer, 0x84, 0xc0);
+    emit_jump_if(buffer, JitConditionEqual, to);
+}
+
+/* mov rax, [rbx + instance]; mov ecx, [rax + interrupt] */
+static void emit_load_interrupt(JitBuffer *buffer) {
+    EMIT(buffer, 0x48, 0x8b, 0x83);
+    emit_u32(buffer, (uint32_t)offsetof(RaelInterpreter, instance));
+    EMIT(buffer, 0x8b, 0x88);
+    emit_u32(buffer, (uint32_t)offsetof(RaelInstance, interrupt));
+}
+
+/* mov dword [rax + interrupt], ProgramInterruptNone. rax has to be the instance */
+static void emit_clear_interrupt(JitBuffer *buffer) {
+    EMIT(buffer, 0xc7, 0x80);
+    emit_u32(buffer, (uint32_t)offsetof(RaelInstance, interrupt));
+    emit_u32(buffer, ProgramInterruptNone);
+}
+
+static bool expr_is_arithmetic(enum ExprType type) {
+    return type == ExprTypeAdd || type == ExprTypeSub || type == ExprTypeMul || type == ExprTypeMod;
+}
+
+static bool expr_is_comparison(enum ExprType type) {
+    switch (type) {
+    case ExprTypeEquals:
+    case ExprTypeNotEqual:
+    case ExprTypeSmallerThan:
+    case ExprTypeBiggerThan:
+    case ExprTypeSmallerOrEqual:
+    case ExprTypeBiggerOrEqual:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* can the expression be compiled as a whole number expression, if its result is in slot `depth`? */
+static bool int_expr_compiles(struct Expr *expr, size_t depth) {
+    if (depth >= JIT_SLOTS)
+        return false;
+    switch (expr->type) {
+    case ExprTypeValue:
+        return expr->as_value->type == ValueTypeNumber && !expr->as_value->as_number.is_float;
+    case ExprTypeKey:
+        return true;
+    case ExprTypeNeg:
+        return int_expr_compiles(expr->as_single, depth);
+    default:
+        return expr_is_arithmetic(expr->type) && int_expr_compiles(expr->lhs, depth)
+               && int_expr_compiles(expr->rhs, depth + 1);
+    }
+}
+
+/* can the expression be compiled as a condition of comparisons between whole numbers? */
+static bool int_condition_compiles(struct Expr *expr) {
+    switch (expr->type) {
+    case ExprTypeAnd:
+    case ExprTypeOr:
+        return int_condition_compiles(expr->lhs) && int_condition_compiles(expr->rhs);
+    case ExprTypeNot:
+        return int_condition_compiles(expr->lhs);
+    default:
+        return expr_is_comparison(expr->type) && int_expr_compiles(expr->lhs, 0)
+               && int_expr_compiles(expr->rhs, 1);
+    }
+}
+
+/* rax = rax <operation> rcx, like quick_arithmetic_int */
+static void emit_arithmetic(JitBuffer *buffer, enum ExprType type, JitJumps *fallback) {
+    switch (type) {
+    case ExprTypeAdd:
+        EMIT(buffer, 0x48, 0x01, 0xc8); // add rax, rcx
+        break;
+    case ExprTypeSub:
+        EMIT(buffer, 0x48, 0x29, 0xc8); // sub rax, rcx
+        break;
+    case ExprTypeMul:
+        EMIT(buffer, 0x48, 0x0f, 0xaf, 0xc1); // imul rax, rcx
+        break;
+    case ExprTypeMod:
+        // ((a % b) + b) % b, only for a positive b, so idiv can't fail
+        EMIT(buffer, 0x48, 0x85, 0xc9); // test rcx, rcx
+        emit_jump_if(buffer, JitConditionLessOrEqual, fallback);
+        EMIT(buffer, 0x48, 0x99,              // cqo
+                     0x48, 0xf7, 0xf9,        // idiv rcx
+                     0x48, 0x89, 0xd0,        // mov rax, rdx
+                     0x48, 0x01, 0xc8,        // add rax, rcx
+                     0x48, 0x99,              // cqo
+                     0x48, 0xf7, 0xf9,        // idiv rcx
+                     0x48, 0x89, 0xd0);       // mov rax, rdx
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+}
+
+/* read a whole number variable into slot `depth` and rax */
+static void emit_load_variable(JitBuffer *buffer, char *key, size_t depth, JitJumps *fallback) {
+    EMIT(buffer, 0x48, 0x8d, 0x54, 0x24, (unsigned char)(depth * 8)); // lea rdx, [rsp + depth * 8]
+    emit_call(buffer, (void*)jit_load_int, key);
+    emit_jump_if_false(buffer, fallback);
+    EMIT(buffer, 0x48, 0x8b, 0x44, 0x24, (unsigned char)(depth * 8)); // mov rax, [rsp + depth * 8]
+}
+
+/* calculate a whole number expression into rax. slots below `depth` are kept */
+static void compile_int_expr(JitBuffer *buffer, struct Expr *expr, size_t depth, JitJumps *fallback) {
+    switch (expr->type) {
+    case ExprTypeValue:
+        EMIT(buffer, 0x48, 0xb8); // mov rax, imm64
+        emit_u64(buffer, (uint64_t)expr->as_value->as_number.as_int);
+        break;
+    case ExprTypeKey:
+        emit_load_variable(buffer, expr->as_key, depth, fallback);
+        break;
+    case ExprTypeNeg:
+        compile_int_expr(buffer, expr->as_single, depth, fallback);
+        EMIT(buffer, 0x48, 0xf7, 0xd8); // neg rax
+        break;
+    default:
+        compile_int_expr(buffer, expr->lhs, depth, fallback);
+        EMIT(buffer, 0x48, 0x89, 0x44, 0x24, (unsigned char)(depth * 8)); // mov [rsp + depth * 8], rax
+        compile_int_expr(buffer, expr->rhs, depth + 1, fallback);
+        EMIT(buffer, 0x48, 0x89, 0xc1,                                    // mov rcx, rax
+                     0x48, 0x8b, 0x44, 0x24, (unsigned char)(depth * 8)); // mov rax, [rsp + depth * 8]
+        emit_arithmetic(buffer, expr->type, fallback);
+        break;
+    }
+}
+
+/* the condition code of a comparison, or of its opposite */
+static enum JitCondition comparison_condition(enum ExprType type, bool when) {
+    switch (type) {
+    case ExprTypeEquals: return when ? JitConditionEqual : JitConditionNotEqual;
+    case ExprTypeNotEqual: return when ? JitConditionNotEqual : JitConditionEqual;
+    case ExprTypeSmallerThan: return when ? JitConditionLess : JitConditionGreaterOrEqual;
+    case ExprTypeBiggerThan: return when ? JitConditionGreater : JitConditionLessOrEqual;
+    case ExprTypeSmallerOrEqual: return when ? JitConditionLessOrEqual : JitConditionGreater;
+    case ExprTypeBiggerOrEqual: return when ? JitConditionGreaterOrEqual : JitConditionLess;
+    default:
+        RAEL_UNREACHABLE();
+        return JitConditionEqual;
+    }
+}
+
+/* jump to `to` if the condition is `when`, and continue otherwise */
+static void compile_int_branch(JitBuffer *buffer, struct Expr *condition, bool when, JitJumps *to, JitJumps *fallback) {
+    JitJumps skip = { NULL, 0, 0 };
+
+    switch (condition->type) {
+    case ExprTypeAnd:
+    case ExprTypeOr:
+        // `a and b` is false if a is false, and `a or b` is true if a is true
+        if (when == (condition->type == ExprTypeOr)) {
+            compile_int_branch(buffer, condition->lhs, when, to, fallback);
+        } else {
+            compile_int_branch(buffer, condition->lhs, !when, &skip, fallback);
+        }
+        compile_int_branch(buffer, condition->rhs, when, to, fallback);
+        jumps_place(buffer, &skip);
+        break;
+    case ExprTypeNot:
+        compile_int_branch(buffer, condition->lhs, !when, to, fallback);
+        break;
+    default:
+        compile_int_expr(buffer, condition->lhs, 0, fallback);
+        EMIT(buffer, 0x48, 0x89, 0x04, 0x24); // mov [rsp], rax
+        compile_int_expr(buffer, condition->rhs, 1, fallback);
+        EMIT(buffer, 0x48, 0x89, 0xc1,        // mov rcx, rax
+                     0x48, 0x8b, 0x04, 0x24,  // mov rax, [rsp]
+                     0x48, 0x39, 0xc8);       // cmp rax, rcx
+        emit_jump_if(buffer, comparison_condition(condition->type, when), to);
+        break;
+    }
+}
+
+/* jump to `when_false` if the condition is false */
+static void compile_condition(JitBuffer *buffer, struct Expr *condition, JitJumps *when_false) {
+    if (int_condition_compiles(condition)) {
+        JitJumps fallback = { NULL, 0, 0 }, done = { NULL, 0, 0 };
+
+        compile_int_branch(buffer, condition, false, when_false, &fallback);
+        if (fallback.amount == 0)
+            return;
+        emit_jump(buffer, &done);
+        jumps_place(buffer, &fallback);
+        emit_call(buffer, (void*)expr_eval_condition, condition);
+        emit_jump_if_false(buffer, when_false);
+        jumps_place(buffer, &done);
+    } else {
+        emit_call(buffer, (void*)expr_eval_condition, condition);
+        emit_jump_if_false(buffer, when_false);
+    }
+}
+
+static void compile_instruction(JitBuffer *buffer, RaelInstruction *instruction);
+
+/* run the instructions of a block in the current scope, and stop at an interrupt */
+static void compile_block(JitBuffer *buffer, RaelInstruction **block) {
+    JitJumps interrupted = { NULL, 0, 0 };
+
+    for (size_t i = 0; block[i]; ++i) {
+        compile_instruction(buffer, block[i]);
+        emit_load_interrupt(buffer);
+        EMIT(buffer, 0x85, 0xc9); // test ecx, ecx
+        emit_jump_if(buffer, JitConditionNotEqual, &interrupted);
+    }
+    jumps_place(buffer, &interrupted);
+}
+
+/* `:x ?= <whole number expression>` and `:x <operator>= <whole number expression>` */
+static bool compile_int_assignment(JitBuffer *buffer, RaelPureInstruction *instruction) {
+    struct Expr *expr = instruction->expr;
+    JitJumps fallback = { NULL, 0, 0 }, done = { NULL, 0, 0 };
+    enum ExprType operation;
+
+    switch (expr->type) {
+    case ExprTypeSet: operation = ExprTypeSet; break;
+    case ExprTypeAddEqual: operation = ExprTypeAdd; break;
+    case ExprTypeSubEqual: operation = ExprTypeSub; break;
+    case ExprTypeMulEqual: operation = ExprTypeMul; break;
+    case ExprTypeModEqual: operation = ExprTypeMod; break;
+    default: return false;
+    }
+    if (expr->as_set.set_type != SetTypeKey || !int_expr_compiles(expr->as_set.expr, 1))
+        return false;
+
+    if (operation == ExprTypeSet) {
+        compile_int_expr(buffer, expr->as_set.expr, 0, &fallback);
+    } else {
+        emit_load_variable(buffer, expr->as_set.as_key, 0, &fallback);
+        compile_int_expr(buffer, expr->as_set.expr, 1, &fallback);
+        EMIT(buffer, 0x48, 0x89, 0xc1,        // mov rcx, rax
+                     0x48, 0x8b, 0x04, 0x24); // mov rax, [rsp]
+        emit_arithmetic(buffer, operation, &fallback);
+    }
+    EMIT(buffer, 0x48, 0x89, 0xc2); // mov rdx, rax
+    emit_call(buffer, (void*)jit_store_int, expr->as_set.as_key);
+    emit_jump_if_false(buffer, &fallback);
+    emit_jump(buffer, &done);
+    jumps_place(buffer, &fallback);
+    emit_call(buffer, (void*)instruction->_base.type->run, instruction);
+    jumps_place(buffer, &done);
+    return true;
+}
+
+static void compile_if(JitBuffer *buffer, RaelIfInstruction *instruction) {
+    JitJumps when_false = { NULL, 0, 0 }, done = { NULL, 0, 0 };
+
+    switch (instruction->info.if_type) {
+    case IfTypeBlock:
+        emit_call(buffer, (void*)interpreter_push_scope, NULL);
+        compile_condition(buffer, instruction->info.condition, &when_false);
+        compile_block(buffer, instruction->info.if_block);
+        emit_call(buffer, (void*)interpreter_pop_scope, NULL);
+        emit_jump(buffer, &done);
+        jumps_place(buffer, &when_false);
+        emit_call(buffer, (void*)interpreter_pop_scope, NULL);
+        break;
+    case IfTypeInstruction:
+        compile_condition(buffer, instruction->info.condition, &when_false);
+        compile_instruction(buffer, instruction->info.if_instruction);
+        emit_jump(buffer, &done);
+        jumps_place(buffer, &when_false);
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+
+    switch (instruction->info.else_type) {
+    case ElseTypeBlock:
+        emit_call(buffer, (void*)interpreter_push_scope, NULL);
+        compile_block(buffer, instruction->info.else_block);
+        emit_call(buffer, (void*)interpreter_pop_scope, NULL);
+        break;
+    case ElseTypeInstruction:
+        compile_instruction(buffer, instruction->info.else_instruction);
+        break;
+    case ElseTypeNone:
+        break;
+    default:
+        RAEL_UNREACHABLE();
+    }
+    jumps_place(buffer, &done);
+}
+
+/* loops with a condition and loops without one. returns false for loops through values */
+static bool compile_loop(JitBuffer *buffer, RaelLoopInstruction *instruction) {
+    JitJumps stop = { NULL, 0, 0 }, broke = { NULL, 0, 0 }, next = { NULL, 0, 0 };
+    size_t start = buffer->length;
+
+    switch (instruction->info.type) {
+    case LoopWhile:
+        emit_call(buffer, (void*)interpreter_push_scope, NULL);
+        compile_condition(buffer, instruction->info.while_condition, &stop);
+        compile_block(buffer, instruction->info.block);
+        break;
+    case LoopForever:
+        emit_call(buffer, (void*)interpreter_push_scope, NULL);
+        compile_block(buffer, instruction->info.block);
+        break;
+    default:
+        return false;
+    }
+
+    // a break stops the loop, a return stops it and is kept, and a skip continues it
+    emit_load_interrupt(buffer);
+    EMIT(buffer, 0x83, 0xf9, ProgramInterruptBreak); // cmp ecx, imm8
+    emit_jump_if(buffer, JitConditionEqual, &broke);
+    EMIT(buffer, 0x83, 0xf9, ProgramInterruptReturn);
+    emit_jump_if(buffer, JitConditionEqual, &stop);
+    EMIT(buffer, 0x83, 0xf9, ProgramInterruptSkip);
+    emit_jump_if(buffer, JitConditionNotEqual, &next);
+    emit_clear_interrupt(buffer);
+    jumps_place(buffer, &next);
+    emit_call(buffer, (void*)interpreter_pop_scope, NULL);
+    emit_jump_back(buffer, start);
+
+    jumps_place(buffer, &broke);
+    emit_clear_interrupt(buffer);
+    jumps_place(buffer, &stop);
+    emit_call(buffer, (void*)interpreter_pop_scope, NULL);
+    return true;
+}
+
+static void compile_instruction(JitBuffer *buffer, RaelInstruction *instruction) {
+    bool compiled = false;
+
+    if (instruction->type == &RaelInstructionTypePureExpr) {
+        compiled = compile_int_assignment(buffer, (RaelPureInstruction*)instruction);
+    } else if (instruction->type == &RaelInstructionTypeIf) {
+        compile_if(buffer, (RaelIfInstruction*)instruction);
+        compiled = true;
+    } else if (instruction->type == &RaelInstructionTypeLoop) {
+        compiled = compile_loop(buffer, (RaelLoopInstruction*)instruction);
+    }
+
+    if (!compiled)
+        emit_call(buffer, (void*)instruction->type->run, instruction);
+}
+
+/* compile a block, or a single instruction if `block` is NULL */
+static RaelJitCode *jit_compile(RaelInterpreter *interpreter, RaelInstruction **block, RaelInstruction *instruction) {
+    JitBuffer buffer = { NULL, 0, 0 };
+    unsigned char *memory;
+    RaelJitCode *code;
+
+    // the interrupt is compared as a dword
+    if (sizeof(((RaelInstance*)NULL)->interrupt) != sizeof(uint32_t))
+        return NULL;
+
+    EMIT(&buffer, 0x53,                                    // push rbx
+                  0x48, 0x89, 0xfb,                        // mov rbx, rdi
+                  0x48, 0x81, 0xec);                       // sub rsp, imm32
+    emit_u32(&buffer, JIT_FRAME_SIZE);
+    if (block)
+        compile_block(&buffer, block);
+    else
+        compile_instruction(&buffer, instruction);
+    EMIT(&buffer, 0x48, 0x81, 0xc4);                       // add rsp, imm32
+    emit_u32(&buffer, JIT_FRAME_SIZE);
+    EMIT(&buffer, 0x5b,                                    // pop rbx
+                  0xc3);                                   // ret
+
+    memory = mmap(NULL, buffer.length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        free(buffer.bytes);
+        return NULL;
+    }
+    memcpy(memory, buffer.bytes, buffer.length);
+    free(buffer.bytes);
+    if (mprotect(memory, buffer.length, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, buffer.length);
+        return NULL;
+    }
+
+    code = malloc(sizeof(RaelJitCode));
+    code->entry = (RaelJitEntry)memory;
+    code->memory = memory;
+    code->size = buffer.length;
+    if (block)
+        perf_map_add(code, interpreter, block[0] ? &block[0]->state : NULL);
+    else
+        perf_map_add(code, interpreter, &instruction->state);
+    return code;
+}
+
+#else
+
+static RaelJitCode *jit_compile(RaelInterpreter *interpreter, RaelInstruction **block, RaelInstruction *instruction) {
+    (void)interpreter;
+    (void)block;
+    (void)instruction;
+    return NULL;
+}
+
+#endif
+
+/* count a run of a block or instruction, and return its code if it's compiled */
+static RaelJitCode *jit_state_code(RaelInterpreter *interpreter, RaelJitState *state, RaelInstruction **block,
+                                   RaelInstruction *instruction) {
+    if (!state->code && !state->failed && interpreter->jit && ++state->hotness >= RAEL_JIT_THRESHOLD) {
+        if (!(state->code = jit_compile(interpreter, block, instruction)))
+            state->failed = true;
+    }
+    return state->code;
+}
+
+void jit_block_run(RaelInterpreter *interpreter, RaelJitState *state, RaelInstruction **block) {
+    RaelJitCode *code = jit_state_code(interpreter, state, block, NULL);
+
+    if (code)
+        code->entry(interpreter);
+    else
+        block_run(interpreter, block, false);
+}
+
+bool jit_loop_run(RaelInterpreter *interpreter, RaelJitState *state, RaelInstruction *loop) {
+    RaelJitCode *code = jit_state_code(interpreter, state, NULL, loop);
+
+    if (!code)
+        return false;
+    code->entry(interpreter);
+    return true;
+}
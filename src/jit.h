@@ -0,0 +1,47 @@
+#ifndef RAEL_JIT_H
+#define RAEL_JIT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * The JIT compiles hot blocks of instructions (the blocks of routines and loops) and hot loops
+ * into native code. Loops, ifs and arithmetic and comparisons of whole numbers are lowered to
+ * native instructions, and other instructions are run by calling their run function. It's only
+ * supported on x86-64 Linux, and on other systems everything is interpreted.
+ */
+
+struct RaelInstruction;
+struct RaelInterpreter;
+
+/* the amount of times a block runs before it's compiled */
+#define RAEL_JIT_THRESHOLD 64
+
+typedef struct RaelJitCode RaelJitCode;
+
+/* the JIT state of a block, which is stored by whatever owns the block */
+typedef struct RaelJitState {
+    /* how many times the block ran */
+    size_t hotness;
+    RaelJitCode *code;
+    /* set if the block couldn't be compiled, so it isn't tried again */
+    bool failed;
+} RaelJitState;
+
+/* is the JIT supported on this system? */
+bool jit_supported(void);
+
+void jit_state_new(RaelJitState *out);
+
+void jit_state_delete(RaelJitState *state);
+
+/* run a block without creating a new scope, and compile it if it became hot */
+void jit_block_run(struct RaelInterpreter *interpreter, RaelJitState *state, struct RaelInstruction **block);
+
+/*
+ * called before every iteration of a loop with a condition or a loop without one. if the loop became hot,
+ * it's compiled, and the compiled loop runs the rest of the iterations and true is returned
+ */
+bool jit_loop_run(struct RaelInterpreter *interpreter, RaelJitState *state, struct RaelInstruction *loop);
+
+#endif /* RAEL_JIT_H */
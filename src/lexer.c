@@ -1,17 +1,42 @@
 #include "rael.h"
 
-struct State lexer_dump_state(RaelLexer* const lexer) {
+/* the state of the scanner, which is only used while the token array is built */
+static struct State lexer_scan_state(RaelLexer* const lexer) {
     struct State state;
-    state.column = lexer->column;
-    state.line = lexer->line;
-    state.stream_pos = lexer->stream;
+    state.stream = lexer->stream.base;
+    state.offset = (uint32_t)(lexer->stream.cur - lexer->stream.base->base);
     return state;
 }
 
+struct State lexer_dump_state(RaelLexer* const lexer) {
+    return lexer->state;
+}
+
+/* find the index of the token that a state is before, with a binary search on the token array */
+static size_t lexer_token_idx(RaelLexer* const lexer, uint32_t offset) {
+    size_t low = 0, high = lexer->amount_tokens - 1;
+
+    // backtracking usually goes back a few tokens, so they're checked before searching the whole array
+    for (size_t idx = lexer->idx, steps = 0; idx > 0 && steps < 8; --idx, ++steps) {
+        if (lexer->tokens[idx - 1].end_state.offset == offset)
+            return idx;
+    }
+
+    // the token at `idx` starts after the end of the token before it
+    while (low < high) {
+        size_t middle = low + (high - low + 1) / 2;
+
+        if (lexer->tokens[middle - 1].end_state.offset <= offset)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+
 void lexer_load_state(RaelLexer* const lexer, struct State state) {
-    lexer->column = state.column;
-    lexer->line = state.line;
-    lexer->stream = state.stream_pos;
+    lexer->state = state;
+    lexer->idx = lexer_token_idx(lexer, state.offset);
 }
 
 static void lexer_error(RaelLexer* const lexer, const char* const error_message, ...) {
@@ -20,9 +45,17 @@ static void lexer_error(RaelLexer* const lexer, const char* const error_message,
     rael_show_error_message(lexer->stream.base->name, lexer_dump_state(lexer), error_message, va);
     va_end(va);
     lexer_destruct(lexer);
+    if (lexer->exit_handler)
+        longjmp(*lexer->exit_handler, 1);
     exit(1);
 }
 
+/* remember a scanning error, which is shown when the parser gets to it. always returns false */
+static bool lexer_scan_error(RaelLexer* const lexer, const char* const error_message) {
+    lexer->error_message = error_message;
+    return false;
+}
+
 static inline bool is_identifier_char(const char c) {
     return isalnum(c) || c == '_';
 }
@@ -31,63 +64,102 @@ static inline bool is_whitespace(char c) {
     return c == ' ' || c == '\t';
 }
 
+/* skip whitespace and comments. returns false on an error */
 static bool lexer_clean(RaelLexer* const lexer) {
-    bool cleaned = false;
     char *stream = lexer->stream.cur;
 
     for (;;) {
         if (is_whitespace(stream[0])) {
             ++stream;
-            ++lexer->column;
         } else if (stream[0] == '%' && stream[1] == '%') { // handle comments :^)
             stream += 2;
-            lexer->column += 2;
             while (stream[0] != '\n' && stream[0] != '\0') {
                 ++stream;
-                ++lexer->column;
             }
         } else if (stream[0] == '\\') {
             if (stream[1] != '\n') {
                 lexer->stream.cur = stream;
-                lexer_error(lexer, "Expected a newline after '\\'");
+                return lexer_scan_error(lexer, "Expected a newline after '\\'");
             }
             stream += 2;
-            ++lexer->line;
-            lexer->column = 1;
         } else {
             break;
         }
-        cleaned = true;
     }
     lexer->stream.cur = stream;
-    return cleaned;
+    return true;
 }
 
-void lexer_construct(RaelLexer *lexer, RaelStream *stream) {
-    stream_ptr_construct(&lexer->stream, stream, 0);
-    lexer->line = 1;
-    lexer->column = 1;
-}
-
-void lexer_destruct(RaelLexer *lexer) {
-    stream_ptr_destruct(&lexer->stream);
-}
-
-static bool lexer_match_keyword(RaelLexer* const lexer, const char* const keyword,
-                                 const size_t length, const enum TokenName name) {
-    if (strncmp(lexer->stream.cur, keyword, length) == 0 && !is_identifier_char(lexer->stream.cur[length])) {
-        lexer->token.name = name;
-        lexer->token.string = lexer->stream.cur;
-        lexer->token.length = length;
-        lexer->stream.cur += length;
-        lexer->column += length;
-        return true;
+/* returns the keyword an identifier is, or 0 if it isn't a keyword */
+static enum TokenName keyword_token_name(const char* const identifier, const size_t length) {
+#define KEYWORD(keyword, token_name)                                                                   \
+        do {                                                                                           \
+            if (length == sizeof(keyword)/sizeof(char)-1 && memcmp(identifier, keyword, length) == 0) \
+                return token_name;                                                                     \
+        } while (0)
+    // only the keywords that start with the identifier's first character are compared
+    switch (identifier[0]) {
+    case 'V':
+        KEYWORD("Void", TokenNameVoid);
+        break;
+    case 'a':
+        KEYWORD("at", TokenNameAt);
+        break;
+    case 'b':
+        KEYWORD("blame", TokenNameBlame);
+        KEYWORD("break", TokenNameBreak);
+        break;
+    case 'c':
+        KEYWORD("catch", TokenNameCatch);
+        break;
+    case 'e':
+        KEYWORD("else", TokenNameElse);
+        break;
+    case 'g':
+        KEYWORD("getstring", TokenNameGetString);
+        break;
+    case 'i':
+        KEYWORD("if", TokenNameIf);
+        break;
+    case 'l':
+        KEYWORD("log", TokenNameLog);
+        KEYWORD("loop", TokenNameLoop);
+        KEYWORD("load", TokenNameLoad);
+        break;
+    case 'm':
+        KEYWORD("match", TokenNameMatch);
+        break;
+    case 'r':
+        KEYWORD("routine", TokenNameRoutine);
+        break;
+    case 's':
+        KEYWORD("sizeof", TokenNameSizeof);
+        KEYWORD("show", TokenNameShow);
+        KEYWORD("skip", TokenNameSkip);
+        break;
+    case 't':
+        KEYWORD("typeof", TokenNameTypeof);
+        KEYWORD("through", TokenNameThrough);
+        KEYWORD("to", TokenNameTo);
+        break;
+    case 'w':
+        KEYWORD("with", TokenNameWith);
+        break;
+    case 'y':
+        KEYWORD("yield", TokenNameYield);
+        break;
     }
-    return false;
+#undef KEYWORD
+    return (enum TokenName)0;
 }
 
-bool lexer_tokenize(RaelLexer* const lexer) {
-    lexer_clean(lexer);
+/*
+ * scan the next token from the stream into `lexer->token`.
+ * returns false at the end of the stream, or on an error (and then `lexer->error_message` is set)
+ */
+static bool lexer_scan(RaelLexer* const lexer) {
+    if (!lexer_clean(lexer))
+        return false;
     // if it's an eof, return false
     if (lexer->stream.cur[0] == '\0')
         return false;
@@ -98,9 +170,8 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         lexer->token.string = lexer->stream.cur;
         do {
             ++lexer->stream.cur;
-            ++lexer->line;
-            lexer->column = 1;
-            lexer_clean(lexer);
+            if (!lexer_clean(lexer))
+                return false;
         } while(lexer->stream.cur[0] == '\n');
         lexer->token.length = lexer->stream.cur - last_pos;
         // if had newlines and was ended with a \0, count it as an eof
@@ -110,15 +181,13 @@ bool lexer_tokenize(RaelLexer* const lexer) {
     }
     if (lexer->stream.cur[0] == ':') {
         ++lexer->stream.cur;
-        ++lexer->column;
         lexer->token.string = lexer->stream.cur;
         lexer->token.length = 0;
         lexer->token.name = TokenNameKey;
         if (!is_identifier_char(lexer->stream.cur[0]))
-            lexer_error(lexer, "Unexpected character after ':'");
+            return lexer_scan_error(lexer, "Unexpected character after ':'");
         do {
             ++lexer->stream.cur;
-            ++lexer->column;
             ++lexer->token.length;
         } while(is_identifier_char(lexer->stream.cur[0]));
         return true;
@@ -131,7 +200,6 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         do {
             ++lexer->token.length;
             ++lexer->stream.cur;
-            ++lexer->column;
         } while(isdigit(lexer->stream.cur[0]));
         if (lexer->stream.cur[0] == '.') {
             if (!isdigit(lexer->stream.cur[1]))
@@ -139,7 +207,6 @@ bool lexer_tokenize(RaelLexer* const lexer) {
             do {
                 ++lexer->token.length;
                 ++lexer->stream.cur;
-                ++lexer->column;
             } while (isdigit(lexer->stream.cur[0]));
         }
         return true;
@@ -148,29 +215,23 @@ bool lexer_tokenize(RaelLexer* const lexer) {
     if (lexer->stream.cur[0] == '"') {
         lexer->token.name = TokenNameString;
         lexer->token.string = ++lexer->stream.cur;
-        ++lexer->column;
         lexer->token.length = 0;
         while (lexer->stream.cur[0] != '"') {
             if (lexer->stream.cur[0] == '\\') {
                 if (lexer->stream.cur[1] == '\\' || lexer->stream.cur[1] == '"') {
                     ++lexer->token.length;
                     ++lexer->stream.cur;
-                    ++lexer->column;
                 } else if (lexer->stream.cur[1] == '\n') {
                     ++lexer->token.length;
                     ++lexer->stream.cur;
-                    ++lexer->line;
-                    lexer->column = 1;
                 }
             } else if (lexer->stream.cur[0] == '\n' || lexer->stream.cur[0] == '\0') {
-                lexer_error(lexer, "Unexpected end-of-line");
+                return lexer_scan_error(lexer, "Unexpected end-of-line");
             }
             ++lexer->token.length;
             ++lexer->stream.cur;
-            ++lexer->column;
         }
         ++lexer->stream.cur;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == '?' && lexer->stream.cur[1] == '=') {
@@ -178,19 +239,16 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         lexer->token.length = 2;
         lexer->token.string = lexer->stream.cur;
         lexer->stream.cur += 2;
-        lexer->column += 2;
         return true;
     }
     if (lexer->stream.cur[0] == '+') {
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur;
         ++lexer->stream.cur;
-        ++lexer->column;
         if (lexer->stream.cur[0] == '=') {
             lexer->token.name = TokenNamePlusEquals;
             ++lexer->token.length;
             ++lexer->stream.cur;
-            ++lexer->column;
         } else {
             lexer->token.name = TokenNameAdd;
         }
@@ -200,12 +258,10 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur;
         ++lexer->stream.cur;
-        ++lexer->column;
         if (lexer->stream.cur[0] == '=') {
             lexer->token.name = TokenNameMinusEquals;
             ++lexer->token.length;
             ++lexer->stream.cur;
-            ++lexer->column;
         } else {
             lexer->token.name = TokenNameSub;
         }
@@ -215,12 +271,10 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur;
         ++lexer->stream.cur;
-        ++lexer->column;
         if (lexer->stream.cur[0] == '=') {
             lexer->token.name = TokenNameStarEquals;
             ++lexer->token.length;
             ++lexer->stream.cur;
-            ++lexer->column;
         } else {
             lexer->token.name = TokenNameMul;
         }
@@ -230,12 +284,10 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur;
         ++lexer->stream.cur;
-        ++lexer->column;
         if (lexer->stream.cur[0] == '=') {
             lexer->token.name = TokenNameSlashEquals;
             ++lexer->token.length;
             ++lexer->stream.cur;
-            ++lexer->column;
         } else {
             lexer->token.name = TokenNameDiv;
         }
@@ -245,12 +297,10 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur;
         ++lexer->stream.cur;
-        ++lexer->column;
         if (lexer->stream.cur[0] == '=') {
             lexer->token.name = TokenNamePercentEquals;
             ++lexer->token.length;
             ++lexer->stream.cur;
-            ++lexer->column;
         } else {
             lexer->token.name = TokenNameMod;
         }
@@ -260,54 +310,46 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         lexer->token.name = TokenNameLeftParen;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == ')') {
         lexer->token.name = TokenNameRightParen;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == ',') {
         lexer->token.name = TokenNameComma;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == '{') {
         lexer->token.name = TokenNameLeftCur;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == '}') {
         lexer->token.name = TokenNameRightCur;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == '=') {
         lexer->token.name = TokenNameEquals;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == '!') {
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur;
         ++lexer->stream.cur;
-        ++lexer->column;
         if (lexer->stream.cur[0] == '=') {
             lexer->token.name = TokenNameExclamationMarkEquals;
             ++lexer->token.length;
             ++lexer->stream.cur;
-            ++lexer->column;
         } else {
             lexer->token.name = TokenNameExclamationMark;
         }
@@ -319,18 +361,15 @@ bool lexer_tokenize(RaelLexer* const lexer) {
             lexer->token.length = 2;
             lexer->token.string = lexer->stream.cur;
             lexer->stream.cur += 2;
-            lexer->column += 2;
         } else if (lexer->stream.cur[1] == '=') { // <=
             lexer->token.name = TokenNameSmallerOrEqual;
             lexer->token.length = 2;
             lexer->token.string = lexer->stream.cur;
             lexer->stream.cur += 2;
-            lexer->column += 2;
         } else { // <
             lexer->token.name = TokenNameSmallerThan;
             lexer->token.length = 1;
             lexer->token.string = lexer->stream.cur++;
-            ++lexer->column;
         }
         return true;
     }
@@ -340,12 +379,10 @@ bool lexer_tokenize(RaelLexer* const lexer) {
             lexer->token.length = 2;
             lexer->token.string = lexer->stream.cur;
             lexer->stream.cur += 2;
-            lexer->column += 2;
         } else {
             lexer->token.name = TokenNameBiggerThan;
             lexer->token.length = 1;
             lexer->token.string = lexer->stream.cur++;
-            ++lexer->column;
         }
         return true;
     }
@@ -353,55 +390,87 @@ bool lexer_tokenize(RaelLexer* const lexer) {
         lexer->token.name = TokenNameCaret;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == '&') {
         lexer->token.name = TokenNameAmpersand;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
     if (lexer->stream.cur[0] == '|') {
         lexer->token.name = TokenNamePipe;
         lexer->token.length = 1;
         lexer->token.string = lexer->stream.cur++;
-        ++lexer->column;
         return true;
     }
 
-#define ADD_KEYWORD(keyword, token_name)                                                         \
-        do {                                                                                     \
-            if (lexer_match_keyword(lexer, keyword, sizeof(keyword)/sizeof(char)-1, token_name)) \
-                return true;                                                                     \
-        } while (0)
-    // try to lex keywords
-    ADD_KEYWORD("log", TokenNameLog);
-    ADD_KEYWORD("routine", TokenNameRoutine);
-    ADD_KEYWORD("if", TokenNameIf);
-    ADD_KEYWORD("else", TokenNameElse);
-    ADD_KEYWORD("loop", TokenNameLoop);
-    ADD_KEYWORD("Void", TokenNameVoid);
-    ADD_KEYWORD("at", TokenNameAt);
-    ADD_KEYWORD("sizeof", TokenNameSizeof);
-    ADD_KEYWORD("typeof", TokenNameTypeof);
-    ADD_KEYWORD("through", TokenNameThrough);
-    ADD_KEYWORD("to", TokenNameTo);
-    ADD_KEYWORD("blame", TokenNameBlame);
-    ADD_KEYWORD("catch", TokenNameCatch);
-    ADD_KEYWORD("with", TokenNameWith);
-    ADD_KEYWORD("show", TokenNameShow);
-    ADD_KEYWORD("getstring", TokenNameGetString);
-    ADD_KEYWORD("match", TokenNameMatch);
-    ADD_KEYWORD("skip", TokenNameSkip);
-    ADD_KEYWORD("break", TokenNameBreak);
-    ADD_KEYWORD("load", TokenNameLoad);
-#undef ADD_KEYWORD
+    // keywords
+    if (isalpha(lexer->stream.cur[0])) {
+        size_t length = 1;
+        enum TokenName name;
+
+        while (is_identifier_char(lexer->stream.cur[length]))
+            ++length;
+        if ((name = keyword_token_name(lexer->stream.cur, length))) {
+            lexer->token.name = name;
+            lexer->token.string = lexer->stream.cur;
+            lexer->token.length = length;
+            lexer->stream.cur += length;
+            return true;
+        }
+    }
 
     // if you couldn't match any token, error
-    lexer_error(lexer, "Unrecognized token");
-    return false;
+    return lexer_scan_error(lexer, "Unrecognized token");
+}
+
+void lexer_construct(RaelLexer *lexer, RaelStream *stream) {
+    size_t allocated = 64;
+    bool scanned;
+
+    stream_ptr_construct(&lexer->stream, stream, 0);
+    lexer->exit_handler = NULL;
+    lexer->error_message = NULL;
+    lexer->state = lexer_scan_state(lexer);
+    lexer->idx = 0;
+    lexer->amount_tokens = 0;
+    lexer->tokens = malloc(allocated * sizeof(struct LexedToken));
+
+    // scan the whole stream once. the last entry is the end of the stream or an error, and has no token
+    do {
+        struct LexedToken *lexed;
+
+        if (!(scanned = lexer_scan(lexer)))
+            lexer->token.name = (enum TokenName)0;
+        if (lexer->amount_tokens == allocated)
+            lexer->tokens = realloc(lexer->tokens, (allocated *= 2) * sizeof(struct LexedToken));
+        lexed = &lexer->tokens[lexer->amount_tokens++];
+        lexed->token = lexer->token;
+        lexed->end_state = lexer_scan_state(lexer);
+    } while (scanned);
+}
+
+void lexer_destruct(RaelLexer *lexer) {
+    free(lexer->tokens);
+    lexer->tokens = NULL;
+    stream_ptr_destruct(&lexer->stream);
+}
+
+bool lexer_tokenize(RaelLexer* const lexer) {
+    struct LexedToken *lexed = &lexer->tokens[lexer->idx];
+
+    lexer->state = lexed->end_state;
+    if (lexed->token.name == 0) {
+        // the error is only shown when the parser gets to it, like when the stream was lexed lazily
+        if (lexer->error_message)
+            lexer_error(lexer, "%s", lexer->error_message);
+        return false;
+    }
+
+    lexer->token = lexed->token;
+    ++lexer->idx;
+    return true;
 }
 
 char *token_allocate_key(struct Token* const token) {
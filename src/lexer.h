@@ -5,6 +5,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <setjmp.h>
 
 enum TokenName {
     TokenNameString = 1,
@@ -57,7 +58,8 @@ enum TokenName {
     TokenNameStarEquals,
     TokenNameSlashEquals,
     TokenNamePercentEquals,
-    TokenNameExclamationMarkEquals
+    TokenNameExclamationMarkEquals,
+    TokenNameYield
 };
 
 struct Token {
@@ -66,14 +68,34 @@ struct Token {
     size_t length;
 };
 
+/* a token in the token array, and the state of the lexer right after it */
+struct LexedToken {
+    struct Token token;
+    struct State end_state;
+};
+
+/*
+ * The lexer scans the whole stream once when it's constructed, into an array of tokens.
+ * Tokenizing goes to the next token in the array, and loading a state moves back to the token after it,
+ * so backtracking doesn't lex the same characters again.
+ */
 typedef struct RaelLexer {
     struct Token token;
+    /* the position of the scanner while the token array is built */
     RaelStreamPtr stream;
-    size_t line;
-    size_t column;
+    /* the tokens of the stream. the last one has no name and marks the end of the stream or an error */
+    struct LexedToken *tokens;
+    size_t amount_tokens;
+    /* the index of the next token, and the state after the last token */
+    size_t idx;
+    struct State state;
+    /* the error that scanning stopped on, or NULL */
+    const char *error_message;
+    /* if defined, errors jump here instead of exiting the process */
+    jmp_buf *exit_handler;
 } RaelLexer;
 
-/* constructs the lexer pointer */
+/* constructs the lexer pointer, and scans the stream */
 void lexer_construct(RaelLexer *lexer, RaelStream *stream);
 
 void lexer_destruct(RaelLexer *lexer);
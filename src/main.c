@@ -2,17 +2,23 @@
 
 static void print_help(void) {
     puts("Welcome to the Rael programming language!");
-    puts("usage: rael [--help | -h] | [[--string | -s] string | file] [--warn-undefined]");
+    puts("usage: rael [--help | -h] | [[--string | -s] string | file] [--warn-undefined] [--closures] [--jit | --no-jit] [--emit-c] [--cache]");
     puts("  --string or -s:   interprets a string of code");
     puts("  --help or -h:     shows this help message");
     puts("  --warn-undefined: shows warning when getting an undefined variable");
+    puts("  --closures:       evaluates expressions with closure compiled functions");
+    puts("  --jit:            compiles hot routines and loops to native code (x86-64 Linux only)");
+    puts("  --no-jit:         only interprets the code (the default)");
+    puts("  --emit-c:         writes the code compiled to C instead of running it (see 'make compile')");
+    puts("  --cache:          loads the parsed file from a cache next to it (file.raelc), and creates it if needed");
 }
 
 int main(int argc, char **argv) {
     RaelStream *stream;
     char **program_argv;
     size_t program_argc;
-    bool warn_undefined = false, stream_defined = false;
+    bool warn_undefined = false, closures = false, jit = false, emit_c = false, cache = false, stream_defined = false;
+    char *filename = NULL;
     RaelInstruction **parsed;
     RaelInterpreter interpreter;
 
@@ -25,6 +31,16 @@ int main(int argc, char **argv) {
         char *arg = argv[i];
         if (strcmp(arg, "--warn-undefined") == 0) {
             warn_undefined = true;
+        } else if (strcmp(arg, "--closures") == 0) {
+            closures = true;
+        } else if (strcmp(arg, "--jit") == 0) {
+            jit = true;
+        } else if (strcmp(arg, "--no-jit") == 0) {
+            jit = false;
+        } else if (strcmp(arg, "--emit-c") == 0) {
+            emit_c = true;
+        } else if (strcmp(arg, "--cache") == 0) {
+            cache = true;
         } else if (strcmp(arg, "--string") == 0 || strcmp(arg, "-s") == 0) {
             if (++i == argc) {
                 fprintf(stderr, "Expected an input string after '%s' flag\n", arg);
@@ -46,6 +62,7 @@ int main(int argc, char **argv) {
                 perror(arg);
                 return 1;
             }
+            filename = arg;
             // skip filename when setting argv
             ++i;
             program_argv = argv + i;
@@ -59,9 +76,30 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    parsed = rael_parse(stream);
+    // only files are cached, strings from the command line are always parsed
+    if (cache && filename) {
+        char *cache_path = rael_cache_path(filename);
+
+        if (!(parsed = rael_cache_load(cache_path, stream))) {
+            parsed = rael_parse(stream, NULL);
+            rael_cache_store(cache_path, parsed, stream);
+        }
+        free(cache_path);
+    } else {
+        parsed = rael_parse(stream, NULL);
+    }
+
+    if (emit_c) {
+        if (!rael_emit_c(stdout, parsed, stream)) {
+            fprintf(stderr, "Could not write the compiled code\n");
+            return 1;
+        }
+        return 0;
+    }
 
     interpreter_construct(&interpreter, parsed, stream, argv[0], program_argv, program_argc, warn_undefined);
+    interpreter.closures = closures;
+    interpreter.jit = jit;
     interpreter_interpret(&interpreter);
     interpreter_destruct(&interpreter);
 
@@ -414,6 +414,31 @@ RaelValue *file_method_close(RaelFileValue *self, RaelArgumentList *args, RaelIn
     return void_new();
 }
 
+/* iterating over a file reads it line by line, without the newlines, until the end of the file */
+static RaelValue *file_iter_next(RaelFileValue *self) {
+    size_t allocated = 0, length = 0;
+    char *line = NULL;
+    int c;
+
+    if (!self->is_open || !self->readable)
+        return NULL;
+
+    while ((c = getc(self->stream)) != EOF && c != '\n') {
+        if (length == allocated)
+            line = realloc(line, (allocated += 64) * sizeof(char));
+        line[length++] = (char)c;
+    }
+
+    // if there are no more lines
+    if (c == EOF && length == 0)
+        return NULL;
+    // remove the carriage return of windows line endings
+    if (length > 0 && line[length - 1] == '\r')
+        --length;
+
+    return string_new_pure(line, length, true);
+}
+
 static RaelConstructorInfo file_constructor_info = {
     (RaelConstructorFunc)file_construct,
     true,
@@ -449,11 +474,16 @@ RaelTypeValue RaelFileType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = (RaelIterNextFunc)file_iter_next,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = (MethodDecl[]) {
         RAEL_CMETHOD("close", file_method_close, 0, 0),
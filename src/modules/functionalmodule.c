@@ -1,8 +1,297 @@
 #include "rael.h"
 
+/* returns true if the value can be consumed by the functions of the module */
+static bool functional_can_iterate(RaelValue *value) {
+    return value_is_iterable(value) || value_is_iterator(value);
+}
+
+/*
+ * returns the next entry of an iterable or an iterator, or NULL if there are no more entries.
+ * `idx` is the index of the next entry in an iterable
+ */
+static RaelValue *functional_next(RaelValue *iterable, size_t *idx) {
+    if (value_is_iterator(iterable))
+        return value_iter_next(iterable);
+    // calculate length every time because values can always shrink/grow
+    if (*idx >= value_length(iterable))
+        return NULL;
+    return value_get(iterable, (*idx)++);
+}
+
+/*
+ * Lazy iterators are returned by :Iter, :Take, :Zip, :Enumerate, :Chunk, and by :Map and :Filter when
+ * they're given an iterator. Every stage pulls one entry at a time from the stage before it,
+ * so a pipeline of stages doesn't create any intermediate stacks.
+ * When a callable blames, the stage stops and produces the blame as its last entry.
+ */
+enum FunctionalIteratorKind {
+    FunctionalIteratorIter,
+    FunctionalIteratorMap,
+    FunctionalIteratorFilter,
+    FunctionalIteratorTake,
+    FunctionalIteratorZip,
+    FunctionalIteratorEnumerate,
+    FunctionalIteratorChunk
+};
+
+typedef struct RaelFunctionalIteratorValue {
+    RAEL_VALUE_BASE;
+    enum FunctionalIteratorKind kind;
+    /* an iterable for :Iter, and the iterator of the previous stage otherwise */
+    RaelValue *source;
+    /* the second iterator of :Zip */
+    RaelValue *other;
+    /* the callable of :Map and :Filter */
+    RaelValue *callable;
+    /* the next index of :Iter and :Enumerate */
+    size_t idx;
+    /* the entries left for :Take, and the size of the chunks of :Chunk */
+    size_t amount;
+    bool exhausted;
+    /* where the stage was created, for blames */
+    struct State state;
+    RaelInterpreter *interpreter;
+} RaelFunctionalIteratorValue;
+
+static RaelTypeValue RaelFunctionalIteratorType;
+
+static RaelValue *functional_iterator_new(enum FunctionalIteratorKind kind, RaelValue *source,
+                                          struct State state, RaelInterpreter *interpreter) {
+    RaelFunctionalIteratorValue *iterator = RAEL_VALUE_NEW(RaelFunctionalIteratorType, RaelFunctionalIteratorValue);
+
+    value_ref(source);
+    iterator->kind = kind;
+    iterator->source = source;
+    iterator->other = NULL;
+    iterator->callable = NULL;
+    iterator->idx = 0;
+    iterator->amount = 0;
+    iterator->exhausted = false;
+    iterator->state = state;
+    iterator->interpreter = interpreter;
+    return (RaelValue*)iterator;
+}
+
+/* returns an iterator over the value, which is the value itself if it's already an iterator */
+static RaelValue *functional_iterator_from(RaelValue *value, struct State state, RaelInterpreter *interpreter) {
+    if (value_is_iterator(value)) {
+        value_ref(value);
+        return value;
+    }
+    return functional_iterator_new(FunctionalIteratorIter, value, state, interpreter);
+}
+
+/* returns true if the entry ends the stage. a blame entry is passed on and ends every stage after it */
+static bool functional_iterator_ends(RaelFunctionalIteratorValue *self, RaelValue *entry) {
+    if (!entry || blame_validate(entry)) {
+        self->exhausted = true;
+        return true;
+    }
+    return false;
+}
+
+/* call the callable of the stage with an entry */
+static RaelValue *functional_iterator_call(RaelFunctionalIteratorValue *self, RaelValue *entry) {
+    RaelArgumentList callable_args;
+    RaelValue *result;
+
+    interpreter_push_arguments(self->interpreter, 1, &callable_args);
+    arguments_add(&callable_args, entry, self->state);
+    result = value_call(self->callable, &callable_args, self->interpreter);
+    interpreter_pop_arguments(self->interpreter, &callable_args);
+    return result;
+}
+
+static RaelValue *functional_iterator_next(RaelFunctionalIteratorValue *self) {
+    RaelValue *entry, *result;
+
+    if (self->exhausted)
+        return NULL;
+
+    switch (self->kind) {
+    case FunctionalIteratorIter:
+        // calculate length every time because values can always shrink/grow
+        if (self->idx >= value_length(self->source)) {
+            self->exhausted = true;
+            return NULL;
+        }
+        return value_get(self->source, self->idx++);
+    case FunctionalIteratorMap:
+        entry = value_iter_next(self->source);
+        if (functional_iterator_ends(self, entry))
+            return entry;
+        result = functional_iterator_call(self, entry);
+        value_deref(entry);
+        if (blame_validate(result)) {
+            value_deref(result);
+            self->exhausted = true;
+            return BLAME_NEW_CSTR_ST("Unhandled blame while running :Map", self->state);
+        }
+        return result;
+    case FunctionalIteratorFilter:
+        for (;;) {
+            bool is_truthy;
+
+            entry = value_iter_next(self->source);
+            if (functional_iterator_ends(self, entry))
+                return entry;
+            result = functional_iterator_call(self, entry);
+            if (blame_validate(result)) {
+                value_deref(result);
+                value_deref(entry);
+                self->exhausted = true;
+                return BLAME_NEW_CSTR_ST("Unhandled blame while running :Filter", self->state);
+            }
+            is_truthy = value_truthy(result);
+            value_deref(result);
+            if (is_truthy)
+                return entry;
+            value_deref(entry);
+        }
+    case FunctionalIteratorTake:
+        // don't pull from the source after the last entry, because it might never end
+        if (self->amount == 0) {
+            self->exhausted = true;
+            return NULL;
+        }
+        entry = value_iter_next(self->source);
+        if (functional_iterator_ends(self, entry))
+            return entry;
+        --self->amount;
+        return entry;
+    case FunctionalIteratorZip: {
+        RaelStackValue *pair;
+
+        entry = value_iter_next(self->source);
+        if (functional_iterator_ends(self, entry))
+            return entry;
+        result = value_iter_next(self->other);
+        if (functional_iterator_ends(self, result)) {
+            value_deref(entry);
+            return result;
+        }
+        pair = (RaelStackValue*)stack_new(2);
+        stack_push(pair, entry);
+        stack_push(pair, result);
+        value_deref(entry);
+        value_deref(result);
+        return (RaelValue*)pair;
+    }
+    case FunctionalIteratorEnumerate: {
+        RaelStackValue *pair;
+        RaelValue *index;
+
+        entry = value_iter_next(self->source);
+        if (functional_iterator_ends(self, entry))
+            return entry;
+        index = number_newi((RaelInt)self->idx++);
+        pair = (RaelStackValue*)stack_new(2);
+        stack_push(pair, index);
+        stack_push(pair, entry);
+        value_deref(index);
+        value_deref(entry);
+        return (RaelValue*)pair;
+    }
+    case FunctionalIteratorChunk: {
+        RaelStackValue *chunk;
+
+        entry = value_iter_next(self->source);
+        if (functional_iterator_ends(self, entry))
+            return entry;
+        chunk = (RaelStackValue*)stack_new(self->amount);
+        stack_push(chunk, entry);
+        value_deref(entry);
+        while (stack_length(chunk) < self->amount) {
+            entry = value_iter_next(self->source);
+            if (functional_iterator_ends(self, entry)) {
+                // a blame replaces the partial chunk
+                if (entry) {
+                    value_deref((RaelValue*)chunk);
+                    return entry;
+                }
+                break;
+            }
+            stack_push(chunk, entry);
+            value_deref(entry);
+        }
+        return (RaelValue*)chunk;
+    }
+    default:
+        RAEL_UNREACHABLE();
+        return NULL;
+    }
+}
+
+static void functional_iterator_delete(RaelFunctionalIteratorValue *self) {
+    value_deref(self->source);
+    if (self->other)
+        value_deref(self->other);
+    if (self->callable)
+        value_deref(self->callable);
+}
+
+static void functional_iterator_repr(RaelFunctionalIteratorValue *self) {
+    (void)self;
+    printf("[Iterator]");
+}
+
+static RaelTypeValue RaelFunctionalIteratorType = {
+    RAEL_TYPE_DEF_INIT,
+    .name = "Iterator",
+    .op_add = NULL,
+    .op_sub = NULL,
+    .op_mul = NULL,
+    .op_div = NULL,
+    .op_mod = NULL,
+    .op_red = NULL,
+    .op_eq = NULL,
+    .op_smaller = NULL,
+    .op_bigger = NULL,
+    .op_smaller_eq = NULL,
+    .op_bigger_eq = NULL,
+
+    .op_neg = NULL,
+
+    .callable_info = NULL,
+    .constructor_info = NULL,
+    .op_ref = NULL,
+    .op_deref = NULL,
+
+    .as_bool = NULL,
+    .deallocator = (RaelSingleFunc)functional_iterator_delete,
+    .repr = (RaelSingleFunc)functional_iterator_repr,
+    .logger = NULL, /* fallbacks to .repr */
+
+    .cast = NULL,
+    .copy = NULL,
+
+    .at_index = NULL,
+    .at_range = NULL,
+
+    .length = NULL,
+    .op_iter_next = (RaelIterNextFunc)functional_iterator_next,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
+
+    .methods = NULL
+};
+
+/* validate that the argument is a whole number that isn't negative, and put it in `out` */
+static RaelValue *functional_get_amount(RaelArgumentList *args, size_t idx, size_t *out) {
+    RaelValue *arg = arguments_get(args, idx);
+
+    if (arg->type != &RaelNumberType || !number_is_whole((RaelNumberValue*)arg))
+        return BLAME_NEW_CSTR_ST("Expected a whole number", *arguments_state(args, idx));
+    if (!number_positive((RaelNumberValue*)arg))
+        return BLAME_NEW_CSTR_ST("Expected a positive number", *arguments_state(args, idx));
+    *out = (size_t)number_to_int((RaelNumberValue*)arg);
+    return NULL;
+}
+
 RaelValue *module_functional_Map(RaelArgumentList *args, RaelInterpreter *interpreter) {
-    RaelValue *callable, *iterable;
-    size_t length;
+    RaelValue *callable, *iterable, *entry;
+    size_t idx = 0;
     RaelStackValue *mapped_stack;
     assert(arguments_amount(args) == 2);
 
@@ -16,20 +305,29 @@ RaelValue *module_functional_Map(RaelArgumentList *args, RaelInterpreter *interp
     }
 
     iterable = arguments_get(args, 1);
-    if (!value_is_iterable(iterable)) {
+    if (!functional_can_iterate(iterable)) {
         return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 1));
     }
 
-    length = value_length(iterable);
-    mapped_stack = (RaelStackValue*)stack_new(length);
+    // mapping an iterator is lazy
+    if (value_is_iterator(iterable)) {
+        RaelFunctionalIteratorValue *iterator;
+
+        iterator = (RaelFunctionalIteratorValue*)functional_iterator_new(FunctionalIteratorMap, iterable,
+                                                                          *arguments_state(args, 1), interpreter);
+        value_ref(callable);
+        iterator->callable = callable;
+        return (RaelValue*)iterator;
+    }
+
+    mapped_stack = (RaelStackValue*)stack_new(value_length(iterable));
 
-    for (size_t i = 0; i < length; ++i) {
+    while ((entry = functional_next(iterable, &idx))) {
         RaelArgumentList callable_args;
-        RaelValue *entry = value_get(iterable, i);
         RaelValue *result;
 
         // create argument list
-        arguments_new(&callable_args, 1);
+        interpreter_push_arguments(interpreter, 1, &callable_args);
         arguments_add(&callable_args, entry, *arguments_state(args, 1));
         value_deref(entry);
         // call and push the result
@@ -39,23 +337,23 @@ RaelValue *module_functional_Map(RaelArgumentList *args, RaelInterpreter *interp
             // deref blame and return a new less detailed one
             value_deref(result);
             stack_delete(mapped_stack);
-            arguments_delete(&callable_args);
+            interpreter_pop_arguments(interpreter, &callable_args);
             return BLAME_NEW_CSTR("Unhandled blame while running :Map");
         }
         stack_push(mapped_stack, result);
         value_deref(result);
 
         // delete arguments
-        arguments_delete(&callable_args);
+        interpreter_pop_arguments(interpreter, &callable_args);
     }
 
     return (RaelValue*)mapped_stack;
 }
 
 RaelValue *module_functional_Filter(RaelArgumentList *args, RaelInterpreter *interpreter) {
-    RaelValue *callable, *iterable;
+    RaelValue *callable, *iterable, *entry;
     RaelStackValue *filtered_stack;
-    size_t length;
+    size_t idx = 0;
 
     (void)interpreter;
     callable = arguments_get(args, 0);
@@ -68,20 +366,29 @@ RaelValue *module_functional_Filter(RaelArgumentList *args, RaelInterpreter *int
     }
 
     iterable = arguments_get(args, 1);
-    if (!value_is_iterable(iterable)) {
+    if (!functional_can_iterate(iterable)) {
         return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 1));
     }
 
+    // filtering an iterator is lazy
+    if (value_is_iterator(iterable)) {
+        RaelFunctionalIteratorValue *iterator;
+
+        iterator = (RaelFunctionalIteratorValue*)functional_iterator_new(FunctionalIteratorFilter, iterable,
+                                                                          *arguments_state(args, 1), interpreter);
+        value_ref(callable);
+        iterator->callable = callable;
+        return (RaelValue*)iterator;
+    }
+
     filtered_stack = (RaelStackValue *)stack_new(0);
-    length = value_length(iterable);
 
-    for (size_t i = 0; i < length; ++i) {
+    while ((entry = functional_next(iterable, &idx))) {
         RaelArgumentList callable_args;
-        RaelValue *entry = value_get(iterable, i);
         RaelValue *result;
 
         // create argument list
-        arguments_new(&callable_args, 1);
+        interpreter_push_arguments(interpreter, 1, &callable_args);
         arguments_add(&callable_args, entry, *arguments_state(args, 1));
         value_deref(entry);
         // call and check if truthy
@@ -90,7 +397,7 @@ RaelValue *module_functional_Filter(RaelArgumentList *args, RaelInterpreter *int
             // deref blame and return a new less detailed one
             value_deref(result);
             stack_delete(filtered_stack);
-            arguments_delete(&callable_args);
+            interpreter_pop_arguments(interpreter, &callable_args);
             return BLAME_NEW_CSTR("Unhandled blame while running :Filter");
         }
         // if truthy, push the entry
@@ -99,16 +406,16 @@ RaelValue *module_functional_Filter(RaelArgumentList *args, RaelInterpreter *int
         value_deref(result);
 
         // delete arguments
-        arguments_delete(&callable_args);
+        interpreter_pop_arguments(interpreter, &callable_args);
     }
 
     return (RaelValue*)filtered_stack;
 }
 
 RaelValue *module_functional_Reduce(RaelArgumentList *args, RaelInterpreter *interpreter) {
-    RaelValue *callable, *iterable;
+    RaelValue *callable, *iterable, *entry;
     RaelValue *reduced;
-    size_t length;
+    size_t idx = 0;
 
     (void)interpreter;
     callable = arguments_get(args, 0);
@@ -121,22 +428,27 @@ RaelValue *module_functional_Reduce(RaelArgumentList *args, RaelInterpreter *int
     }
 
     iterable = arguments_get(args, 1);
-    if (!value_is_iterable(iterable)) {
+    if (!functional_can_iterate(iterable)) {
         return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 1));
     }
-    if (value_length(iterable) == 0) {
+    if (!(reduced = functional_next(iterable, &idx))) {
         return BLAME_NEW_CSTR_ST("Expected iterable of size bigger than 0", *arguments_state(args, 1));
     }
-    reduced = value_get(iterable, 0);
-    length = value_length(iterable);
+    // a lazy iterator that failed
+    if (blame_validate(reduced))
+        return reduced;
 
-    for (size_t i = 1; i < length; ++i) {
+    while ((entry = functional_next(iterable, &idx))) {
         RaelArgumentList callable_args;
-        RaelValue *entry = value_get(iterable, i);
         RaelValue *result;
 
+        if (blame_validate(entry)) {
+            value_deref(reduced);
+            return entry;
+        }
+
         // create argument list
-        arguments_new(&callable_args, 2);
+        interpreter_push_arguments(interpreter, 2, &callable_args);
         arguments_add(&callable_args, reduced, *arguments_state(args, 1));
         arguments_add(&callable_args, entry, *arguments_state(args, 1));
         value_deref(entry);
@@ -146,19 +458,126 @@ RaelValue *module_functional_Reduce(RaelArgumentList *args, RaelInterpreter *int
             // deref blame and return a new less detailed one
             value_deref(result);
             value_deref(reduced);
-            arguments_delete(&callable_args);
+            interpreter_pop_arguments(interpreter, &callable_args);
             return BLAME_NEW_CSTR("Unhandled blame while running :Reduce");
         }
         value_deref(reduced);
         reduced = result;
 
         // delete arguments
-        arguments_delete(&callable_args);
+        interpreter_pop_arguments(interpreter, &callable_args);
     }
 
     return reduced;
 }
 
+/* :Iter(iterable) returns a lazy iterator over the iterable */
+RaelValue *module_functional_Iter(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *iterable;
+
+    assert(arguments_amount(args) == 1);
+    iterable = arguments_get(args, 0);
+    if (!functional_can_iterate(iterable)) {
+        return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 0));
+    }
+
+    return functional_iterator_from(iterable, *arguments_state(args, 0), interpreter);
+}
+
+/* creates a stage of a pipeline over the first argument */
+static RaelValue *functional_stage_new(enum FunctionalIteratorKind kind, RaelArgumentList *args,
+                                       RaelInterpreter *interpreter) {
+    RaelValue *iterable, *source, *iterator;
+
+    iterable = arguments_get(args, 0);
+    if (!functional_can_iterate(iterable)) {
+        return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 0));
+    }
+
+    source = functional_iterator_from(iterable, *arguments_state(args, 0), interpreter);
+    iterator = functional_iterator_new(kind, source, *arguments_state(args, 0), interpreter);
+    value_deref(source);
+    return iterator;
+}
+
+/* :Take(iterable, amount) lazily takes the first `amount` entries */
+RaelValue *module_functional_Take(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *iterator;
+    size_t amount;
+
+    assert(arguments_amount(args) == 2);
+    if ((iterator = functional_get_amount(args, 1, &amount)))
+        return iterator;
+    if (!blame_validate(iterator = functional_stage_new(FunctionalIteratorTake, args, interpreter)))
+        ((RaelFunctionalIteratorValue*)iterator)->amount = amount;
+
+    return iterator;
+}
+
+/* :Zip(iterable1, iterable2) lazily pairs the entries of two iterables, until one of them ends */
+RaelValue *module_functional_Zip(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *other, *iterator;
+
+    assert(arguments_amount(args) == 2);
+    other = arguments_get(args, 1);
+    if (!functional_can_iterate(other)) {
+        return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 1));
+    }
+    if (!blame_validate(iterator = functional_stage_new(FunctionalIteratorZip, args, interpreter)))
+        ((RaelFunctionalIteratorValue*)iterator)->other = functional_iterator_from(other, *arguments_state(args, 1),
+                                                                                 interpreter);
+
+    return iterator;
+}
+
+/* :Enumerate(iterable) lazily pairs every entry with its index */
+RaelValue *module_functional_Enumerate(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    assert(arguments_amount(args) == 1);
+    return functional_stage_new(FunctionalIteratorEnumerate, args, interpreter);
+}
+
+/* :Chunk(iterable, size) lazily groups the entries into stacks of `size` entries */
+RaelValue *module_functional_Chunk(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *iterator;
+    size_t size;
+
+    assert(arguments_amount(args) == 2);
+    if ((iterator = functional_get_amount(args, 1, &size)))
+        return iterator;
+    if (size == 0)
+        return BLAME_NEW_CSTR_ST("Expected a chunk size bigger than 0", *arguments_state(args, 1));
+    if (!blame_validate(iterator = functional_stage_new(FunctionalIteratorChunk, args, interpreter)))
+        ((RaelFunctionalIteratorValue*)iterator)->amount = size;
+
+    return iterator;
+}
+
+/* :Collect(iterable) runs a pipeline and returns a stack of its entries */
+RaelValue *module_functional_Collect(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *iterable, *entry;
+    RaelStackValue *collected;
+    size_t idx = 0;
+
+    (void)interpreter;
+    assert(arguments_amount(args) == 1);
+    iterable = arguments_get(args, 0);
+    if (!functional_can_iterate(iterable)) {
+        return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 0));
+    }
+
+    collected = (RaelStackValue*)stack_new(0);
+    while ((entry = functional_next(iterable, &idx))) {
+        if (blame_validate(entry)) {
+            value_deref((RaelValue*)collected);
+            return entry;
+        }
+        stack_push(collected, entry);
+        value_deref(entry);
+    }
+
+    return (RaelValue*)collected;
+}
+
 RaelValue *module_functional_new(RaelInterpreter *interpreter) {
     RaelModuleValue *m;
 
@@ -167,6 +586,12 @@ RaelValue *module_functional_new(RaelInterpreter *interpreter) {
     module_set_key(m, RAEL_HEAPSTR("Map"), cfunc_new(RAEL_HEAPSTR("Map"), module_functional_Map, 2));
     module_set_key(m, RAEL_HEAPSTR("Filter"), cfunc_new(RAEL_HEAPSTR("Filter"), module_functional_Filter, 2));
     module_set_key(m, RAEL_HEAPSTR("Reduce"), cfunc_new(RAEL_HEAPSTR("Reduce"), module_functional_Reduce, 2));
+    module_set_key(m, RAEL_HEAPSTR("Iter"), cfunc_new(RAEL_HEAPSTR("Iter"), module_functional_Iter, 1));
+    module_set_key(m, RAEL_HEAPSTR("Take"), cfunc_new(RAEL_HEAPSTR("Take"), module_functional_Take, 2));
+    module_set_key(m, RAEL_HEAPSTR("Zip"), cfunc_new(RAEL_HEAPSTR("Zip"), module_functional_Zip, 2));
+    module_set_key(m, RAEL_HEAPSTR("Enumerate"), cfunc_new(RAEL_HEAPSTR("Enumerate"), module_functional_Enumerate, 1));
+    module_set_key(m, RAEL_HEAPSTR("Chunk"), cfunc_new(RAEL_HEAPSTR("Chunk"), module_functional_Chunk, 2));
+    module_set_key(m, RAEL_HEAPSTR("Collect"), cfunc_new(RAEL_HEAPSTR("Collect"), module_functional_Collect, 1));
 
     return (RaelValue*)m;
 }
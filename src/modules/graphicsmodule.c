@@ -25,6 +25,7 @@ RaelTypeValue RaelSurfaceType;
 
 typedef struct RaelColorValue {
     RAEL_VALUE_BASE;
+    RaelFields fields;
     uint8_t r, g, b;
 } RaelColorValue;
 RaelTypeValue RaelColorType;
@@ -157,11 +158,16 @@ RaelTypeValue RaelWindowType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = (MethodDecl[]) {
         RAEL_CMETHOD("getSurface", window_method_getSurface, 0, 0),
@@ -474,11 +480,16 @@ RaelTypeValue RaelSurfaceType = {
     .logger = NULL,
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = (MethodDecl[]) {
         RAEL_CMETHOD("drawPixel", surface_method_drawPixel, 3, 3),
@@ -495,9 +506,10 @@ RaelValue *color_new(uint8_t r, uint8_t g, uint8_t b) {
     self->r = r;
     self->g = g;
     self->b = b;
-    value_set_key((RaelValue*)self, RAEL_HEAPSTR("R"), number_newi(r));
-    value_set_key((RaelValue*)self, RAEL_HEAPSTR("G"), number_newi(g));
-    value_set_key((RaelValue*)self, RAEL_HEAPSTR("B"), number_newi(b));
+    fields_new(&self->fields);
+    value_set_int((RaelValue*)self, RAEL_HEAPSTR("R"), r);
+    value_set_int((RaelValue*)self, RAEL_HEAPSTR("G"), g);
+    value_set_int((RaelValue*)self, RAEL_HEAPSTR("B"), b);
     return (RaelValue*)self;
 }
 
@@ -590,11 +602,16 @@ RaelTypeValue RaelColorType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = offsetof(RaelColorValue, fields),
 
     .methods = NULL
 };
@@ -220,6 +220,8 @@ RaelValue *module_math_new(RaelInterpreter *interpreter) {
     module_set_key(m, RAEL_HEAPSTR("Max"), cfunc_new(RAEL_HEAPSTR("Max"), module_math_Max, 2));
     module_set_key(m, RAEL_HEAPSTR("Min"), cfunc_new(RAEL_HEAPSTR("Min"), module_math_Min, 2));
     module_set_key(m, RAEL_HEAPSTR("Pow"), cfunc_new(RAEL_HEAPSTR("Pow"), module_math_Pow, 2));
+    value_ref((RaelValue*)&RaelNumArrayType);
+    module_set_key(m, RAEL_HEAPSTR("NumArray"), (RaelValue*)&RaelNumArrayType);
     module_set_key(m, RAEL_HEAPSTR("PI"), number_newf(RAEL_CONSTANT_PI));
     module_set_key(m, RAEL_HEAPSTR("2PI"), number_newf(RAEL_CONSTANT_2PI));
     module_set_key(m, RAEL_HEAPSTR("E"), number_newf(RAEL_CONSTANT_E));
@@ -1,15 +1,8 @@
 #include "rael.h"
 
-static RaelInt get_random(void) {
-    const size_t times_generate = sizeof(RaelInt) / sizeof(RAND_MAX);
-    RaelInt generated = 0;
-
-    for (size_t i = 0; i < times_generate; ++i) {
-        int rand_chunk = rand();
-        generated += (RaelInt)rand_chunk << (RaelInt)(i * (sizeof(RAND_MAX) * 8));
-    }
-
-    return generated;
+static RaelInt get_random(RaelInterpreter *interpreter) {
+    // keep the generated number non-negative
+    return (RaelInt)(interpreter_random(interpreter) >> 1);
 }
 
 RaelValue *module_random_RandomRange(RaelArgumentList *args, RaelInterpreter *interpreter) {
@@ -18,7 +11,6 @@ RaelValue *module_random_RandomRange(RaelArgumentList *args, RaelInterpreter *in
     size_t length, idx;
     RaelInt generated_number;
 
-    (void)interpreter;
     assert(arguments_amount(args) == 1);
 
     arg1 = arguments_get(args, 0);
@@ -33,16 +25,15 @@ RaelValue *module_random_RandomRange(RaelArgumentList *args, RaelInterpreter *in
     }
 
     // get the index of the range
-    idx = (size_t)((get_random() % (RaelInt)length) + (RaelInt)length) % length;
+    idx = (size_t)((get_random(interpreter) % (RaelInt)length) + (RaelInt)length) % length;
     generated_number = range_at(range, idx);
 
     return number_newi(generated_number);
 }
 
 RaelValue *module_random_RandomFloat(RaelArgumentList *args, RaelInterpreter *interpreter) {
-    (void)interpreter;
     assert(arguments_amount(args) == 0);
-    return number_newf((RaelFloat)get_random() / (RaelFloat)RAELINT_MAX);
+    return number_newf((RaelFloat)get_random(interpreter) / (RaelFloat)RAELINT_MAX);
 }
 
 RaelValue *module_random_new(RaelInterpreter *interpreter) {
@@ -1,17 +1,68 @@
 #include "rael.h"
 
+#include <pthread.h>
+
 /*
  * This is the source code for Rael's :System module,
  * which gives access to system related functions.
  */
 
+typedef struct RaelFutureValue RaelFutureValue;
+
 typedef struct RaelInstanceValue {
     RAEL_VALUE_BASE;
     RaelInstance *instance;
     char *name;
+    /* the future of the code running on the instance in a different thread, if there is one */
+    RaelFutureValue *future;
 } RaelInstanceValue;
 
+/*
+ * A future is returned from :instance:runAsync and represents code that runs on an instance
+ * in a different thread, with its own interpreter.
+ * While the code runs, the instance can't be used by other threads.
+ */
+struct RaelFutureValue {
+    RAEL_VALUE_BASE;
+    RaelInstanceValue *instancevalue;
+    RaelStream *stream;
+    pthread_t thread;
+    bool joined;
+    /* set by the running thread when it finishes */
+    bool finished;
+    int exit_code;
+
+    /* information for the interpreter of the thread */
+    char *exec_path;
+    char **argv;
+    size_t argc;
+    RaelStream *main_stream;
+    bool warn_undefined;
+    bool closures;
+    bool jit;
+};
+
 RaelTypeValue RaelInstanceType;
+RaelTypeValue RaelFutureType;
+
+/* wait for the thread of the future to finish, and let other threads use the instance again */
+static void future_join(RaelFutureValue *self) {
+    if (!self->joined) {
+        pthread_join(self->thread, NULL);
+        self->joined = true;
+        self->instancevalue->future = NULL;
+    }
+}
+
+/* returns a blame if the instance is still running code in a different thread, and NULL otherwise */
+static RaelValue *instancevalue_verify_idle(RaelInstanceValue *self) {
+    if (self->future) {
+        if (!__atomic_load_n(&self->future->finished, __ATOMIC_ACQUIRE))
+            return BLAME_NEW_CSTR("Instance is running in a different thread");
+        future_join(self->future);
+    }
+    return NULL;
+}
 
 void instancevalue_delete(RaelInstanceValue *self) {
     instance_delete(self->instance);
@@ -36,6 +87,7 @@ RaelValue *instancevalue_construct(RaelArgumentList *args, RaelInterpreter *inte
     instancevalue = RAEL_VALUE_NEW(RaelInstanceType, RaelInstanceValue);
     instancevalue->name = name;
     instancevalue->instance = instance;
+    instancevalue->future = NULL;
 
     return (RaelValue*)instancevalue;
 }
@@ -49,6 +101,8 @@ static RaelValue *instancevalue_method_run(RaelInstanceValue *self, RaelArgument
 
     assert(arguments_amount(args) == 1);
 
+    if ((arg1 = instancevalue_verify_idle(self)))
+        return arg1;
     arg1 = arguments_get(args, 0);
     if (arg1->type != &RaelStringType)
         return BLAME_NEW_CSTR_ST("Expected a string", *arguments_state(args, 0));
@@ -58,7 +112,7 @@ static RaelValue *instancevalue_method_run(RaelInstanceValue *self, RaelArgument
     // create stream
     stream = stream_new(code, string_length(string), true, self->name);
 
-    instructions = rael_parse(stream);
+    instructions = rael_parse(stream, interpreter->exit_handler);
     self->instance->instructions = instructions;
     stream_ref(stream);
     self->instance->stream = stream;
@@ -81,10 +135,12 @@ static RaelValue *instancevalue_method_eval(RaelInstanceValue *self, RaelArgumen
     char *code;
     RaelStream *stream;
     struct Expr *expr;
-    RaelValue *result;
+    RaelValue *result, *copy;
 
     assert(arguments_amount(args) == 1);
 
+    if ((arg1 = instancevalue_verify_idle(self)))
+        return arg1;
     arg1 = arguments_get(args, 0);
     if (arg1->type != &RaelStringType)
         return BLAME_NEW_CSTR_ST("Expected a string", *arguments_state(args, 0));
@@ -93,7 +149,7 @@ static RaelValue *instancevalue_method_eval(RaelInstanceValue *self, RaelArgumen
 
     // create stream
     stream = stream_new(code, string_length(string), true, self->name);
-    expr = rael_parse_expr(stream);
+    expr = rael_parse_expr(stream, interpreter->exit_handler);
 
     stream_ref(stream);
     self->instance->stream = stream;
@@ -106,20 +162,165 @@ static RaelValue *instancevalue_method_eval(RaelInstanceValue *self, RaelArgumen
     stream_deref(stream); // and one time for the local reference
     self->instance->stream = NULL;
 
-    return result;
+    // values of the instance may later be used by a different thread, so only a copy is returned
+    copy = value_copy(result);
+    value_deref(result);
+    if (!copy)
+        return BLAME_NEW_CSTR("Value can't be copied from an instance");
+
+    return copy;
 }
 
 static RaelValue *instancevalue_method_resetScope(RaelInstanceValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
-    (void)interpreter;
+    RaelValue *blame;
 
+    (void)interpreter;
     assert(arguments_amount(args) == 0);
 
+    if ((blame = instancevalue_verify_idle(self)))
+        return blame;
+
     scope_deref(self->instance->scope);
     self->instance->scope = scope_new(NULL);
 
     return void_new();
 }
 
+/* run the code of the future on its instance, with a new interpreter. called in a new thread */
+static void *future_run(void *arg) {
+    RaelFutureValue *future = arg;
+    RaelInstance *instance = future->instancevalue->instance;
+    struct Scope *scope = instance->scope;
+    RaelInstruction **volatile instructions = NULL;
+    RaelInterpreter interpreter;
+    RaelInstance *base;
+    jmp_buf exit_handler;
+
+    interpreter_construct(&interpreter, NULL, NULL, future->exec_path, future->argv, future->argc,
+                          future->warn_undefined);
+    interpreter.closures = future->closures;
+    interpreter.jit = future->jit;
+    interpreter.main_stream = future->main_stream;
+    base = interpreter.instance;
+    instance->stream = future->stream;
+
+    // syntax errors jump to the exit handler without setting an exit code
+    interpreter.exit_code = 1;
+    interpreter.exit_handler = &exit_handler;
+    if (setjmp(exit_handler)) {
+        interpreter_recover(&interpreter, base, base->scope);
+        instance->scope = scope;
+        instance->interrupt = ProgramInterruptNone;
+        future->exit_code = interpreter.exit_code;
+    } else {
+        instructions = rael_parse(future->stream, &exit_handler);
+        instance->instructions = instructions;
+        interpreter_push_instance(&interpreter, instance);
+        interpreter_interpret(&interpreter);
+        interpreter_pop_instance(&interpreter);
+        future->exit_code = 0;
+    }
+    interpreter.exit_handler = NULL;
+
+    if (instructions)
+        block_delete(instructions);
+    instance->instructions = NULL;
+    instance->stream = NULL;
+    stream_deref(future->stream);
+    interpreter_destruct(&interpreter);
+
+    __atomic_store_n(&future->finished, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static RaelValue *instancevalue_method_runAsync(RaelInstanceValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *arg1;
+    RaelStringValue *string;
+    RaelFutureValue *future;
+
+    assert(arguments_amount(args) == 1);
+
+    if ((arg1 = instancevalue_verify_idle(self)))
+        return arg1;
+    arg1 = arguments_get(args, 0);
+    if (arg1->type != &RaelStringType)
+        return BLAME_NEW_CSTR_ST("Expected a string", *arguments_state(args, 0));
+    string = (RaelStringValue*)arg1;
+
+    future = RAEL_VALUE_NEW(RaelFutureType, RaelFutureValue);
+    value_ref((RaelValue*)self);
+    future->instancevalue = self;
+    future->stream = stream_new(string_to_cstr(string), string_length(string), true, self->name);
+    future->joined = false;
+    future->finished = false;
+    future->exit_code = 0;
+    future->exec_path = interpreter->exec_path;
+    future->argv = interpreter->argv;
+    future->argc = interpreter->argc;
+    future->main_stream = interpreter->main_stream;
+    future->warn_undefined = interpreter->warn_undefined;
+    future->closures = interpreter->closures;
+    future->jit = interpreter->jit;
+
+    if (pthread_create(&future->thread, NULL, future_run, future) != 0) {
+        // there's no thread to join
+        future->joined = true;
+        stream_deref(future->stream);
+        value_deref((RaelValue*)future);
+        return BLAME_NEW_CSTR("Unable to create a thread");
+    }
+    self->future = future;
+
+    return (RaelValue*)future;
+}
+
+/* :instance:set(key, value) sets a copy of the value in the instance's scope */
+static RaelValue *instancevalue_method_set(RaelInstanceValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *key, *value;
+
+    (void)interpreter;
+    assert(arguments_amount(args) == 2);
+
+    if ((value = instancevalue_verify_idle(self)))
+        return value;
+    key = arguments_get(args, 0);
+    if (key->type != &RaelStringType)
+        return BLAME_NEW_CSTR_ST("Expected a string", *arguments_state(args, 0));
+    if (!(value = value_copy(arguments_get(args, 1))))
+        return BLAME_NEW_CSTR_ST("Value can't be copied to an instance", *arguments_state(args, 1));
+
+    scope_set(self->instance->scope, string_to_cstr((RaelStringValue*)key), value, true);
+    value_deref(value);
+
+    return void_new();
+}
+
+/* :instance:get(key) returns a copy of the value in the instance's scope */
+static RaelValue *instancevalue_method_get(RaelInstanceValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *key, *value, *copy;
+    char *key_cstr;
+
+    (void)interpreter;
+    assert(arguments_amount(args) == 1);
+
+    if ((value = instancevalue_verify_idle(self)))
+        return value;
+    key = arguments_get(args, 0);
+    if (key->type != &RaelStringType)
+        return BLAME_NEW_CSTR_ST("Expected a string", *arguments_state(args, 0));
+
+    key_cstr = string_to_cstr((RaelStringValue*)key);
+    value = scope_get(self->instance->scope, key_cstr, false);
+    free(key_cstr);
+
+    copy = value_copy(value);
+    value_deref(value);
+    if (!copy)
+        return BLAME_NEW_CSTR("Value can't be copied from an instance");
+
+    return copy;
+}
+
 static void instancevalue_repr(RaelInstanceValue *self) {
     printf("[Instance \"%s\"]", self->name);
 }
@@ -159,16 +360,473 @@ RaelTypeValue RaelInstanceType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = (MethodDecl[]) {
         RAEL_CMETHOD("run", instancevalue_method_run, 1, 1),
         RAEL_CMETHOD("eval", instancevalue_method_eval, 1, 1),
         RAEL_CMETHOD("resetScope", instancevalue_method_resetScope, 0, 0),
+        RAEL_CMETHOD("runAsync", instancevalue_method_runAsync, 1, 1),
+        RAEL_CMETHOD("set", instancevalue_method_set, 2, 2),
+        RAEL_CMETHOD("get", instancevalue_method_get, 1, 1),
+        RAEL_CMETHOD_TERMINATOR
+    }
+};
+
+void future_delete(RaelFutureValue *self) {
+    future_join(self);
+    value_deref((RaelValue*)self->instancevalue);
+}
+
+/* :future:wait() waits for the code to finish, and returns its exit code */
+static RaelValue *future_method_wait(RaelFutureValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    (void)args;
+    (void)interpreter;
+    assert(arguments_amount(args) == 0);
+
+    future_join(self);
+    return number_newi((RaelInt)self->exit_code);
+}
+
+/* :future:done() returns whether the code finished running */
+static RaelValue *future_method_done(RaelFutureValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    (void)args;
+    (void)interpreter;
+    assert(arguments_amount(args) == 0);
+
+    return number_newi(__atomic_load_n(&self->finished, __ATOMIC_ACQUIRE));
+}
+
+static void future_repr(RaelFutureValue *self) {
+    printf("[Future \"%s\"]", self->instancevalue->name);
+}
+
+RaelTypeValue RaelFutureType = {
+    RAEL_TYPE_DEF_INIT,
+    .name = "Future",
+    .op_add = NULL,
+    .op_sub = NULL,
+    .op_mul = NULL,
+    .op_div = NULL,
+    .op_mod = NULL,
+    .op_red = NULL,
+    .op_eq = NULL,
+    .op_smaller = NULL,
+    .op_bigger = NULL,
+    .op_smaller_eq = NULL,
+    .op_bigger_eq = NULL,
+
+    .op_neg = NULL,
+
+    .callable_info = NULL,
+    .constructor_info = NULL,
+    .op_ref = NULL,
+    .op_deref = NULL,
+
+    .as_bool = NULL,
+    .deallocator = (RaelSingleFunc)future_delete,
+    .repr = (RaelSingleFunc)future_repr,
+    .logger = NULL, /* fallbacks to .repr */
+
+    .cast = NULL,
+    .copy = NULL,
+
+    .at_index = NULL,
+    .at_range = NULL,
+
+    .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
+
+    .methods = (MethodDecl[]) {
+        RAEL_CMETHOD("wait", future_method_wait, 0, 0),
+        RAEL_CMETHOD("done", future_method_done, 0, 0),
+        RAEL_CMETHOD_TERMINATOR
+    }
+};
+
+/*
+ * A channel is a bounded queue of values that can be shared between instances that run in different threads.
+ * The queue is a lock-free ring buffer which supports multiple senders and multiple receivers at once.
+ * Every cell holds a sequence number which tells whether the cell is ready to be written or read
+ * in the current round of the ring.
+ *
+ * Threads that have to wait (a receive from an empty channel or a send to a full one) sleep on a condition
+ * variable. Sends and closing the channel are done under its lock, so a value is either queued before the
+ * channel is closed or not sent at all, and a receiver that saw that the channel is closed sees every value
+ * that was sent.
+ */
+typedef struct RaelChannelCell {
+    /*
+     * the cell is free for position `pos` when the sequence is pos * 2, and holds its value when it's pos * 2 + 1.
+     * the states are kept apart so they can't be mistaken for each other in a ring of a single cell
+     */
+    size_t sequence;
+    RaelValue *value;
+} RaelChannelCell;
+
+typedef struct RaelChannel {
+    size_t refcount;
+    size_t capacity;
+    RaelChannelCell *cells;
+    size_t enqueue_pos;
+    size_t dequeue_pos;
+    bool closed;
+    pthread_mutex_t lock;
+    /* signaled when a value is queued or received, and when the channel is closed */
+    pthread_cond_t changed;
+    /* the amount of threads that are waiting for `changed` */
+    size_t waiting;
+} RaelChannel;
+
+/* every thread has its own handle to the channel, because the refcount of values isn't atomic */
+typedef struct RaelChannelValue {
+    RAEL_VALUE_BASE;
+    RaelChannel *channel;
+} RaelChannelValue;
+
+RaelTypeValue RaelChannelType;
+
+static RaelValue *channelvalue_new(RaelChannel *channel) {
+    RaelChannelValue *channelvalue = RAEL_VALUE_NEW(RaelChannelType, RaelChannelValue);
+    __atomic_add_fetch(&channel->refcount, 1, __ATOMIC_RELAXED);
+    channelvalue->channel = channel;
+    return (RaelValue*)channelvalue;
+}
+
+/* returns true if the value was queued, and false if the channel is full */
+static bool channel_try_send(RaelChannel *self, RaelValue *value) {
+    size_t pos = __atomic_load_n(&self->enqueue_pos, __ATOMIC_RELAXED);
+    RaelChannelCell *cell;
+
+    for (;;) {
+        size_t sequence;
+        intptr_t difference;
+
+        cell = &self->cells[pos % self->capacity];
+        sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        difference = (intptr_t)sequence - (intptr_t)(pos * 2);
+
+        if (difference == 0) {
+            // the cell is free in this round, try to claim it
+            if (__atomic_compare_exchange_n(&self->enqueue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (difference < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&self->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->value = value;
+    __atomic_store_n(&cell->sequence, pos * 2 + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* returns the next value in the channel, or NULL if the channel is empty */
+static RaelValue *channel_try_receive(RaelChannel *self) {
+    size_t pos = __atomic_load_n(&self->dequeue_pos, __ATOMIC_RELAXED);
+    RaelChannelCell *cell;
+    RaelValue *value;
+
+    for (;;) {
+        size_t sequence;
+        intptr_t difference;
+
+        cell = &self->cells[pos % self->capacity];
+        sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        difference = (intptr_t)sequence - (intptr_t)(pos * 2 + 1);
+
+        if (difference == 0) {
+            // the cell was written in this round, try to claim it
+            if (__atomic_compare_exchange_n(&self->dequeue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (difference < 0) {
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&self->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    value = cell->value;
+    // free the cell for the next round of the ring
+    __atomic_store_n(&cell->sequence, (pos + self->capacity) * 2, __ATOMIC_RELEASE);
+    return value;
+}
+
+static bool channel_is_closed(RaelChannel *self) {
+    return __atomic_load_n(&self->closed, __ATOMIC_ACQUIRE);
+}
+
+/* wake up the threads that wait for the channel to change, if there are any */
+static void channel_notify(RaelChannel *self) {
+    // a waiting thread counts itself before it tries again, so either its try sees the change or this sees it
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&self->waiting, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&self->lock);
+        pthread_cond_broadcast(&self->changed);
+        pthread_mutex_unlock(&self->lock);
+    }
+}
+
+/* wait for the channel to change. the lock must be held, and the thread must be counted in `waiting` */
+static void channel_wait(RaelChannel *self) {
+    pthread_cond_wait(&self->changed, &self->lock);
+}
+
+/* wait for a value. returns NULL if the channel is closed and there are no more values in it */
+static RaelValue *channel_receive(RaelChannel *self) {
+    RaelValue *value;
+
+    if (!(value = channel_try_receive(self))) {
+        pthread_mutex_lock(&self->lock);
+        for (;;) {
+            __atomic_add_fetch(&self->waiting, 1, __ATOMIC_SEQ_CST);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if ((value = channel_try_receive(self)))
+                break;
+            // values are sent before the channel is closed, so the last try sees all of them
+            if (channel_is_closed(self)) {
+                value = channel_try_receive(self);
+                break;
+            }
+            channel_wait(self);
+            __atomic_sub_fetch(&self->waiting, 1, __ATOMIC_SEQ_CST);
+        }
+        __atomic_sub_fetch(&self->waiting, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&self->lock);
+    }
+    // a sender can be waiting for room
+    if (value)
+        channel_notify(self);
+    return value;
+}
+
+/* queue a value, and wait while the channel is full. returns false if the channel is closed */
+static bool channel_send(RaelChannel *self, RaelValue *value) {
+    bool sent = false;
+
+    pthread_mutex_lock(&self->lock);
+    for (;;) {
+        __atomic_add_fetch(&self->waiting, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (channel_is_closed(self))
+            break;
+        if ((sent = channel_try_send(self, value)))
+            break;
+        channel_wait(self);
+        __atomic_sub_fetch(&self->waiting, 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_sub_fetch(&self->waiting, 1, __ATOMIC_SEQ_CST);
+    if (sent && __atomic_load_n(&self->waiting, __ATOMIC_SEQ_CST) > 0)
+        pthread_cond_broadcast(&self->changed);
+    pthread_mutex_unlock(&self->lock);
+    return sent;
+}
+
+/* stop the channel from accepting values, and wake up the threads that wait for it */
+static void channel_close(RaelChannel *self) {
+    pthread_mutex_lock(&self->lock);
+    __atomic_store_n(&self->closed, true, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&self->changed);
+    pthread_mutex_unlock(&self->lock);
+}
+
+void channelvalue_delete(RaelChannelValue *self) {
+    RaelChannel *channel = self->channel;
+    RaelValue *value;
+
+    if (__atomic_sub_fetch(&channel->refcount, 1, __ATOMIC_ACQ_REL) > 0)
+        return;
+
+    // this was the last handle to the channel, so no other thread can use it
+    while ((value = channel_try_receive(channel)))
+        value_deref(value);
+    pthread_cond_destroy(&channel->changed);
+    pthread_mutex_destroy(&channel->lock);
+    free(channel->cells);
+    free(channel);
+}
+
+RaelValue *channelvalue_construct(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelInt capacity = 64;
+    RaelChannel *channel;
+
+    (void)interpreter;
+    assert(arguments_amount(args) <= 1);
+
+    if (arguments_amount(args) == 1) {
+        RaelValue *arg1 = arguments_get(args, 0);
+        if (arg1->type != &RaelNumberType || !number_is_whole((RaelNumberValue*)arg1))
+            return BLAME_NEW_CSTR_ST("Expected a whole number", *arguments_state(args, 0));
+        capacity = number_to_int((RaelNumberValue*)arg1);
+        if (capacity <= 0)
+            return BLAME_NEW_CSTR_ST("Expected a positive capacity", *arguments_state(args, 0));
+    }
+
+    channel = malloc(sizeof(RaelChannel));
+    channel->refcount = 0;
+    channel->capacity = (size_t)capacity;
+    channel->cells = malloc(channel->capacity * sizeof(RaelChannelCell));
+    for (size_t i = 0; i < channel->capacity; ++i) {
+        channel->cells[i].sequence = i * 2;
+        channel->cells[i].value = NULL;
+    }
+    channel->enqueue_pos = 0;
+    channel->dequeue_pos = 0;
+    channel->closed = false;
+    pthread_mutex_init(&channel->lock, NULL);
+    pthread_cond_init(&channel->changed, NULL);
+    channel->waiting = 0;
+
+    return channelvalue_new(channel);
+}
+
+/* copying a channel returns a new handle to the same channel */
+static RaelValue *channelvalue_copy(RaelChannelValue *self) {
+    return channelvalue_new(self->channel);
+}
+
+/* :channel:send(value) sends a copy of the value, and waits if the channel is full */
+static RaelValue *channelvalue_method_send(RaelChannelValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *value;
+
+    (void)interpreter;
+    assert(arguments_amount(args) == 1);
+
+    if (channel_is_closed(self->channel))
+        return BLAME_NEW_CSTR("Channel is closed");
+    if (!(value = value_copy(arguments_get(args, 0))))
+        return BLAME_NEW_CSTR_ST("Value can't be sent through a channel", *arguments_state(args, 0));
+
+    if (!channel_send(self->channel, value)) {
+        value_deref(value);
+        return BLAME_NEW_CSTR("Channel is closed");
+    }
+
+    return void_new();
+}
+
+/* :channel:receive() waits for a value and returns it */
+static RaelValue *channelvalue_method_receive(RaelChannelValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *value;
+
+    (void)args;
+    (void)interpreter;
+    assert(arguments_amount(args) == 0);
+
+    if (!(value = channel_receive(self->channel)))
+        return BLAME_NEW_CSTR("Channel is closed");
+    return value;
+}
+
+/* :channel:tryReceive() returns the next value, or Void if the channel is empty */
+static RaelValue *channelvalue_method_tryReceive(RaelChannelValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *value;
+
+    (void)args;
+    (void)interpreter;
+    assert(arguments_amount(args) == 0);
+
+    if (!(value = channel_try_receive(self->channel)))
+        return void_new();
+    channel_notify(self->channel);
+    return value;
+}
+
+/* :channel:close() stops the channel from accepting values. values that were already sent can still be received */
+static RaelValue *channelvalue_method_close(RaelChannelValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    (void)args;
+    (void)interpreter;
+    assert(arguments_amount(args) == 0);
+
+    channel_close(self->channel);
+    return void_new();
+}
+
+/* :channel:isClosed() returns whether the channel was closed */
+static RaelValue *channelvalue_method_isClosed(RaelChannelValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    (void)args;
+    (void)interpreter;
+    assert(arguments_amount(args) == 0);
+
+    return number_newi(channel_is_closed(self->channel));
+}
+
+/* iterating over a channel receives values until it is closed and empty */
+static RaelValue *channelvalue_iter_next(RaelChannelValue *self) {
+    return channel_receive(self->channel);
+}
+
+static void channelvalue_repr(RaelChannelValue *self) {
+    printf("[Channel %zu]", self->channel->capacity);
+}
+
+RaelConstructorInfo channelvalue_constructor_info = {
+    channelvalue_construct,
+    true,
+    0,
+    1
+};
+
+RaelTypeValue RaelChannelType = {
+    RAEL_TYPE_DEF_INIT,
+    .name = "Channel",
+    .op_add = NULL,
+    .op_sub = NULL,
+    .op_mul = NULL,
+    .op_div = NULL,
+    .op_mod = NULL,
+    .op_red = NULL,
+    .op_eq = NULL,
+    .op_smaller = NULL,
+    .op_bigger = NULL,
+    .op_smaller_eq = NULL,
+    .op_bigger_eq = NULL,
+
+    .op_neg = NULL,
+
+    .callable_info = NULL,
+    .constructor_info = &channelvalue_constructor_info,
+    .op_ref = NULL,
+    .op_deref = NULL,
+
+    .as_bool = NULL,
+    .deallocator = (RaelSingleFunc)channelvalue_delete,
+    .repr = (RaelSingleFunc)channelvalue_repr,
+    .logger = NULL, /* fallbacks to .repr */
+
+    .cast = NULL,
+    .copy = (RaelCopyFunc)channelvalue_copy,
+
+    .at_index = NULL,
+    .at_range = NULL,
+
+    .length = NULL,
+    .op_iter_next = (RaelIterNextFunc)channelvalue_iter_next,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
+
+    .methods = (MethodDecl[]) {
+        RAEL_CMETHOD("send", channelvalue_method_send, 1, 1),
+        RAEL_CMETHOD("receive", channelvalue_method_receive, 0, 0),
+        RAEL_CMETHOD("tryReceive", channelvalue_method_tryReceive, 0, 0),
+        RAEL_CMETHOD("close", channelvalue_method_close, 0, 0),
+        RAEL_CMETHOD("isClosed", channelvalue_method_isClosed, 0, 0),
         RAEL_CMETHOD_TERMINATOR
     }
 };
@@ -266,8 +924,7 @@ RaelValue *module_system_Exit(RaelArgumentList *args, RaelInterpreter *interpret
         RAEL_UNREACHABLE();
     }
 
-    interpreter_destruct(interpreter);
-    exit(exit_code);
+    interpreter_exit(interpreter, (int)exit_code);
     return void_new();
 }
 
@@ -305,7 +962,7 @@ RaelValue *module_system_Run(RaelArgumentList *args, RaelInterpreter *interprete
     stream = stream_new(code, string_length(string), true, NULL);
 
     // parse the string
-    instructions = rael_parse(stream);
+    instructions = rael_parse(stream, interpreter->exit_handler);
     // create a new instance that inherits our current scope
     interpreter_new_instance(interpreter, stream, instructions, !new_scope, true);
     // run
@@ -349,9 +1006,11 @@ RaelValue *module_system_Eval(RaelArgumentList *args, RaelInterpreter *interpret
 
     stream = stream_new(code, string_length(string), true, NULL);
 
-    interpreter_new_instance(interpreter, stream, NULL, !new_scope, true);
-    if (!(expr = rael_parse_expr(stream)))
+    if (!(expr = rael_parse_expr(stream, interpreter->exit_handler))) {
+        stream_deref(stream);
         return BLAME_NEW_CSTR_ST("Cannot parse string", *arguments_state(args, 0));
+    }
+    interpreter_new_instance(interpreter, stream, NULL, !new_scope, true);
 
     // evaluate the expression
     evaluated = expr_eval(interpreter, expr, true);
@@ -374,7 +1033,8 @@ static RaelValue *program_argv_stack_new(RaelInterpreter *interpreter) {
 }
 
 static RaelValue *program_filename_string_new(RaelInterpreter *interpreter) {
-    char *name = interpreter->main_stream->name;
+    // embedded interpreters may not have a main stream
+    char *name = interpreter->main_stream ? interpreter->main_stream->name : NULL;
     if (name) {
         return string_new_pure(name, strlen(name), false);
     } else {
@@ -382,6 +1042,25 @@ static RaelValue *program_filename_string_new(RaelInterpreter *interpreter) {
     }
 }
 
+/*
+ * returns a struct with counters of the memory that substrings use. SubstringBytes are the bytes of
+ * the substrings that are alive, and RetainedBytes are the bytes of the strings they keep alive
+ */
+RaelValue *module_system_MemoryStats(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelStructValue *stats = struct_new(RAEL_HEAPSTR("MemoryStats"));
+    RaelStringStats string_stats_info;
+
+    (void)args;
+    (void)interpreter;
+    assert(arguments_amount(args) == 0);
+
+    string_stats(&string_stats_info);
+    value_set_int((RaelValue*)stats, RAEL_HEAPSTR("SubstringBytes"), (RaelInt)string_stats_info.substring_bytes);
+    value_set_int((RaelValue*)stats, RAEL_HEAPSTR("RetainedBytes"), (RaelInt)string_stats_info.retained_bytes);
+    value_set_int((RaelValue*)stats, RAEL_HEAPSTR("CompactedSubstrings"), (RaelInt)string_stats_info.compacted);
+    return (RaelValue*)stats;
+}
+
 static RaelValue *raelpath_string_new(RaelInterpreter *interpreter) {
     return string_new_pure(interpreter->exec_path, strlen(interpreter->exec_path), false);
 }
@@ -398,7 +1077,9 @@ RaelValue *module_system_new(RaelInterpreter *interpreter) {
     module_set_key(m, RAEL_HEAPSTR("RunShellCommand"), cfunc_new(RAEL_HEAPSTR("RunShellCommand"), (RaelRawCFunc)module_system_RunShellCommand, 1));
     module_set_key(m, RAEL_HEAPSTR("GetShellOutput"), cfunc_new(RAEL_HEAPSTR("GetShellOutput"), (RaelRawCFunc)module_system_GetShellOutput, 1));
     module_set_key(m, RAEL_HEAPSTR("Exit"), cfunc_ranged_new(RAEL_HEAPSTR("Exit"), (RaelRawCFunc)module_system_Exit, 0, 1));
+    module_set_key(m, RAEL_HEAPSTR("MemoryStats"), cfunc_new(RAEL_HEAPSTR("MemoryStats"), (RaelRawCFunc)module_system_MemoryStats, 0));
     module_set_key(m, RAEL_HEAPSTR("Instance"), (RaelValue*)&RaelInstanceType);
+    module_set_key(m, RAEL_HEAPSTR("Channel"), (RaelValue*)&RaelChannelType);
 
     return (RaelValue*)m;
 }
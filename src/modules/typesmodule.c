@@ -32,6 +32,7 @@ RaelValue *module_types_new(RaelInterpreter *interpreter) {
     module_set_key(m, RAEL_HEAPSTR("Blame"), (RaelValue*)&RaelBlameType);
     module_set_key(m, RAEL_HEAPSTR("Range"), (RaelValue*)&RaelRangeType);
     module_set_key(m, RAEL_HEAPSTR("Module"), (RaelValue*)&RaelModuleType);
+    module_set_key(m, RAEL_HEAPSTR("Generator"), (RaelValue*)&RaelGeneratorType);
 
     return (RaelValue*)m;
 }
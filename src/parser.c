@@ -28,16 +28,22 @@ static inline void internal_parser_state_error(RaelParser* const parser, struct
 
     free(parser->instructions);
     lexer_destruct(&parser->lexer);
+    if (parser->lexer.exit_handler)
+        longjmp(*parser->lexer.exit_handler, 1);
     exit(1);
 }
 
-static void parser_construct(RaelParser *parser, RaelStream *stream) {
+static void parser_construct(RaelParser *parser, RaelStream *stream, jmp_buf *exit_handler) {
     lexer_construct(&parser->lexer, stream);
+    parser->lexer.exit_handler = exit_handler;
     parser->idx = 0;
     parser->allocated = 0;
     parser->instructions = NULL;
     parser->can_return = false;
+    parser->returns_from_routine = false;
     parser->in_loop = false;
+    parser->in_routine = false;
+    parser->found_yield = false;
 }
 
 static void parser_destruct(RaelParser* parser) {
@@ -52,13 +58,15 @@ static inline void parser_load_state(RaelParser* const parser, struct State stat
     lexer_load_state(&parser->lexer, state);
 }
 
-static struct Expr *expr_new(enum ExprType type) {
+struct Expr *expr_new(enum ExprType type) {
     struct Expr *expr = malloc(sizeof(struct Expr));
     expr->type = type;
+    expr->quickening = ExprQuickeningNone;
+    expr->eval = NULL;
     return expr;
 }
 
-static struct ValueExpr *value_expr_new(enum ValueExprType type) {
+struct ValueExpr *value_expr_new(enum ValueExprType type) {
     struct ValueExpr *value = malloc(sizeof(struct ValueExpr));
     value->type = type;
     return value;
@@ -90,7 +98,7 @@ static void parser_error(RaelParser* const parser, char* error_message, ...) {
 static void parser_push(RaelParser* const parser, RaelInstruction* const inst) {
     if (parser->allocated == 0) {
         parser->instructions = malloc(((parser->allocated = 64)+1) * sizeof(RaelInstruction*));
-    } else if (parser->idx == 64) {
+    } else if (parser->idx == parser->allocated) {
         parser->instructions = realloc(parser->instructions, ((parser->allocated += 64)+1) * sizeof(RaelInstruction*));
     }
     parser->instructions[parser->idx++] = inst;
@@ -170,13 +178,19 @@ static struct ValueExpr *parser_parse_routine(RaelParser* const parser) {
     struct ValueExpr *value;
     struct ASTRoutineValue decl;
     struct State backtrack;
-    bool old_can_return;
+    bool old_can_return, old_returns_from_routine, old_in_routine, old_found_yield;
 
     if (!parser_match(parser, TokenNameRoutine))
         return NULL;
 
     old_can_return = parser->can_return;
+    old_returns_from_routine = parser->returns_from_routine;
+    old_in_routine = parser->in_routine;
+    old_found_yield = parser->found_yield;
     parser->can_return = true;
+    parser->returns_from_routine = true;
+    parser->in_routine = true;
+    parser->found_yield = false;
     backtrack = parser_dump_state(parser);
 
     if (!parser_match(parser, TokenNameLeftParen))
@@ -237,9 +251,13 @@ static struct ValueExpr *parser_parse_routine(RaelParser* const parser) {
         parser_error(parser, "Expected block after routine decleration");
     }
 
+    decl.is_generator = parser->found_yield;
     value = value_expr_new(ValueTypeRoutine);
     value->as_routine = decl;
     parser->can_return = old_can_return;
+    parser->returns_from_routine = old_returns_from_routine;
+    parser->in_routine = old_in_routine;
+    parser->found_yield = old_found_yield;
     return value;
 }
 
@@ -295,7 +313,8 @@ static struct ValueExpr *parser_parse_string(RaelParser* const parser) {
     value = value_expr_new(ValueTypeString);
     value->as_string = (struct ASTStringValue) {
         .source = string,
-        .length = length
+        .length = length,
+        .interned = NULL
     };
 
     return value;
@@ -343,14 +362,16 @@ static struct Expr *parser_parse_match(RaelParser* const parser) {
     RaelInstruction **else_block = NULL; // the block of the else case
     struct State backtrack, full_backtrack;
     bool is_matching = true;
-    bool old_can_return;
+    bool old_can_return, old_returns_from_routine;
 
     // make sure it starts with 'match'
     if (!parser_match(parser, TokenNameMatch))
         return NULL;
 
     old_can_return = parser->can_return;
+    old_returns_from_routine = parser->returns_from_routine;
     parser->can_return = true;
+    parser->returns_from_routine = false;
 
     // parse the expression you compare against
     if (!(match_against = parser_parse_expr(parser)))
@@ -455,6 +476,7 @@ static struct Expr *parser_parse_match(RaelParser* const parser) {
         .else_block = else_block
     };
     parser->can_return = old_can_return;
+    parser->returns_from_routine = old_returns_from_routine;
     expr->state = full_backtrack;
     return expr;
 }
@@ -596,6 +618,10 @@ static struct Expr *parser_parse_suffix(RaelParser* const parser) {
             new_expr = expr_new(ExprTypeGetMember);
             new_expr->as_get_member.lhs = expr;
             new_expr->as_get_member.key = key;
+            new_expr->as_get_member.cache.map.version = 0;
+            new_expr->as_get_member.cache.map.node = NULL;
+            new_expr->as_get_member.cache.shape = NULL;
+            new_expr->as_get_member.cache.type = NULL;
             expr = new_expr;
         } else {
             // parse call
@@ -1215,6 +1241,31 @@ static RaelInstruction *parser_parse_inst_return(RaelParser* const parser) {
 
     inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeReturn, RaelReturnInstruction);
     inst->return_expr = expr;
+    inst->is_tail_call = expr && expr->type == ExprTypeCall && parser->returns_from_routine;
+
+    return (RaelInstruction*)inst;
+}
+
+static RaelInstruction *parser_parse_inst_yield(RaelParser* const parser) {
+    RaelYieldInstruction *inst;
+    struct Expr *expr;
+    struct State backtrack = parser_dump_state(parser);
+
+    if (!parser_match(parser, TokenNameYield))
+        return NULL;
+
+    if (!(expr = parser_parse_expr(parser)))
+        parser_error(parser, "Expected an expression after \"yield\"");
+    parser_expect_newline(parser);
+
+    if (!parser->in_routine) {
+        expr_delete(expr);
+        parser_state_error(parser, backtrack, "'yield' is outside of a routine");
+    }
+    parser->found_yield = true;
+
+    inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeYield, RaelYieldInstruction);
+    inst->yield_expr = expr;
 
     return (RaelInstruction*)inst;
 }
@@ -1384,6 +1435,7 @@ loop_parsing_end:
     parser_maybe_expect_newline(parser);
     inst = RAEL_INSTRUCTION_NEW(RaelInstructionTypeLoop, RaelLoopInstruction);
     inst->info = info;
+    jit_state_new(&inst->jit);
     parser->in_loop = old_in_loop;
 
     return (RaelInstruction*)inst;
@@ -1397,6 +1449,7 @@ static RaelInstruction *parser_parse_inst(RaelParser* const parser) {
         (inst = parser_parse_inst_if(parser))     ||
         (inst = parser_parse_inst_loop(parser))   ||
         (inst = parser_parse_inst_return(parser)) ||
+        (inst = parser_parse_inst_yield(parser))  ||
         (inst = parser_parse_inst_single(parser)) ||
         (inst = parser_parse_inst_catch(parser))  ||
         (inst = parser_parse_inst_show(parser))   ||
@@ -1442,12 +1495,12 @@ static RaelInstruction **parser_parse_block(RaelParser* const parser) {
     return block;
 }
 
-RaelInstruction **rael_parse(RaelStream *stream) {
+RaelInstruction **rael_parse(RaelStream *stream, jmp_buf *exit_handler) {
     struct State backtrack;
     RaelInstruction *inst;
     RaelParser parser;
 
-    parser_construct(&parser, stream);
+    parser_construct(&parser, stream, exit_handler);
     parser_maybe_expect_newline(&parser);
     // parse instruction while possible
     while ((inst = parser_parse_inst(&parser)))
@@ -1466,11 +1519,11 @@ RaelInstruction **rael_parse(RaelStream *stream) {
     return parser.instructions;
 }
 
-struct Expr *rael_parse_expr(RaelStream *stream) {
+struct Expr *rael_parse_expr(RaelStream *stream, jmp_buf *exit_handler) {
     RaelParser parser;
     struct Expr *expr;
 
-    parser_construct(&parser, stream);
+    parser_construct(&parser, stream, exit_handler);
     parser_maybe_expect_newline(&parser);
     expr = parser_parse_expr(&parser);
     if (!expr)
@@ -1629,6 +1682,7 @@ void interpreter_interpret_inst_break(RaelInterpreter *interpreter, RaelInstruct
 void interpreter_interpret_inst_skip(RaelInterpreter *interpreter, RaelInstruction *inst);
 void interpreter_interpret_inst_catch(RaelInterpreter *interpreter, RaelCatchInstruction *inst);
 void interpreter_interpret_inst_load(RaelInterpreter *interpreter, RaelLoadInstruction *inst);
+void interpreter_interpret_inst_yield(RaelInterpreter *interpreter, RaelYieldInstruction *inst);
 
 /* define instruction deleting functions */
 static void instruction_csv_delete(RaelCsvInstruction *inst) {
@@ -1636,6 +1690,8 @@ static void instruction_csv_delete(RaelCsvInstruction *inst) {
 }
 static void instruction_loop_delete(RaelLoopInstruction *inst) {
     struct LoopInstructionInfo *info = &inst->info;
+
+    jit_state_delete(&inst->jit);
     switch (info->type) {
     case LoopWhile:
         expr_delete(info->while_condition);
@@ -1706,6 +1762,9 @@ static void instruction_catch_delete(RaelCatchInstruction *inst) {
 static void instruction_load_delete(RaelLoadInstruction *inst) {
     free(inst->module_name);
 }
+static void instruction_yield_delete(RaelYieldInstruction *inst) {
+    expr_delete(inst->yield_expr);
+}
 
 /* declare instruction types */
 RaelInstructionType RaelInstructionTypeLog = {
@@ -1748,6 +1807,10 @@ RaelInstructionType RaelInstructionTypeLoad = {
     (RaelInstructionRunFunc)interpreter_interpret_inst_load,
     (RaelInstructionDeleteFunc)instruction_load_delete
 };
+RaelInstructionType RaelInstructionTypeYield = {
+    (RaelInstructionRunFunc)interpreter_interpret_inst_yield,
+    (RaelInstructionDeleteFunc)instruction_yield_delete
+};
 
 /* dereference an instruction and call its deallocator it in case we have no more references */
 void instruction_deref(RaelInstruction* const inst) {
@@ -3,6 +3,9 @@
 
 #include "common.h"
 #include "lexer.h"
+#include "varmap.h"
+#include "shape.h"
+#include "jit.h"
 
 #include <stdbool.h>
 
@@ -34,12 +37,16 @@ enum ValueExprType {
 struct ASTStringValue {
     char *source;
     size_t length;
+    /* the interned value of the literal, or NULL if it wasn't evaluated yet */
+    RaelValue *interned;
 };
 
 struct ASTRoutineValue {
     char **parameters;
     size_t amount_parameters;
     RaelInstruction **block;
+    /* true if the routine has a yield instruction in it */
+    bool is_generator;
 };
 
 struct ASTStackValue {
@@ -124,11 +131,27 @@ struct MatchExpr {
 struct GetMemberExpr {
     struct Expr *lhs;
     char *key;
+    /* inline cache of where the key was found last time */
+    struct KeyCache cache;
 };
 
+/* the kind of operands that a binary operation was specialised to */
+enum ExprQuickening {
+    ExprQuickeningNone = 0, /* wasn't evaluated yet */
+    ExprQuickeningIntInt,
+    ExprQuickeningFloatFloat,
+    ExprQuickeningStringString,
+    ExprQuickeningGeneric /* saw other operands, or operands that broke its specialisation */
+};
+
+typedef RaelValue *(*RaelExprEvalFunc)(RaelInterpreter* const interpreter, struct Expr* const expr, const bool can_explode);
+
 struct Expr {
     enum ExprType type;
     struct State state;
+    enum ExprQuickening quickening;
+    /* the function that evaluates the expression when closures are enabled, or NULL if it wasn't chosen yet */
+    RaelExprEvalFunc eval;
     union {
         struct {
             struct Expr *lhs, *rhs;
@@ -159,6 +182,7 @@ extern RaelInstructionType RaelInstructionTypeSkip;
 extern RaelInstructionType RaelInstructionTypeCatch;
 extern RaelInstructionType RaelInstructionTypeShow;
 extern RaelInstructionType RaelInstructionTypeLoad;
+extern RaelInstructionType RaelInstructionTypeYield;
 
 struct RaelInstruction {
     size_t refcount;
@@ -208,6 +232,8 @@ typedef struct RaelLoopInstruction {
         };
         RaelInstruction **block;
     } info;
+    /* counts the iterations of the loop, and compiles the loop (or the block of a loop through) when it's hot */
+    RaelJitState jit;
 } RaelLoopInstruction;
 
 typedef struct RaelCatchInstruction {
@@ -236,19 +262,38 @@ typedef struct RaelPureInstruction {
 typedef struct RaelReturnInstruction {
     RAEL_INSTRUCTION_HEADER;
     struct Expr *return_expr;
+    /* true if the instruction returns a call from a routine, so the call can reuse the routine's frame */
+    bool is_tail_call;
 } RaelReturnInstruction;
 
+typedef struct RaelYieldInstruction {
+    RAEL_INSTRUCTION_HEADER;
+    struct Expr *yield_expr;
+} RaelYieldInstruction;
+
 typedef struct RaelParser {
     RaelLexer lexer;
     RaelInstruction** instructions;
     size_t idx, allocated;
     bool in_loop;
     bool can_return;
+    /* true if '^' returns from a routine and not from a match */
+    bool returns_from_routine;
+    bool in_routine;
+    /* set when a yield instruction is parsed, to mark the routine that contains it as a generator */
+    bool found_yield;
 } RaelParser;
 
-RaelInstruction **rael_parse(RaelStream *stream);
+/* parse a stream. if `exit_handler` is not NULL, syntax errors jump to it instead of exiting */
+RaelInstruction **rael_parse(RaelStream *stream, jmp_buf *exit_handler);
+
+struct Expr *rael_parse_expr(RaelStream *stream, jmp_buf *exit_handler);
+
+struct Expr *expr_new(enum ExprType type);
+
+struct ValueExpr *value_expr_new(enum ValueExprType type);
 
-struct Expr *rael_parse_expr(RaelStream *stream);
+RaelInstruction *instruction_new(RaelInstructionType *type, size_t size);
 
 void instruction_ref(RaelInstruction *instruction);
 
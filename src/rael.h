@@ -40,6 +40,10 @@
 #include "scope.h"
 #include "value.h"
 #include "varmap.h"
+#include "shape.h"
+#include "jit.h"
+#include "emitc.h"
+#include "cache.h"
 #include "types/blame.h"
 #include "types/number.h"
 #include "types/string.h"
@@ -47,7 +51,9 @@
 #include "types/module.h"
 #include "types/range.h"
 #include "types/routine.h"
+#include "types/generator.h"
 #include "types/cfuncs.h"
 #include "types/struct.h"
+#include "types/numarray.h"
 
 #endif /* RAEL_RAEL_H */
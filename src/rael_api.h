@@ -0,0 +1,64 @@
+#ifndef RAEL_API_H
+#define RAEL_API_H
+
+/*
+ * The embedding API of Rael.
+ *
+ * This header doesn't depend on any other header of the interpreter, and only exposes opaque handles,
+ * so programs that embed Rael (by linking with build/librael.a or build/librael.so)
+ * don't depend on the layout of the interpreter's structures.
+ *
+ * Every RaelContext is an independent interpreter with its own scope, loaded modules and
+ * random number generator. Contexts don't share mutable state, so different contexts can be
+ * used from different threads, as long as each context is only used by one thread at a time.
+ *
+ * Errors in the code are printed, and are reported through return values instead of exiting the process.
+ * Values that were in use by a failed run are not freed.
+ */
+
+#include <stdbool.h>
+
+typedef struct RaelContext RaelContext;
+typedef struct RaelObject RaelObject;
+
+/* create a new context. `argv` is accessible in the code as :System:ProgramArgv */
+RaelContext *rael_context_new(int argc, char **argv);
+
+/* delete a context and everything it stores */
+void rael_context_delete(RaelContext *context);
+
+/* run a file in the context's global scope. returns the exit code of the program (0 on success) */
+int rael_context_run_file(RaelContext *context, const char *filename);
+
+/*
+ * run a string of code in the context's global scope. `name` is shown in error messages and can be NULL.
+ * returns the exit code of the program (0 on success)
+ */
+int rael_context_run_string(RaelContext *context, const char *code, const char *name);
+
+/* evaluate an expression in the context's global scope. returns NULL if the evaluation failed */
+RaelObject *rael_context_eval(RaelContext *context, const char *expression);
+
+/* set a variable in the context's global scope */
+void rael_context_set_int(RaelContext *context, const char *key, long value);
+
+void rael_context_set_float(RaelContext *context, const char *key, double value);
+
+void rael_context_set_string(RaelContext *context, const char *key, const char *string);
+
+/* returns the name of the object's type, e.g "Number" */
+const char *rael_object_type_name(RaelObject *object);
+
+/* returns true and sets `out` if the object is a whole number */
+bool rael_object_to_int(RaelObject *object, long *out);
+
+/* returns true and sets `out` if the object is a number */
+bool rael_object_to_float(RaelObject *object, double *out);
+
+/* returns the object casted to a string as a heap allocated cstring, or NULL if it can't be casted */
+char *rael_object_to_cstr(RaelObject *object);
+
+/* release an object returned from the API. releasing NULL does nothing */
+void rael_object_release(RaelObject *object);
+
+#endif /* RAEL_API_H */
@@ -1,7 +1,24 @@
 #include "rael.h"
 
+/*
+ * Scopes are created and deleted on every call and block, so deleted scopes are kept in a pool
+ * and reused. Every thread has its own pool, linked through the parent pointer.
+ */
+#define SCOPE_POOL_MAX 64
+
+static __thread struct Scope *scope_pool = NULL;
+static __thread size_t scope_pool_size = 0;
+
 struct Scope *scope_new(struct Scope* const parent) {
-    struct Scope *scope = malloc(sizeof(struct Scope));
+    struct Scope *scope;
+
+    if (scope_pool) {
+        scope = scope_pool;
+        scope_pool = scope->parent;
+        --scope_pool_size;
+    } else {
+        scope = malloc(sizeof(struct Scope));
+    }
     scope->parent = parent;
     scope->refcount = 1;
     varmap_new(&scope->variables);
@@ -16,11 +33,29 @@ void scope_deref(struct Scope* const scope) {
     --scope->refcount;
     if (scope->refcount == 0) {
         varmap_delete(&scope->variables);
+        if (scope_pool_size < SCOPE_POOL_MAX) {
+            scope->parent = scope_pool;
+            scope_pool = scope;
+            ++scope_pool_size;
+        } else {
+            free(scope);
+        }
+    }
+}
+
+void scope_free_pool(void) {
+    struct Scope *next;
+
+    for (struct Scope *scope = scope_pool; scope; scope = next) {
+        next = scope->parent;
         free(scope);
     }
+    scope_pool = NULL;
+    scope_pool_size = 0;
 }
 
 void scope_set(struct Scope* const scope, char *key, RaelValue *value, bool dealloc_key_on_free) {
+    string_compact(value);
     for (struct Scope *sc = scope; sc; sc = sc->parent) {
         if (varmap_set(&sc->variables, key, value, false, dealloc_key_on_free))
             return;
@@ -29,6 +64,7 @@ void scope_set(struct Scope* const scope, char *key, RaelValue *value, bool deal
 }
 
 void scope_set_local(struct Scope *scope, char* const key, RaelValue *value, bool dealloc_key_on_free) {
+    string_compact(value);
     varmap_set(&scope->variables, key, value, true, dealloc_key_on_free);
 }
 
@@ -24,6 +24,9 @@ void scope_ref(struct Scope* const scope);
 
 void scope_deref(struct Scope* const scope);
 
+/* free the scopes that are kept for reuse by the current thread */
+void scope_free_pool(void);
+
 RaelValue **scope_get_ptr(struct Scope* const scope, char *key);
 
 RaelValue *scope_get(struct Scope* const scope, char *key, const bool warn_undefined);
@@ -0,0 +1,117 @@
+#include "rael.h"
+
+#include <pthread.h>
+
+static RaelShape empty_shape = {
+    .parent = NULL,
+    .amount_keys = 0,
+    .key = NULL,
+    .keys = NULL,
+    .transitions = NULL,
+    .next_transition = NULL
+};
+
+/* locks the addition of transitions. transitions are searched without it */
+static pthread_mutex_t transitions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+RaelShape *shape_empty(void) {
+    return &empty_shape;
+}
+
+static RaelShape *shape_find_transition(RaelShape *transitions, char *key) {
+    for (RaelShape *transition = transitions; transition; transition = transition->next_transition) {
+        if (strcmp(transition->key, key) == 0)
+            return transition;
+    }
+    return NULL;
+}
+
+RaelShape *shape_add_key(RaelShape *shape, char *key) {
+    RaelShape *added;
+
+    // transitions are only added to the start of the list, so it can be searched while it's added to
+    if ((added = shape_find_transition(__atomic_load_n(&shape->transitions, __ATOMIC_ACQUIRE), key)))
+        return added;
+
+    pthread_mutex_lock(&transitions_lock);
+    // the transition could have been added by another thread after the list was searched
+    if (!(added = shape_find_transition(shape->transitions, key))) {
+        added = malloc(sizeof(RaelShape));
+        added->parent = shape;
+        added->amount_keys = shape->amount_keys + 1;
+        added->key = rael_cstr_duplicate(key);
+        added->keys = malloc(added->amount_keys * sizeof(char*));
+        if (shape->amount_keys > 0)
+            memcpy(added->keys, shape->keys, shape->amount_keys * sizeof(char*));
+        added->keys[shape->amount_keys] = added->key;
+        added->transitions = NULL;
+        added->next_transition = shape->transitions;
+        __atomic_store_n(&shape->transitions, added, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&transitions_lock);
+    return added;
+}
+
+bool shape_find(RaelShape *shape, char *key, size_t *index) {
+    for (size_t i = 0; i < shape->amount_keys; ++i) {
+        if (strcmp(shape->keys[i], key) == 0) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* the amount of values that are allocated for an amount of keys */
+static size_t fields_capacity(size_t amount_keys) {
+    size_t capacity = 4;
+
+    if (amount_keys == 0)
+        return 0;
+    while (capacity < amount_keys)
+        capacity *= 2;
+    return capacity;
+}
+
+void fields_new(RaelFields *out) {
+    out->shape = shape_empty();
+    out->values = NULL;
+}
+
+RaelValue **fields_get_ptr(RaelFields *fields, char *key, struct KeyCache *cache) {
+    size_t index;
+
+    if (cache && cache->shape == fields->shape)
+        return &fields->values[cache->index];
+    if (!shape_find(fields->shape, key, &index))
+        return NULL;
+    if (cache) {
+        cache->shape = fields->shape;
+        cache->index = index;
+    }
+    return &fields->values[index];
+}
+
+void fields_set(RaelFields *fields, char *key, RaelValue *value) {
+    RaelValue **value_ptr = fields_get_ptr(fields, key, NULL);
+
+    value_ref(value);
+    if (value_ptr) {
+        value_deref(*value_ptr);
+        *value_ptr = value;
+    } else {
+        size_t amount_keys = fields->shape->amount_keys;
+
+        if (amount_keys == fields_capacity(amount_keys))
+            fields->values = realloc(fields->values, fields_capacity(amount_keys + 1) * sizeof(RaelValue*));
+        fields->shape = shape_add_key(fields->shape, key);
+        fields->values[amount_keys] = value;
+    }
+    free(key);
+}
+
+void fields_delete(RaelFields *fields) {
+    for (size_t i = 0; i < fields->shape->amount_keys; ++i)
+        value_deref(fields->values[i]);
+    free(fields->values);
+}
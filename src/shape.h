@@ -0,0 +1,65 @@
+#ifndef RAEL_SHAPE_H
+#define RAEL_SHAPE_H
+
+#include "varmap.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * A shape is the layout of the keys of a value that stores its keys as fields (like a struct).
+ * It has the keys in the order they were added, and a key's value is stored at the key's index.
+ * Adding a key to a shape moves the value to a child shape, so values that got the same keys in
+ * the same order share one shape, and the index of a key can be cached per shape instead of
+ * hashing the key for every value. Shapes are shared between threads and are never freed.
+ */
+typedef struct RaelShape {
+    struct RaelShape *parent;
+    size_t amount_keys;
+    /* the last key, which is the key the shape adds to its parent */
+    char *key;
+    /* the keys of the shape by their index */
+    char **keys;
+    /* the shapes that add one key to this shape, linked through `next_transition` */
+    struct RaelShape *transitions;
+    struct RaelShape *next_transition;
+} RaelShape;
+
+/* the keys of a value that stores its keys as fields */
+typedef struct RaelFields {
+    RaelShape *shape;
+    RaelValue **values;
+} RaelFields;
+
+/* inline cache of a key lookup (see GetMemberExpr) */
+struct KeyCache {
+    /* used for keys in maps */
+    struct VariableMapCache map;
+    /* used for fields. the key is at `index` in values of `shape` */
+    RaelShape *shape;
+    size_t index;
+    /* used for methods. the key is `method` in the methods of `type` */
+    struct RaelTypeValue *type;
+    struct MethodDecl *method;
+};
+
+/* the shape without keys, which every value starts with */
+RaelShape *shape_empty(void);
+
+/* the shape that adds `key` to `shape`. the key is copied if the shape is new */
+RaelShape *shape_add_key(RaelShape *shape, char *key);
+
+/* find the index of a key in a shape. returns false if the shape doesn't have the key */
+bool shape_find(RaelShape *shape, char *key, size_t *index);
+
+void fields_new(RaelFields *out);
+
+/* get a pointer to the value at a key, or NULL if there is no such key. `cache` may be NULL */
+RaelValue **fields_get_ptr(RaelFields *fields, char *key, struct KeyCache *cache);
+
+/* set a key to a value, which is referenced. the key is freed */
+void fields_set(RaelFields *fields, char *key, RaelValue *value);
+
+void fields_delete(RaelFields *fields);
+
+#endif /* RAEL_SHAPE_H */
@@ -6,7 +6,9 @@ RaelStream *stream_new(char *code, size_t length, bool on_heap, char *name) {
     stream->base = code;
     stream->length = length;
     stream->on_heap = on_heap;
+    stream->is_mapped = false;
     stream->name = name;
+    stream->lines = NULL;
     return stream;
 }
 
@@ -19,11 +21,13 @@ void stream_deref(RaelStream *stream) {
     if (stream->refcount == 0) {
         if (stream->on_heap) {
 #ifdef __unix__
-            munmap(stream->base, stream->length);
-#else
-            free(stream->base);
+            if (stream->is_mapped)
+                munmap(stream->base, stream->length + 1);
+            else
 #endif
+                free(stream->base);
         }
+        free(stream->lines);
         free(stream);
     }
 }
@@ -38,11 +42,56 @@ void stream_ptr_destruct(RaelStreamPtr *stream_ptr) {
     stream_deref(stream_ptr->base);
 }
 
+static RaelLineTable *stream_lines(RaelStream *stream) {
+    RaelLineTable *lines = __atomic_load_n(&stream->lines, __ATOMIC_ACQUIRE);
+    RaelLineTable *expected = NULL;
+    size_t amount_lines = 1;
+
+    if (lines)
+        return lines;
+
+    for (size_t i = 0; i < stream->length; ++i) {
+        if (stream->base[i] == '\n')
+            ++amount_lines;
+    }
+    lines = malloc(sizeof(RaelLineTable) + amount_lines * sizeof(size_t));
+    lines->amount_lines = 0;
+    lines->starts[lines->amount_lines++] = 0;
+    for (size_t i = 0; i < stream->length; ++i) {
+        if (stream->base[i] == '\n')
+            lines->starts[lines->amount_lines++] = i + 1;
+    }
+
+    // threads could build the table at the same time, so only one of the tables is kept
+    if (!__atomic_compare_exchange_n(&stream->lines, &expected, lines, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(lines);
+        lines = expected;
+    }
+    return lines;
+}
+
+void stream_position(RaelStream *stream, size_t offset, size_t *line, size_t *column) {
+    RaelLineTable *lines = stream_lines(stream);
+    size_t low = 0, high = lines->amount_lines;
+
+    // find the last line that starts at or before the offset
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if (lines->starts[middle] <= offset)
+            low = middle;
+        else
+            high = middle;
+    }
+    *line = low + 1;
+    *column = offset - lines->starts[low] + 1;
+}
+
 #ifdef __unix__
 RaelStream *rael_load_file(char* const filename) {
     int fd;
     char *stream;
     size_t length;
+    RaelStream *loaded;
 
     fd = open(filename, O_RDONLY);
     if (fd == -1)
@@ -54,7 +103,9 @@ RaelStream *rael_load_file(char* const filename) {
     stream[length] = '\0';
     close(fd);
 
-    return stream_new(stream, length, true, filename);
+    loaded = stream_new(stream, length, true, filename);
+    loaded->is_mapped = true;
+    return loaded;
 }
 #else
 RaelStream *rael_load_file(char* const filename) {
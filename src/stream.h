@@ -4,6 +4,12 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/* The offsets that lines start at, sorted. It's built the first time a position is needed */
+typedef struct RaelLineTable {
+    size_t amount_lines;
+    size_t starts[];
+} RaelLineTable;
+
 /* Stores information about our current character stream */
 typedef struct RaelStream {
     /* Counts the amount of references this struct has */
@@ -16,6 +22,10 @@ typedef struct RaelStream {
     size_t length;
     /* This decides whether we can `free()` this */
     bool on_heap;
+    /* If true, the stream was mapped by `mmap` and is unmapped instead of being freed */
+    bool is_mapped;
+    /* The line table of the stream, or NULL if it wasn't built yet */
+    RaelLineTable *lines;
 } RaelStream;
 
 typedef struct RaelStreamPtr {
@@ -37,4 +47,7 @@ void stream_ptr_construct(RaelStreamPtr *stream_ptr, RaelStream *stream, size_t
 
 void stream_ptr_destruct(RaelStreamPtr *stream_ptr);
 
+/* get the line and column (both starting at 1) of an offset in the stream */
+void stream_position(RaelStream *stream, size_t offset, size_t *line, size_t *column);
+
 #endif // RAEL_COMMON_H
@@ -68,11 +68,16 @@ RaelTypeValue RaelBlameType = {
     .logger = NULL,
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = NULL
 };
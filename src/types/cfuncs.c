@@ -99,11 +99,16 @@ RaelTypeValue RaelCFuncType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = NULL
 };
@@ -111,6 +116,7 @@ RaelTypeValue RaelCFuncType = {
 RaelValue *method_cfunc_new(RaelValue *method_self, MethodDecl *decl) {
     RaelCFuncMethodValue *method = RAEL_VALUE_NEW(RaelCFuncMethodType, RaelCFuncMethodValue);
 
+    value_ref(method_self);
     method->method_self = method_self;
     method->name = decl->name;
     method->func = decl->method;
@@ -146,11 +152,7 @@ void method_cfunc_repr(RaelCFuncMethodValue *self) {
     printf("']");
 }
 
-void method_cfunc_ref(RaelCFuncMethodValue *self) {
-    value_ref(self->method_self);
-}
-
-void method_cfunc_deref(RaelCFuncMethodValue *self) {
+void method_cfunc_delete(RaelCFuncMethodValue *self) {
     value_deref(self->method_self);
 }
 
@@ -178,20 +180,25 @@ RaelTypeValue RaelCFuncMethodType = {
 
     .callable_info = &cfunc_method_callable_info,
     .constructor_info = NULL,
-    .op_ref = (RaelSingleFunc)method_cfunc_ref,
-    .op_deref = (RaelSingleFunc)method_cfunc_deref,
+    .op_ref = NULL,
+    .op_deref = NULL,
 
     .as_bool = NULL,
-    .deallocator = NULL,
+    .deallocator = (RaelSingleFunc)method_cfunc_delete,
     .repr = (RaelSingleFunc)method_cfunc_repr,
     .logger = NULL,
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = NULL
 };
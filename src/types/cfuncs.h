@@ -42,7 +42,7 @@ RaelValue *cfunc_new(char *name, RaelRawCFunc func, size_t amount_params);
 /* Returns a new CFunc value that takes min_args or more arguments (most functions) */
 RaelValue *cfunc_unlimited_new(char *name, RaelRawCFunc func, size_t min_args);
 
-/* construct a RaelValue of type MethodFunc */
+/* construct a RaelValue of type MethodFunc. the method holds a reference to its self */
 RaelValue *method_cfunc_new(RaelValue *method_self, MethodDecl *decl);
 
 #endif /* RAEL_CFUNCS_H */
@@ -0,0 +1,319 @@
+/* MAP_ANONYMOUS and MAP_NORESERVE aren't a part of the POSIX version that rael.h asks for */
+#define _DEFAULT_SOURCE
+#include "rael.h"
+
+#include <ucontext.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+/*
+ * A generator runs the block of a routine that has a yield instruction in it, and stops every time it yields a value.
+ * Every generator runs on its own C stack, so it can stop anywhere in the tree walking
+ * and continue from the same place when it's resumed.
+ */
+
+/*
+ * A generator's stack is at least as big as the stack of the main thread (up to a limit), so routines can recurse
+ * as deep in a generator as outside of one. The stack is only committed by the system when it's used,
+ * so a generous size is cheap. Below the stack there's a guard page, so an overflow crashes instead of
+ * writing over other memory.
+ */
+#define GENERATOR_STACK_MIN_SIZE (8 * 1024 * 1024)
+#define GENERATOR_STACK_MAX_SIZE (64 * 1024 * 1024)
+/* routines aren't called when there's less stack than this left, so the code between calls never reaches the guard page */
+#define GENERATOR_STACK_MARGIN (256 * 1024)
+
+static size_t generator_stack_size, generator_guard_size;
+static pthread_once_t generator_stack_size_once = PTHREAD_ONCE_INIT;
+
+enum GeneratorState {
+    GeneratorStateNotStarted,
+    GeneratorStateSuspended,
+    GeneratorStateRunning,
+    GeneratorStateFinished
+};
+
+struct RaelGeneratorValue {
+    RAEL_VALUE_BASE;
+    RaelRoutineValue *routine;
+    RaelValue **arguments;
+    size_t amount_arguments;
+    RaelInterpreter *interpreter;
+
+    enum GeneratorState state;
+    /* set when the generator is deleted before it finished, to make it return at its yield */
+    bool closing;
+    /* the innermost scope of the generator while it's not running */
+    struct Scope *scope;
+    /* the value given by the last yield */
+    RaelValue *yielded;
+    /* the generator that was running when this generator was resumed */
+    RaelGeneratorValue *prev;
+    /* the generator can stop in the middle of a call, so it has its own argument stack */
+    RaelArgumentStack argument_stack;
+    RaelArgumentStack *caller_arguments;
+
+    /* the mapping of the stack, which starts with the guard page */
+    char *stack;
+    ucontext_t context;
+    ucontext_t caller;
+};
+
+RaelValue *generator_new(RaelRoutineValue *routine, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelGeneratorValue *generator = RAEL_VALUE_NEW(RaelGeneratorType, RaelGeneratorValue);
+    size_t amount_arguments = arguments_amount(args);
+
+    value_ref((RaelValue*)routine);
+    generator->routine = routine;
+    generator->arguments = malloc(amount_arguments * sizeof(RaelValue*));
+    for (size_t i = 0; i < amount_arguments; ++i) {
+        RaelValue *value = arguments_get(args, i);
+        value_ref(value);
+        generator->arguments[i] = value;
+    }
+    generator->amount_arguments = amount_arguments;
+    generator->interpreter = interpreter;
+
+    generator->state = GeneratorStateNotStarted;
+    generator->closing = false;
+    generator->scope = NULL;
+    generator->yielded = NULL;
+    generator->prev = NULL;
+    argument_stack_new(&generator->argument_stack);
+    generator->caller_arguments = NULL;
+    generator->stack = NULL;
+
+    return (RaelValue*)generator;
+}
+
+static void generator_stack_size_init(void) {
+    struct rlimit limit;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = GENERATOR_STACK_MIN_SIZE;
+
+    if (getrlimit(RLIMIT_STACK, &limit) == 0) {
+        if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur > GENERATOR_STACK_MAX_SIZE)
+            size = GENERATOR_STACK_MAX_SIZE;
+        else if (limit.rlim_cur > GENERATOR_STACK_MIN_SIZE)
+            size = (size_t)limit.rlim_cur;
+    }
+    generator_stack_size = (size + page_size - 1) / page_size * page_size;
+    generator_guard_size = page_size;
+}
+
+/* map a stack for a generator, with a guard page below it. returns NULL if it couldn't be mapped */
+static char *generator_stack_new(void) {
+    char *stack;
+
+    pthread_once(&generator_stack_size_once, generator_stack_size_init);
+    stack = mmap(NULL, generator_guard_size + generator_stack_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (stack == MAP_FAILED)
+        return NULL;
+    if (mprotect(stack, generator_guard_size, PROT_NONE) != 0) {
+        munmap(stack, generator_guard_size + generator_stack_size);
+        return NULL;
+    }
+    return stack;
+}
+
+static void generator_stack_delete(char *stack) {
+    if (stack)
+        munmap(stack, generator_guard_size + generator_stack_size);
+}
+
+bool generator_stack_exhausted(RaelGeneratorValue *self) {
+    char marker;
+
+    // the stack grows down, towards the guard page
+    return (uintptr_t)&marker - (uintptr_t)(self->stack + generator_guard_size) < GENERATOR_STACK_MARGIN;
+}
+
+/* the entry point of the generator's stack. makecontext only passes ints, so the pointer is split in two */
+static void generator_run(unsigned int high, unsigned int low) {
+    RaelGeneratorValue *self = (RaelGeneratorValue*)(((uintptr_t)high << 16 << 16) | (uintptr_t)low);
+    RaelInterpreter *interpreter = self->interpreter;
+    RaelRoutineValue *routine = self->routine;
+
+    // the scope of the routine was already set when the generator was resumed
+    interpreter_push_scope(interpreter);
+    for (size_t i = 0; i < routine->amount_parameters; ++i)
+        scope_set_local(interpreter->instance->scope, routine->parameters[i], self->arguments[i], false);
+
+    jit_block_run(interpreter, &routine->jit, routine->block);
+
+    // the returned value of a generator isn't used
+    if (interpreter->instance->interrupt == ProgramInterruptReturn) {
+        if (interpreter->instance->returned_value)
+            value_deref(interpreter->instance->returned_value);
+        interpreter->instance->returned_value = NULL;
+    }
+    // a returned call is still made, even though its value isn't used
+    if (interpreter->instance->tail_callable) {
+        RaelValue *callable = interpreter->instance->tail_callable;
+        RaelArgumentList args = interpreter->instance->tail_args;
+
+        interpreter->instance->tail_callable = NULL;
+        interpreter->instance->interrupt = ProgramInterruptNone;
+        value_deref(value_call(callable, &args, interpreter));
+        arguments_delete(&args);
+        value_deref(callable);
+    }
+    interpreter->instance->interrupt = ProgramInterruptNone;
+    interpreter_pop_scope(interpreter);
+
+    self->state = GeneratorStateFinished;
+    // returning continues at the caller context, which is the uc_link
+}
+
+/* run the generator until its next yield. returns the yielded value, or NULL if the generator finished */
+static RaelValue *generator_resume(RaelGeneratorValue *self) {
+    RaelInterpreter *interpreter = self->interpreter;
+    RaelInstance *instance = interpreter->instance;
+    struct Scope *caller_scope;
+    RaelValue *yielded;
+
+    switch (self->state) {
+    case GeneratorStateNotStarted: {
+        uintptr_t address = (uintptr_t)self;
+
+        if (!(self->stack = generator_stack_new())) {
+            self->state = GeneratorStateFinished;
+            return BLAME_NEW_CSTR("Couldn't allocate a stack for the generator");
+        }
+        getcontext(&self->context);
+        self->context.uc_stack.ss_sp = self->stack + generator_guard_size;
+        self->context.uc_stack.ss_size = generator_stack_size;
+        self->context.uc_link = &self->caller;
+        makecontext(&self->context, (void (*)(void))generator_run, 2,
+                    (unsigned int)(address >> 16 >> 16), (unsigned int)(address & 0xffffffff));
+        self->scope = self->routine->scope;
+        break;
+    }
+    case GeneratorStateSuspended:
+        break;
+    case GeneratorStateRunning:
+    case GeneratorStateFinished:
+        return NULL;
+    default:
+        RAEL_UNREACHABLE();
+    }
+
+    // switch to the scope chain of the generator while it runs
+    caller_scope = instance->scope;
+    instance->scope = self->scope;
+    self->prev = interpreter->generator;
+    interpreter->generator = self;
+    self->caller_arguments = interpreter->arguments;
+    interpreter->arguments = &self->argument_stack;
+    self->state = GeneratorStateRunning;
+
+    swapcontext(&self->caller, &self->context);
+
+    interpreter->generator = self->prev;
+    interpreter->arguments = self->caller_arguments;
+    self->prev = NULL;
+    self->caller_arguments = NULL;
+    self->scope = instance->scope;
+    instance->scope = caller_scope;
+    if (self->state == GeneratorStateRunning) {
+        self->state = GeneratorStateSuspended;
+    } else {
+        // the generator finished, so its stack isn't needed anymore
+        generator_stack_delete(self->stack);
+        self->stack = NULL;
+    }
+
+    yielded = self->yielded;
+    self->yielded = NULL;
+    return yielded;
+}
+
+void generator_yield(RaelInterpreter *interpreter, RaelValue *value) {
+    RaelGeneratorValue *self = interpreter->generator;
+
+    assert(self);
+    if (!self->closing) {
+        self->yielded = value;
+        swapcontext(&self->context, &self->caller);
+    } else {
+        value_deref(value);
+    }
+
+    // if the generator is deleted, return from the routine instead of continuing
+    if (self->closing) {
+        interpreter->instance->returned_value = void_new();
+        interpreter->instance->interrupt = ProgramInterruptReturn;
+    }
+}
+
+static RaelValue *generator_iter_next(RaelGeneratorValue *self) {
+    return generator_resume(self);
+}
+
+void generator_delete(RaelGeneratorValue *self) {
+    // let a suspended generator unwind, so the values it uses are dereferenced.
+    // while the interpreter is being destructed there's no instance to run it on
+    if (self->state == GeneratorStateSuspended && self->interpreter->instance) {
+        self->closing = true;
+        generator_resume(self);
+    }
+
+    // a generator that is still running was stopped by an error, and its stack may still be in use
+    if (self->state != GeneratorStateRunning)
+        generator_stack_delete(self->stack);
+    argument_stack_delete(&self->argument_stack);
+
+    for (size_t i = 0; i < self->amount_arguments; ++i)
+        value_deref(self->arguments[i]);
+    free(self->arguments);
+    value_deref((RaelValue*)self->routine);
+}
+
+static void generator_repr(RaelGeneratorValue *self) {
+    printf("[Generator ");
+    value_repr((RaelValue*)self->routine);
+    printf("]");
+}
+
+RaelTypeValue RaelGeneratorType = {
+    RAEL_TYPE_DEF_INIT,
+    .name = "Generator",
+    .op_add = NULL,
+    .op_sub = NULL,
+    .op_mul = NULL,
+    .op_div = NULL,
+    .op_mod = NULL,
+    .op_red = NULL,
+    .op_eq = NULL,
+    .op_smaller = NULL,
+    .op_bigger = NULL,
+    .op_smaller_eq = NULL,
+    .op_bigger_eq = NULL,
+
+    .op_neg = NULL,
+
+    .callable_info = NULL,
+    .constructor_info = NULL,
+    .op_ref = NULL,
+    .op_deref = NULL,
+
+    .as_bool = NULL,
+    .deallocator = (RaelSingleFunc)generator_delete,
+    .repr = (RaelSingleFunc)generator_repr,
+    .logger = NULL, /* fallbacks to .repr */
+
+    .cast = NULL,
+    .copy = NULL,
+
+    .at_index = NULL,
+    .at_range = NULL,
+
+    .length = NULL,
+    .op_iter_next = (RaelIterNextFunc)generator_iter_next,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
+
+    .methods = NULL
+};
@@ -0,0 +1,23 @@
+#ifndef RAEL_GENERATOR_H
+#define RAEL_GENERATOR_H
+
+#include "value.h"
+#include "routine.h"
+
+extern RaelTypeValue RaelGeneratorType;
+
+typedef struct RaelGeneratorValue RaelGeneratorValue;
+
+/* create a generator that runs the block of a generator routine with the arguments given */
+RaelValue *generator_new(RaelRoutineValue *routine, RaelArgumentList *args, RaelInterpreter *interpreter);
+
+/*
+ * Give a value to whoever resumed the running generator, and stop running until it's resumed again.
+ * The value is owned by the generator until it is resumed.
+ */
+void generator_yield(RaelInterpreter *interpreter, RaelValue *value);
+
+/* returns true if the generator, which is running, is close to the end of its stack */
+bool generator_stack_exhausted(RaelGeneratorValue *self);
+
+#endif /* RAEL_GENERATOR_H */
@@ -5,12 +5,13 @@
 RaelValue *module_new(char *name) {
     RaelModuleValue *module = RAEL_VALUE_NEW(RaelModuleType, RaelModuleValue);
     // set the module's name
+    varmap_new(&module->keys);
     module->name = name;
     return (RaelValue*)module;
 }
 
 void module_set_key(RaelModuleValue *self, char *varname, RaelValue *value) {
-    varmap_set(&((RaelValue*)self)->keys, varname, value, true, true);
+    varmap_set(&self->keys, varname, value, true, true);
     // remove the added reference
     value_deref(value);
 }
@@ -51,11 +52,16 @@ RaelTypeValue RaelModuleType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = offsetof(RaelModuleValue, keys),
+    .fields_offset = 0,
 
     .methods = NULL
 };
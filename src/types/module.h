@@ -9,6 +9,7 @@ extern RaelTypeValue RaelModuleType;
 
 typedef struct RaelModuleValue {
     RAEL_VALUE_BASE;
+    struct VariableMap keys;
     char *name;
 } RaelModuleValue;
 
@@ -0,0 +1,491 @@
+#include "rael.h"
+
+#include "numarray.h"
+
+/*
+ * The element-wise kernels take plain C arrays that don't overlap the output, so their loops
+ * can be vectorized. This file is compiled with -O3 (see the Makefile) for that reason.
+ */
+#define NUMARRAY_KERNELS(name, type, op)                                                               \
+    static void name(type *restrict out, const type *restrict lhs, const type *restrict rhs,       \
+                     size_t length) {                                                                  \
+        for (size_t i = 0; i < length; ++i)                                                            \
+            out[i] = lhs[i] op rhs[i];                                                                 \
+    }                                                                                                  \
+    static void name##_number(type *restrict out, const type *restrict lhs, type rhs, size_t length) { \
+        for (size_t i = 0; i < length; ++i)                                                            \
+            out[i] = lhs[i] op rhs;                                                                    \
+    }
+
+NUMARRAY_KERNELS(floats_add, RaelFloat, +)
+NUMARRAY_KERNELS(floats_sub, RaelFloat, -)
+NUMARRAY_KERNELS(floats_mul, RaelFloat, *)
+NUMARRAY_KERNELS(floats_div, RaelFloat, /)
+NUMARRAY_KERNELS(ints_add, RaelInt, +)
+NUMARRAY_KERNELS(ints_sub, RaelInt, -)
+NUMARRAY_KERNELS(ints_mul, RaelInt, *)
+
+/* the extremum of a non-empty array, where `cmp` is < for the minimum and > for the maximum */
+#define NUMARRAY_EXTREMUM(name, type, cmp)                              \
+    static type name(const type *values, size_t length) {               \
+        type extremum = values[0];                                      \
+        for (size_t i = 1; i < length; ++i)                             \
+            extremum = values[i] cmp extremum ? values[i] : extremum;   \
+        return extremum;                                                \
+    }
+
+NUMARRAY_EXTREMUM(floats_min, RaelFloat, <)
+NUMARRAY_EXTREMUM(floats_max, RaelFloat, >)
+NUMARRAY_EXTREMUM(ints_min, RaelInt, <)
+NUMARRAY_EXTREMUM(ints_max, RaelInt, >)
+
+enum NumArrayOperation {
+    NumArrayAdd,
+    NumArraySub,
+    NumArrayMul,
+    NumArrayDiv
+};
+
+static bool floats_contain_zero(const RaelFloat *values, size_t length) {
+    bool contains_zero = false;
+
+    for (size_t i = 0; i < length; ++i)
+        contains_zero |= values[i] == 0.0;
+    return contains_zero;
+}
+
+/*
+ * Float additions can't be reordered by the compiler, so the sums are kept in four
+ * separate lanes that don't depend on each other, and are added together at the end.
+ */
+static RaelFloat floats_sum(const RaelFloat *values, size_t length) {
+    RaelFloat sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    size_t i;
+
+    for (i = 0; i + 4 <= length; i += 4) {
+        sums[0] += values[i];
+        sums[1] += values[i + 1];
+        sums[2] += values[i + 2];
+        sums[3] += values[i + 3];
+    }
+    for (; i < length; ++i)
+        sums[0] += values[i];
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+static RaelFloat floats_dot(const RaelFloat *lhs, const RaelFloat *rhs, size_t length) {
+    RaelFloat sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    size_t i;
+
+    for (i = 0; i + 4 <= length; i += 4) {
+        sums[0] += lhs[i] * rhs[i];
+        sums[1] += lhs[i + 1] * rhs[i + 1];
+        sums[2] += lhs[i + 2] * rhs[i + 2];
+        sums[3] += lhs[i + 3] * rhs[i + 3];
+    }
+    for (; i < length; ++i)
+        sums[0] += lhs[i] * rhs[i];
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+static RaelInt ints_sum(const RaelInt *values, size_t length) {
+    RaelInt sum = 0;
+
+    for (size_t i = 0; i < length; ++i)
+        sum += values[i];
+    return sum;
+}
+
+static RaelInt ints_dot(const RaelInt *lhs, const RaelInt *rhs, size_t length) {
+    RaelInt sum = 0;
+
+    for (size_t i = 0; i < length; ++i)
+        sum += lhs[i] * rhs[i];
+    return sum;
+}
+
+RaelValue *numarray_new(size_t length, bool is_float) {
+    RaelNumArrayValue *array = RAEL_VALUE_NEW(RaelNumArrayType, RaelNumArrayValue);
+
+    array->is_float = is_float;
+    array->length = length;
+    if (is_float)
+        array->floats = malloc(length * sizeof(RaelFloat));
+    else
+        array->ints = malloc(length * sizeof(RaelInt));
+    return (RaelValue*)array;
+}
+
+/* get the numbers of an array as floats. whole numbers are copied, and should be freed with numarray_floats_free */
+static RaelFloat *numarray_floats(RaelNumArrayValue *self) {
+    RaelFloat *floats;
+
+    if (self->is_float)
+        return self->floats;
+    floats = malloc(self->length * sizeof(RaelFloat));
+    for (size_t i = 0; i < self->length; ++i)
+        floats[i] = (RaelFloat)self->ints[i];
+    return floats;
+}
+
+static void numarray_floats_free(RaelNumArrayValue *self, RaelFloat *floats) {
+    if (!self->is_float)
+        free(floats);
+}
+
+/* make the first `amount` numbers of an array of whole numbers floats */
+static void numarray_make_float(RaelNumArrayValue *self, size_t amount) {
+    RaelFloat *floats = malloc(self->length * sizeof(RaelFloat));
+
+    assert(!self->is_float);
+    for (size_t i = 0; i < amount; ++i)
+        floats[i] = (RaelFloat)self->ints[i];
+    free(self->ints);
+    self->floats = floats;
+    self->is_float = true;
+}
+
+static RaelValue *numarray_number_at(RaelNumArrayValue *self, size_t idx) {
+    if (self->is_float)
+        return number_newf(self->floats[idx]);
+    else
+        return number_newi(self->ints[idx]);
+}
+
+void numarray_delete(RaelNumArrayValue *self) {
+    if (self->is_float)
+        free(self->floats);
+    else
+        free(self->ints);
+}
+
+size_t numarray_length(RaelNumArrayValue *self) {
+    return self->length;
+}
+
+bool numarray_as_bool(RaelNumArrayValue *self) {
+    return self->length > 0;
+}
+
+RaelValue *numarray_get(RaelNumArrayValue *self, size_t idx) {
+    if (idx >= self->length)
+        return NULL;
+    return numarray_number_at(self, idx);
+}
+
+RaelValue *numarray_slice(RaelNumArrayValue *self, size_t start, size_t end) {
+    RaelNumArrayValue *new_array;
+
+    // out of range
+    if (end < start || start > self->length || end > self->length)
+        return NULL;
+
+    new_array = (RaelNumArrayValue*)numarray_new(end - start, self->is_float);
+    if (end > start) {
+        if (self->is_float)
+            memcpy(new_array->floats, self->floats + start, (end - start) * sizeof(RaelFloat));
+        else
+            memcpy(new_array->ints, self->ints + start, (end - start) * sizeof(RaelInt));
+    }
+    return (RaelValue*)new_array;
+}
+
+RaelValue *numarray_copy(RaelNumArrayValue *self) {
+    return numarray_slice(self, 0, self->length);
+}
+
+bool numarray_eq(RaelNumArrayValue *self, RaelNumArrayValue *value) {
+    if (self->length != value->length)
+        return false;
+
+    if (!self->is_float && !value->is_float) {
+        for (size_t i = 0; i < self->length; ++i) {
+            if (self->ints[i] != value->ints[i])
+                return false;
+        }
+    } else {
+        for (size_t i = 0; i < self->length; ++i) {
+            RaelFloat lhs = self->is_float ? self->floats[i] : (RaelFloat)self->ints[i],
+                      rhs = value->is_float ? value->floats[i] : (RaelFloat)value->ints[i];
+            if (lhs != rhs)
+                return false;
+        }
+    }
+    return true;
+}
+
+void numarray_repr(RaelNumArrayValue *self) {
+    printf("NumArray { ");
+    for (size_t i = 0; i < self->length; ++i) {
+        if (i > 0)
+            printf(", ");
+        // the same format as number_repr
+        if (self->is_float)
+            printf("%.17g", self->floats[i]);
+        else
+            printf("%ld", self->ints[i]);
+    }
+    printf(" }");
+}
+
+RaelValue *numarray_cast(RaelNumArrayValue *self, RaelTypeValue *type) {
+    if (type == &RaelStackType) {
+        RaelStackValue *stack = (RaelStackValue*)stack_new(self->length);
+
+        for (size_t i = 0; i < self->length; ++i) {
+            RaelValue *number = numarray_number_at(self, i);
+            stack_push(stack, number);
+            value_deref(number);
+        }
+        return (RaelValue*)stack;
+    } else {
+        return NULL;
+    }
+}
+
+/* the element-wise operation between an array and an array of the same length, or a number */
+static RaelValue *numarray_operation(RaelNumArrayValue *self, RaelValue *value, enum NumArrayOperation operation) {
+    RaelNumArrayValue *new_array;
+    size_t length = self->length;
+
+    if (value->type == &RaelNumArrayType) {
+        RaelNumArrayValue *array = (RaelNumArrayValue*)value;
+
+        if (array->length != length)
+            return BLAME_NEW_CSTR("Expected arrays of the same length");
+
+        // division between whole numbers isn't always whole, so it always makes floats
+        if (self->is_float || array->is_float || operation == NumArrayDiv) {
+            RaelFloat *lhs = numarray_floats(self),
+                      *rhs = numarray_floats(array);
+
+            if (operation == NumArrayDiv && floats_contain_zero(rhs, length)) {
+                numarray_floats_free(self, lhs);
+                numarray_floats_free(array, rhs);
+                return BLAME_NEW_CSTR("Division by zero");
+            }
+            new_array = (RaelNumArrayValue*)numarray_new(length, true);
+            switch (operation) {
+            case NumArrayAdd: floats_add(new_array->floats, lhs, rhs, length); break;
+            case NumArraySub: floats_sub(new_array->floats, lhs, rhs, length); break;
+            case NumArrayMul: floats_mul(new_array->floats, lhs, rhs, length); break;
+            case NumArrayDiv: floats_div(new_array->floats, lhs, rhs, length); break;
+            }
+            numarray_floats_free(self, lhs);
+            numarray_floats_free(array, rhs);
+        } else {
+            new_array = (RaelNumArrayValue*)numarray_new(length, false);
+            switch (operation) {
+            case NumArrayAdd: ints_add(new_array->ints, self->ints, array->ints, length); break;
+            case NumArraySub: ints_sub(new_array->ints, self->ints, array->ints, length); break;
+            case NumArrayMul: ints_mul(new_array->ints, self->ints, array->ints, length); break;
+            case NumArrayDiv: RAEL_UNREACHABLE();
+            }
+        }
+    } else if (value->type == &RaelNumberType) {
+        RaelNumberValue *number = (RaelNumberValue*)value;
+
+        if (self->is_float || number->is_float || operation == NumArrayDiv) {
+            RaelFloat *lhs, rhs = number_to_float(number);
+
+            if (operation == NumArrayDiv && rhs == 0.0)
+                return BLAME_NEW_CSTR("Division by zero");
+            lhs = numarray_floats(self);
+            new_array = (RaelNumArrayValue*)numarray_new(length, true);
+            switch (operation) {
+            case NumArrayAdd: floats_add_number(new_array->floats, lhs, rhs, length); break;
+            case NumArraySub: floats_sub_number(new_array->floats, lhs, rhs, length); break;
+            case NumArrayMul: floats_mul_number(new_array->floats, lhs, rhs, length); break;
+            case NumArrayDiv: floats_div_number(new_array->floats, lhs, rhs, length); break;
+            }
+            numarray_floats_free(self, lhs);
+        } else {
+            new_array = (RaelNumArrayValue*)numarray_new(length, false);
+            switch (operation) {
+            case NumArrayAdd: ints_add_number(new_array->ints, self->ints, number->as_int, length); break;
+            case NumArraySub: ints_sub_number(new_array->ints, self->ints, number->as_int, length); break;
+            case NumArrayMul: ints_mul_number(new_array->ints, self->ints, number->as_int, length); break;
+            case NumArrayDiv: RAEL_UNREACHABLE();
+            }
+        }
+    } else {
+        return NULL;
+    }
+
+    return (RaelValue*)new_array;
+}
+
+RaelValue *numarray_add(RaelNumArrayValue *self, RaelValue *value) {
+    return numarray_operation(self, value, NumArrayAdd);
+}
+
+RaelValue *numarray_sub(RaelNumArrayValue *self, RaelValue *value) {
+    return numarray_operation(self, value, NumArraySub);
+}
+
+RaelValue *numarray_mul(RaelNumArrayValue *self, RaelValue *value) {
+    return numarray_operation(self, value, NumArrayMul);
+}
+
+RaelValue *numarray_div(RaelNumArrayValue *self, RaelValue *value) {
+    return numarray_operation(self, value, NumArrayDiv);
+}
+
+RaelValue *numarray_neg(RaelNumArrayValue *self) {
+    RaelNumArrayValue *new_array = (RaelNumArrayValue*)numarray_new(self->length, self->is_float);
+
+    if (self->is_float)
+        floats_mul_number(new_array->floats, self->floats, -1.0, self->length);
+    else
+        ints_mul_number(new_array->ints, self->ints, -1, self->length);
+    return (RaelValue*)new_array;
+}
+
+/* construct a NumArray from an iterable of numbers */
+RaelValue *numarray_construct(RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *iterable;
+    RaelNumArrayValue *array;
+    size_t length;
+
+    (void)interpreter;
+    assert(arguments_amount(args) == 1);
+    iterable = arguments_get(args, 0);
+
+    if (!value_is_iterable(iterable))
+        return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 0));
+
+    length = value_length(iterable);
+    // the array stays whole until it gets a float
+    array = (RaelNumArrayValue*)numarray_new(length, false);
+    for (size_t i = 0; i < length; ++i) {
+        RaelValue *value = value_get(iterable, i);
+        RaelNumberValue *number;
+
+        if (value->type != &RaelNumberType) {
+            value_deref(value);
+            value_deref((RaelValue*)array);
+            return BLAME_NEW_CSTR_ST("Iterable does not produce numbers", *arguments_state(args, 0));
+        }
+        number = (RaelNumberValue*)value;
+        if (number->is_float && !array->is_float)
+            numarray_make_float(array, i);
+        if (array->is_float)
+            array->floats[i] = number_to_float(number);
+        else
+            array->ints[i] = number->as_int;
+        value_deref(value);
+    }
+
+    return (RaelValue*)array;
+}
+
+RaelValue *numarray_method_sum(RaelNumArrayValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    (void)args;
+    (void)interpreter;
+    if (self->is_float)
+        return number_newf(floats_sum(self->floats, self->length));
+    else
+        return number_newi(ints_sum(self->ints, self->length));
+}
+
+RaelValue *numarray_method_min(RaelNumArrayValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    (void)args;
+    (void)interpreter;
+    if (self->length == 0)
+        return BLAME_NEW_CSTR("Expected a non-empty array");
+    if (self->is_float)
+        return number_newf(floats_min(self->floats, self->length));
+    else
+        return number_newi(ints_min(self->ints, self->length));
+}
+
+RaelValue *numarray_method_max(RaelNumArrayValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    (void)args;
+    (void)interpreter;
+    if (self->length == 0)
+        return BLAME_NEW_CSTR("Expected a non-empty array");
+    if (self->is_float)
+        return number_newf(floats_max(self->floats, self->length));
+    else
+        return number_newi(ints_max(self->ints, self->length));
+}
+
+/* the sum of the products of the numbers of two arrays of the same length */
+RaelValue *numarray_method_dot(RaelNumArrayValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *arg1;
+    RaelNumArrayValue *array;
+    RaelFloat *lhs, *rhs, dot;
+
+    (void)interpreter;
+    arg1 = arguments_get(args, 0);
+    if (arg1->type != &RaelNumArrayType)
+        return BLAME_NEW_CSTR_ST("Expected a NumArray", *arguments_state(args, 0));
+    array = (RaelNumArrayValue*)arg1;
+    if (array->length != self->length)
+        return BLAME_NEW_CSTR_ST("Expected arrays of the same length", *arguments_state(args, 0));
+
+    if (!self->is_float && !array->is_float)
+        return number_newi(ints_dot(self->ints, array->ints, self->length));
+
+    lhs = numarray_floats(self);
+    rhs = numarray_floats(array);
+    dot = floats_dot(lhs, rhs, self->length);
+    numarray_floats_free(self, lhs);
+    numarray_floats_free(array, rhs);
+    return number_newf(dot);
+}
+
+static RaelConstructorInfo numarray_constructor_info = {
+    (RaelConstructorFunc)numarray_construct,
+    true,
+    1,
+    1
+};
+
+RaelTypeValue RaelNumArrayType = {
+    RAEL_TYPE_DEF_INIT,
+    .name = "NumArray",
+    .op_add = (RaelBinExprFunc)numarray_add,
+    .op_sub = (RaelBinExprFunc)numarray_sub,
+    .op_mul = (RaelBinExprFunc)numarray_mul,
+    .op_div = (RaelBinExprFunc)numarray_div,
+    .op_mod = NULL,
+    .op_red = NULL,
+    .op_eq = (RaelBinCmpFunc)numarray_eq,
+    .op_smaller = NULL,
+    .op_bigger = NULL,
+    .op_smaller_eq = NULL,
+    .op_bigger_eq = NULL,
+
+    .op_neg = (RaelNegFunc)numarray_neg,
+
+    .callable_info = NULL,
+    .constructor_info = &numarray_constructor_info,
+    .op_ref = NULL,
+    .op_deref = NULL,
+
+    .as_bool = (RaelAsBoolFunc)numarray_as_bool,
+    .deallocator = (RaelSingleFunc)numarray_delete,
+    .repr = (RaelSingleFunc)numarray_repr,
+    .logger = NULL, /* fallbacks to .repr */
+
+    .cast = (RaelCastFunc)numarray_cast,
+    .copy = (RaelCopyFunc)numarray_copy,
+
+    .at_index = (RaelGetFunc)numarray_get,
+    .at_range = (RaelSliceFunc)numarray_slice,
+
+    .length = (RaelLengthFunc)numarray_length,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
+
+    .methods = (MethodDecl[]) {
+        RAEL_CMETHOD("sum", numarray_method_sum, 0, 0),
+        RAEL_CMETHOD("min", numarray_method_min, 0, 0),
+        RAEL_CMETHOD("max", numarray_method_max, 0, 0),
+        RAEL_CMETHOD("dot", numarray_method_dot, 1, 1),
+        RAEL_CMETHOD_TERMINATOR
+    }
+};
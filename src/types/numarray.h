@@ -0,0 +1,29 @@
+#ifndef RAEL_NUMARRAY_H
+#define RAEL_NUMARRAY_H
+
+#include "common.h"
+#include "value.h"
+
+#include <stdbool.h>
+
+/*
+ * A NumArray is an array of numbers that are stored next to each other, instead of as separate values.
+ * All of the numbers of an array are either whole numbers or floats, and arithmetic between arrays
+ * is done element-wise by loops that the compiler can vectorize. It's available as :Math:NumArray.
+ */
+typedef struct RaelNumArrayValue {
+    RAEL_VALUE_BASE;
+    bool is_float;
+    size_t length;
+    union {
+        RaelInt *ints;
+        RaelFloat *floats;
+    };
+} RaelNumArrayValue;
+
+extern RaelTypeValue RaelNumArrayType;
+
+/* create an array of `length` numbers, which aren't initialized */
+RaelValue *numarray_new(size_t length, bool is_float);
+
+#endif /* RAEL_NUMARRAY_H */
@@ -84,7 +84,7 @@ RaelValue *number_add(RaelNumberValue *self, RaelValue *value) {
 RaelValue *number_sub(RaelNumberValue *self, RaelValue *value) {
     if (number_validate(value)) {
         RaelNumberValue *number = (RaelNumberValue*)value;
-        if (self->is_float || self->is_float)
+        if (self->is_float || number->is_float)
             return number_newf(number_to_float(self) - number_to_float(number));
         else
             return number_newi(self->as_int - number->as_int);
@@ -97,7 +97,7 @@ RaelValue *number_mul(RaelNumberValue *self, RaelValue *value) {
     // TODO: add number * string
     if (number_validate(value)) {
         RaelNumberValue *number = (RaelNumberValue*)value;
-        if (self->is_float || self->is_float)
+        if (self->is_float || number->is_float)
             return number_newf(number_to_float(self) * number_to_float(number));
         else
             return number_newi(self->as_int * number->as_int);
@@ -294,6 +294,14 @@ bool number_positive(RaelNumberValue *self) {
     }
 }
 
+RaelValue *number_copy(RaelNumberValue *self) {
+    if (self->is_float) {
+        return number_newf(self->as_float);
+    } else {
+        return number_newi(self->as_int);
+    }
+}
+
 RaelValue *number_cast(RaelNumberValue *self, RaelTypeValue *type) {
     if (type == &RaelStringType) {
         // FIXME: make float conversions more accurate
@@ -462,11 +470,16 @@ RaelTypeValue RaelNumberType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = (RaelCastFunc)number_cast,
+    .copy = (RaelCopyFunc)number_copy,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = (MethodDecl[]) {
         RAEL_CMETHOD("signedMod", number_method_signedMod, 1, 1),
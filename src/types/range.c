@@ -9,6 +9,10 @@ RaelValue *range_new(RaelInt start, RaelInt end) {
     return (RaelValue*)range;
 }
 
+RaelValue *range_copy(RaelRangeValue *self) {
+    return range_new(self->start, self->end);
+}
+
 RaelInt range_at(RaelRangeValue *self, size_t idx) {
     assert(idx <= range_length(self));
     // get the number, depending on the direction
@@ -137,11 +141,16 @@ RaelTypeValue RaelRangeType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = (RaelCopyFunc)range_copy,
 
     .at_index = (RaelGetFunc)range_get,
     .at_range = (RaelSliceFunc)range_slice,
 
     .length = (RaelLengthFunc)range_length,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = NULL
 };
@@ -1,39 +1,97 @@
 #include "rael.h"
 
-RaelValue *routine_call(RaelRoutineValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
-    struct Scope *prev_scope;
-    size_t amount_params = self->amount_parameters;
-
-    // store last scopes
-    prev_scope = interpreter->instance->scope;
-    // create new "scope chain"
-    interpreter->instance->scope = self->scope;
-    interpreter_push_scope(interpreter);
-
-    for (size_t i = 0; i < amount_params; ++i) {
-        RaelValue *value = arguments_get(args, i);
-        assert(value); // you must get a value
-        // set the parameter
-        scope_set_local(interpreter->instance->scope, self->parameters[i], value, false);
+RaelInt routine_validate_args(RaelRoutineValue *self, size_t amount) {
+    if (amount < self->amount_parameters) {
+        return -1;
+    } else if (amount > self->amount_parameters) {
+        return 1;
+    } else {
+        return 0;
     }
+}
 
-    // run the block of code
-    block_run(interpreter, self->block, false);
-
-    if (interpreter->instance->interrupt == ProgramInterruptReturn) {
-        // if had a return statement
-        ;
-    } else {
-        // if you get to the end of the function without returning anything, return a Void
-        interpreter->instance->returned_value = void_new();
+RaelValue *routine_call(RaelRoutineValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelInstance *instance = interpreter->instance;
+    struct Scope *prev_scope;
+    // the routine and the arguments of the last tail call, which are owned by this call
+    RaelRoutineValue *tail_routine = NULL;
+    RaelArgumentList tail_args;
+    struct State tail_state;
+    bool made_tail_call = false;
+    RaelInt validation;
+    RaelValue *returned_value;
+
+    if (self->is_generator)
+        return generator_new(self, args, interpreter);
+    // a generator has a stack of its own, so recursion that would overflow it is stopped with a blame
+    if (interpreter->generator && generator_stack_exhausted(interpreter->generator))
+        return BLAME_NEW_CSTR("Too much recursion in a generator");
+
+    // every iteration runs a routine. routines that return a call to a routine continue the loop with it
+    for (;;) {
+        // store last scopes
+        prev_scope = instance->scope;
+        // create new "scope chain"
+        instance->scope = self->scope;
+        interpreter_push_scope(interpreter);
+
+        for (size_t i = 0; i < self->amount_parameters; ++i) {
+            RaelValue *value = arguments_get(args, i);
+            assert(value); // you must get a value
+            // set the parameter
+            scope_set_local(instance->scope, self->parameters[i], value, false);
+        }
+
+        // run the block of code
+        jit_block_run(interpreter, &self->jit, self->block);
+
+        if (instance->interrupt == ProgramInterruptReturn) {
+            // if had a return statement
+            returned_value = instance->returned_value;
+        } else {
+            // if you get to the end of the function without returning anything, return a Void
+            returned_value = void_new();
+        }
+
+        // clear interrupt
+        instance->interrupt = ProgramInterruptNone;
+        instance->returned_value = NULL;
+        // remove routine scope and restore previous scope
+        interpreter_pop_scope(interpreter);
+        instance->scope = prev_scope;
+
+        if (tail_routine) {
+            arguments_delete(&tail_args);
+            value_deref((RaelValue*)tail_routine);
+            tail_routine = NULL;
+        }
+
+        // if the routine returned a call, make it without nesting
+        if (!instance->tail_callable)
+            break;
+        assert(!returned_value);
+        tail_routine = (RaelRoutineValue*)instance->tail_callable;
+        tail_args = instance->tail_args;
+        tail_state = instance->tail_state;
+        instance->tail_callable = NULL;
+        made_tail_call = true;
+
+        validation = routine_validate_args(tail_routine, arguments_amount(&tail_args));
+        if (validation != 0) {
+            returned_value = callable_blame_from_validation(validation);
+            arguments_delete(&tail_args);
+            value_deref((RaelValue*)tail_routine);
+            tail_routine = NULL;
+            break;
+        }
+        self = tail_routine;
+        args = &tail_args;
     }
 
-    // clear interrupt
-    interpreter->instance->interrupt = ProgramInterruptNone;
-    // remove routine scope and restore previous scope
-    interpreter_pop_scope(interpreter);
-    interpreter->instance->scope = prev_scope;
-    return interpreter->instance->returned_value;
+    // a blame from the last tail call gets the state of that call, like in a nested call
+    if (made_tail_call && blame_validate(returned_value))
+        blame_set_state((RaelBlameValue*)returned_value, tail_state);
+    return returned_value;
 }
 
 void routine_repr(RaelRoutineValue *self) {
@@ -46,19 +104,9 @@ void routine_repr(RaelRoutineValue *self) {
     printf(")");
 }
 
-RaelInt routine_validate_args(RaelRoutineValue *self, size_t amount) {
-    if (amount < self->amount_parameters) {
-        return -1;
-    } else if (amount > self->amount_parameters) {
-        return 1;
-    } else {
-        return 0;
-    }
-}
-
 void routine_delete(RaelRoutineValue *self) {
-    for (size_t i = 0; self->block[i]; ++i)
-        instruction_deref(self->block[i]);
+    jit_state_delete(&self->jit);
+    block_delete(self->block);
     scope_deref(self->scope);
 }
 
@@ -95,11 +143,16 @@ RaelTypeValue RaelRoutineType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = NULL
 };
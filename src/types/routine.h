@@ -2,6 +2,7 @@
 #define RAEL_ROUTINE_H
 
 #include "value.h"
+#include "jit.h"
 
 extern RaelTypeValue RaelRoutineType;
 
@@ -11,6 +12,10 @@ typedef struct RaelRoutineValue {
     char **parameters;
     size_t amount_parameters;
     RaelInstruction **block;
+    /* calling a generator routine returns a generator instead of running the routine */
+    bool is_generator;
+    /* counts the calls of the routine, and compiles its block when it's hot */
+    RaelJitState jit;
 } RaelRoutineValue;
 
 #endif /* RAEL_ROUTINE_H */
\ No newline at end of file
@@ -1,11 +1,175 @@
 #include "rael.h"
 #include "value.h"
 
+static size_t storage_item_size(enum StackStorage storage) {
+    switch (storage) {
+    case StackStorageBytes: return sizeof(signed char);
+    case StackStorageInts: return sizeof(RaelInt);
+    case StackStorageFloats: return sizeof(RaelFloat);
+    case StackStorageValues: return sizeof(RaelValue*);
+    default: RAEL_UNREACHABLE(); return 0;
+    }
+}
+
+/*
+ * the most compact storage a value can be pushed in. a number is only stored by itself if the reference
+ * that is pushed is its only one, because a number that is referenced somewhere else has an identity to keep
+ */
+static enum StackStorage storage_of_value(RaelValue *value) {
+    RaelNumberValue *number;
+
+    if (value->type != &RaelNumberType || value->reference_count != 1)
+        return StackStorageValues;
+    number = (RaelNumberValue*)value;
+    if (number->is_float)
+        return StackStorageFloats;
+    if (number->as_int >= SCHAR_MIN && number->as_int <= SCHAR_MAX)
+        return StackStorageBytes;
+    return StackStorageInts;
+}
+
+/* the storage that can store both the values of the stack and a value that needs `storage` */
+static enum StackStorage stack_storage_with(RaelStackValue *self, enum StackStorage storage) {
+    if (self->length == 0 || self->storage == storage)
+        return storage;
+    // whole numbers and floats aren't mixed, because a whole number stored as a float would become a float
+    if (self->storage == StackStorageValues || storage == StackStorageValues ||
+        self->storage == StackStorageFloats || storage == StackStorageFloats)
+        return StackStorageValues;
+    return StackStorageInts;
+}
+
+/* the value at an index of the stack, without a check of the index. the value is referenced */
+static RaelValue *stack_value_at(RaelStackValue *self, size_t idx) {
+    switch (self->storage) {
+    case StackStorageBytes: return number_newi(self->bytes[idx]);
+    case StackStorageInts: return number_newi(self->ints[idx]);
+    case StackStorageFloats: return number_newf(self->floats[idx]);
+    case StackStorageValues:
+        value_ref(self->values[idx]);
+        return self->values[idx];
+    default:
+        RAEL_UNREACHABLE();
+        return NULL;
+    }
+}
+
+/* store a number in an index of a stack that doesn't store values. the number must fit the storage */
+static void stack_store_number(RaelStackValue *self, size_t idx, RaelNumberValue *number) {
+    switch (self->storage) {
+    case StackStorageBytes: self->bytes[idx] = (signed char)number->as_int; break;
+    case StackStorageInts: self->ints[idx] = number->as_int; break;
+    case StackStorageFloats: self->floats[idx] = number->as_float; break;
+    default: RAEL_UNREACHABLE();
+    }
+}
+
+static void stack_buffer_deref(RaelStackBuffer *buffer, enum StackStorage storage) {
+    if (--buffer->reference_count > 0)
+        return;
+    if (storage == StackStorageValues) {
+        for (size_t i = 0; i < buffer->length; ++i)
+            value_deref(((RaelValue**)buffer->items)[i]);
+    }
+    free(buffer->items);
+    free(buffer);
+}
+
+/* free the items of the stack, or stop using them if they're shared */
+static void stack_free_items(RaelStackValue *self) {
+    if (self->buffer) {
+        stack_buffer_deref(self->buffer, self->storage);
+        self->buffer = NULL;
+    } else {
+        if (self->storage == StackStorageValues) {
+            for (size_t i = 0; i < self->length; ++i)
+                value_deref(self->values[i]);
+        }
+        free(self->bytes);
+    }
+}
+
+/* make the items of the stack belong to it (copy-on-write), so they can be changed */
+static void stack_unshare(RaelStackValue *self) {
+    RaelStackBuffer *buffer = self->buffer;
+    size_t item_size;
+    void *items;
+
+    if (!buffer)
+        return;
+    // if no other stack uses the buffer, and the stack uses all of it, it can take the items back
+    if (buffer->reference_count == 1 && self->bytes == buffer->items && self->length == buffer->length) {
+        free(buffer);
+        self->buffer = NULL;
+        return;
+    }
+
+    item_size = storage_item_size(self->storage);
+    items = malloc(self->length * item_size);
+    memcpy(items, self->bytes, self->length * item_size);
+    if (self->storage == StackStorageValues) {
+        for (size_t i = 0; i < self->length; ++i)
+            value_ref(((RaelValue**)items)[i]);
+    }
+    stack_buffer_deref(buffer, self->storage);
+    self->buffer = NULL;
+    self->bytes = items;
+    self->allocated = self->length;
+}
+
+/* move the values of the stack to a more general storage */
+static void stack_convert(RaelStackValue *self, enum StackStorage storage) {
+    void *items = self->allocated == 0 ? NULL : malloc(self->allocated * storage_item_size(storage));
+
+    switch (storage) {
+    case StackStorageInts:
+        assert(self->length == 0 || self->storage == StackStorageBytes);
+        for (size_t i = 0; i < self->length; ++i)
+            ((RaelInt*)items)[i] = self->bytes[i];
+        break;
+    case StackStorageValues:
+        for (size_t i = 0; i < self->length; ++i)
+            ((RaelValue**)items)[i] = stack_value_at(self, i);
+        break;
+    default:
+        // stacks only move to a more compact storage when they're empty
+        assert(self->length == 0);
+    }
+    // stacks never move from storing values, so freeing the old items doesn't dereference values
+    stack_free_items(self);
+    self->bytes = items;
+    self->storage = storage;
+}
+
+/*
+ * numbers that are stored by themselves are made again every time they're read, so before one of them
+ * is given out, the stack moves to storing values. from then on, the numbers that are read from it
+ * are the same values every time (they can be found by pointer, and keep the keys that are set on them)
+ */
+static void stack_store_values(RaelStackValue *self) {
+    if (self->storage == StackStorageValues)
+        return;
+    stack_unshare(self);
+    stack_convert(self, StackStorageValues);
+}
+
 RaelValue *stack_new(size_t overhead) {
     RaelStackValue *stack = RAEL_VALUE_NEW(RaelStackType, RaelStackValue);
+    stack->storage = StackStorageBytes;
+    stack->buffer = NULL;
     stack->allocated = overhead;
     stack->length = 0;
-    stack->values = overhead == 0 ? NULL : malloc(overhead * sizeof(RaelValue*));
+    stack->bytes = overhead == 0 ? NULL : malloc(overhead * sizeof(signed char));
+    return (RaelValue*)stack;
+}
+
+RaelValue *stack_new_from(RaelValue **values, size_t length, size_t allocated) {
+    RaelStackValue *stack = RAEL_VALUE_NEW(RaelStackType, RaelStackValue);
+    stack->storage = StackStorageValues;
+    stack->buffer = NULL;
+    stack->allocated = allocated;
+    stack->length = length;
+    stack->values = values;
     return (RaelValue*)stack;
 }
 
@@ -13,125 +177,201 @@ size_t stack_length(RaelStackValue *stack) {
     return stack->length;
 }
 
-RaelValue **stack_get_ptr(RaelStackValue *self, size_t idx) {
+RaelValue *stack_get(RaelStackValue *self, size_t idx) {
     // if out of range
     if (idx >= stack_length(self))
         return NULL;
-    return &self->values[idx];
+    stack_store_values(self);
+    return stack_value_at(self, idx);
 }
 
-RaelValue *stack_get(RaelStackValue *self, size_t idx) {
-    RaelValue **value_ptr = stack_get_ptr(self, idx);
+/* a slice that has its own copy of the items */
+static RaelValue *stack_slice_copy(RaelStackValue *self, size_t start, size_t end) {
+    RaelStackValue *new_stack;
+    size_t new_len = end - start;
 
-    if (!value_ptr)
-        return NULL;
-    value_ref(*value_ptr);
-    return *value_ptr;
+    new_stack = RAEL_VALUE_NEW(RaelStackType, RaelStackValue);
+    new_stack->storage = self->storage;
+    new_stack->buffer = NULL;
+    new_stack->allocated = new_len;
+    new_stack->length = new_len;
+    new_stack->bytes = new_len == 0 ? NULL : malloc(new_len * storage_item_size(self->storage));
+
+    if (self->storage == StackStorageValues) {
+        for (size_t i = 0; i < new_len; ++i) {
+            RaelValue *value = self->values[start + i];
+            value_ref(value);
+            new_stack->values[i] = value;
+        }
+    } else if (new_len > 0) {
+        size_t item_size = storage_item_size(self->storage);
+        memcpy(new_stack->bytes, self->bytes + start * item_size, new_len * item_size);
+    }
+
+    return (RaelValue*)new_stack;
 }
 
+/* a slice shares the items of its stack, unless it's small (see RAEL_STACK_SHARED_SLICE_LENGTH) */
 RaelValue *stack_slice(RaelStackValue *self, size_t start, size_t end) {
     RaelStackValue *new_stack;
-    RaelValue **new_dump;
     size_t new_len;
     const size_t len = stack_length(self);
 
     // out of range
     if (end < start || start > len || end > len)
         return NULL;
-
-    // allocate a new dump of pointers
-    new_dump = malloc((new_len = end - start) * sizeof(RaelValue*));
-
-    for (size_t i = 0; i < new_len; ++i) {
-        RaelValue *value = self->values[start + i];
-        value_ref(value);
-        new_dump[i] = value;
+    // the items of a slice are the same values as the items of its stack
+    stack_store_values(self);
+
+    new_len = end - start;
+    if (new_len < RAEL_STACK_SHARED_SLICE_LENGTH || new_len * RAEL_STACK_SHARED_SLICE_RATIO < len)
+        return stack_slice_copy(self, start, end);
+
+    // move the items of the stack to a buffer, if they aren't already in one
+    if (!self->buffer) {
+        self->buffer = malloc(sizeof(RaelStackBuffer));
+        self->buffer->reference_count = 1;
+        self->buffer->length = self->length;
+        self->buffer->items = self->bytes;
     }
+    ++self->buffer->reference_count;
 
     new_stack = RAEL_VALUE_NEW(RaelStackType, RaelStackValue);
+    new_stack->storage = self->storage;
+    new_stack->buffer = self->buffer;
     new_stack->allocated = new_len;
     new_stack->length = new_len;
-    new_stack->values = new_dump;
+    new_stack->bytes = self->bytes + start * storage_item_size(self->storage);
 
     return (RaelValue*)new_stack;
 }
 
 bool stack_set(RaelStackValue *self, size_t idx, RaelValue *value) {
-    RaelValue **value_address = stack_get_ptr(self, idx);
     // index out of range
-    if (!value_address)
-        return NULL;
-    value_deref(*value_address);
-    *value_address = value;
+    if (idx >= stack_length(self))
+        return false;
+
+    // the value is also returned from the set expression, so it's stored as itself
+    stack_unshare(self);
+    stack_store_values(self);
+    value_ref(value);
+    value_deref(self->values[idx]);
+    self->values[idx] = value;
     return true;
 }
 
 void stack_push(RaelStackValue *self, RaelValue *value) {
-    RaelValue **values;
-    size_t allocated, length;
+    enum StackStorage storage;
 
-    values = self->values;
-    allocated = self->allocated;
-    length = stack_length(self);
+    stack_unshare(self);
+    if ((storage = stack_storage_with(self, storage_of_value(value))) != self->storage)
+        stack_convert(self, storage);
 
     // allocate additional space for stack if there isn't enough
-    if (allocated == 0)
-        values = malloc((allocated = 16) * sizeof(RaelValue*));
-    else if (length >= allocated)
-        values = realloc(values, (allocated += 16) * sizeof(RaelValue*));
-
-    value_ref(value);
-    values[length++] = value;
+    if (self->length >= self->allocated) {
+        self->allocated += 16;
+        self->bytes = realloc(self->bytes, self->allocated * storage_item_size(self->storage));
+    }
 
-    // update the stack
-    self->values = values;
-    self->allocated = allocated;
-    self->length = length;
+    if (self->storage == StackStorageValues) {
+        value_ref(value);
+        self->values[self->length] = value;
+    } else {
+        stack_store_number(self, self->length, (RaelNumberValue*)value);
+    }
+    ++self->length;
 }
 
 // stack << value
 RaelValue *stack_red(RaelStackValue *self, RaelValue *value) {
+    string_compact(value);
     stack_push(self, value);
     value_ref((RaelValue*)self);
     return (RaelValue*)self;
 }
 
 void stack_delete(RaelStackValue *self) {
-    for (size_t i = 0; i < self->length; ++i) {
-        value_deref(self->values[i]);
-    }
-    if (self->allocated > 0) {
-        free(self->values);
-    }
+    stack_free_items(self);
 }
 
 void stack_repr(RaelStackValue *self) {
     printf("{ ");
     for (size_t i = 0; i < self->length; ++i) {
+        RaelValue *value = stack_value_at(self, i);
+
         if (i > 0)
             printf(", ");
-        value_repr(self->values[i]);
+        value_repr(value);
+        value_deref(value);
     }
     printf(" }");
 }
 
 bool stack_eq(RaelStackValue *self, RaelStackValue *value) {
-    bool are_equal;
     size_t len1 = stack_length(self),
            len2 = stack_length(value);
 
-    if (len1 == len2) {
-        are_equal = true;
-        for (size_t i = 0; are_equal && i < len1; ++i) {
-            if (!values_eq(self->values[i], value->values[i])) {
-                are_equal = false;
+    // if lengths are not equal, the stacks can't be equal
+    if (len1 != len2)
+        return false;
+
+    // stacks of the same kind of numbers are compared without making values
+    if (self->storage == value->storage && self->storage != StackStorageValues) {
+        for (size_t i = 0; i < len1; ++i) {
+            switch (self->storage) {
+            case StackStorageBytes:
+                if (self->bytes[i] != value->bytes[i])
+                    return false;
+                break;
+            case StackStorageInts:
+                if (self->ints[i] != value->ints[i])
+                    return false;
+                break;
+            case StackStorageFloats:
+                if (self->floats[i] != value->floats[i])
+                    return false;
+                break;
+            default:
+                RAEL_UNREACHABLE();
             }
         }
-    } else { // if lengths are not equal, the stacks can't be equal
-        are_equal = false;
+        return true;
+    }
+
+    for (size_t i = 0; i < len1; ++i) {
+        RaelValue *value1 = stack_value_at(self, i),
+                  *value2 = stack_value_at(value, i);
+        bool are_equal = values_eq(value1, value2);
+
+        value_deref(value1);
+        value_deref(value2);
+        if (!are_equal)
+            return false;
+    }
+    return true;
+}
+
+/* copy the stack and all of its values. if one of the values can't be copied, return NULL */
+RaelValue *stack_copy(RaelStackValue *self) {
+    RaelStackValue *copy;
+
+    // numbers are copied by copying the storage. the copy doesn't share the items, because copies
+    // are sent to other threads
+    if (self->storage != StackStorageValues)
+        return stack_slice_copy(self, 0, self->length);
+
+    copy = (RaelStackValue*)stack_new(self->length);
+    for (size_t i = 0; i < self->length; ++i) {
+        RaelValue *value = value_copy(self->values[i]);
+        if (!value) {
+            value_deref((RaelValue*)copy);
+            return NULL;
+        }
+        stack_push(copy, value);
+        value_deref(value);
     }
 
-    return are_equal;
+    return (RaelValue*)copy;
 }
 
 bool stack_as_bool(RaelStackValue *self) {
@@ -140,7 +380,8 @@ bool stack_as_bool(RaelStackValue *self) {
 
 void stack_maybe_shrink(RaelStackValue *self) {
     if (self->allocated - self->length >= 8) {
-        self->values = realloc(self->values, (self->allocated -= 8) * sizeof(RaelValue*));
+        self->allocated -= 8;
+        self->bytes = realloc(self->bytes, self->allocated * storage_item_size(self->storage));
     }
 }
 
@@ -189,19 +430,23 @@ static RaelValue *stack_method_pop(RaelStackValue *self, RaelArgumentList *args,
         RAEL_UNREACHABLE();
     }
 
-    // get the popped value
-    popped = stack_get(self, pop_index);
+    stack_unshare(self);
+    // get the popped value, and drop the reference of the stack to it
+    popped = stack_value_at(self, pop_index);
+    if (self->storage == StackStorageValues)
+        value_deref(self->values[pop_index]);
 
     // move everything back
-    for (size_t i = pop_index; i < length - 1; ++i) {
-        stack_set(self, i, stack_get(self, i + 1));
+    if (pop_index < length - 1) {
+        size_t item_size = storage_item_size(self->storage);
+        memmove(self->bytes + pop_index * item_size, self->bytes + (pop_index + 1) * item_size,
+                (length - 1 - pop_index) * item_size);
     }
 
     // dec length
     --self->length;
     stack_maybe_shrink(self);
 
-    // no need to deref/ref because we take the value from the stack and use it once
     return popped;
 }
 
@@ -239,15 +484,12 @@ static RaelValue *stack_method_findIndexOf(RaelStackValue *self, RaelArgumentLis
 
     // loop and find a matching value
     for (size_t i = 0; index == -1 && i < length; ++i) {
-        if (ptr_comparison) {
-            if (stack_get(self, i) == compared) {
-                index = (RaelInt)i;
-            }
-        } else {
-            if (values_eq(stack_get(self, i), compared)) {
-                index = (RaelInt)i;
-            }
+        RaelValue *value = stack_value_at(self, i);
+
+        if (ptr_comparison ? value == compared : values_eq(value, compared)) {
+            index = (RaelInt)i;
         }
+        value_deref(value);
     }
 
     return number_newi(index);
@@ -281,11 +523,16 @@ RaelTypeValue RaelStackType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = (RaelCopyFunc)stack_copy,
 
     .at_index = (RaelGetFunc)stack_get,
     .at_range = (RaelSliceFunc)stack_slice,
 
     .length = (RaelLengthFunc)stack_length,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = (MethodDecl[]) {
         RAEL_CMETHOD("pop", stack_method_pop, 0, 1),
@@ -12,9 +12,49 @@
  * not the execution stack's implementation
  */
 
+/* slices with fewer items than this are copied instead of sharing the items of their stack */
+#define RAEL_STACK_SHARED_SLICE_LENGTH 16
+/* slices that are this many times smaller than their stack are copied, so they don't keep its items alive */
+#define RAEL_STACK_SHARED_SLICE_RATIO 8
+
+/*
+ * How a stack stores its values. Stacks of numbers store the numbers themselves instead of values,
+ * in the most compact storage that fits all of them. When a value that doesn't fit is added,
+ * the stack moves to a more general storage (bytes -> ints -> values, floats -> values).
+ * A stack also moves to storing values when one of its numbers is read, set or sliced, so the
+ * numbers that are given out keep their identity.
+ */
+enum StackStorage {
+    StackStorageBytes, /* whole numbers in the range of a signed char */
+    StackStorageInts, /* whole numbers */
+    StackStorageFloats, /* numbers that are floats */
+    StackStorageValues /* references to any values */
+};
+
+/*
+ * The items of a stack, when they are shared between the stack and its slices.
+ * The buffer owns the items (and references the values in them), and a stack copies
+ * the items it uses out of the buffer before it changes them.
+ */
+typedef struct RaelStackBuffer {
+    size_t reference_count;
+    /* the amount of items in the buffer */
+    size_t length;
+    void *items;
+} RaelStackBuffer;
+
 typedef struct RaelStackValue {
     RAEL_VALUE_BASE;
-    RaelValue **values;
+    enum StackStorage storage;
+    /* the buffer that the items are in, or NULL if the items belong to the stack */
+    RaelStackBuffer *buffer;
+    union {
+        signed char *bytes;
+        RaelInt *ints;
+        RaelFloat *floats;
+        RaelValue **values;
+    };
+    /* `allocated` is counted in items of the storage */
     size_t length, allocated;
 } RaelStackValue;
 
@@ -22,16 +62,18 @@ extern RaelTypeValue RaelStackType;
 
 RaelValue *stack_new(size_t overhead);
 
+/* create a stack that takes an allocated array of `length` referenced values, which has room for `allocated` values */
+RaelValue *stack_new_from(RaelValue **values, size_t length, size_t allocated);
+
 void stack_delete(RaelStackValue *self);
 
 size_t stack_length(RaelStackValue *self);
 
-RaelValue **stack_get_ptr(RaelStackValue *self, size_t idx);
-
 RaelValue *stack_get(RaelStackValue *self, size_t idx);
 
 RaelValue *stack_slice(RaelStackValue *self, size_t start, size_t end);
 
+/* set the value at an index. returns false if the index is out of range */
 bool stack_set(RaelStackValue *self, size_t idx, RaelValue *value);
 
 void stack_push(RaelStackValue *self, RaelValue *value);
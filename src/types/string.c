@@ -3,43 +3,231 @@
 #include "string.h"
 
 #include <string.h>
+#include <pthread.h>
+
+static RaelStringValue empty_string = {
+    ._base = {
+        .type = &RaelStringType,
+        .reference_count = RAEL_REFCOUNT_IMMORTAL
+    },
+    .type = StringTypePure,
+    .interned = true,
+    .source = "",
+    .length = 0,
+    .hash = 0,
+    .can_be_freed = false
+};
+
+/* the strings of all of the chars, which are built the first time one of them is needed */
+static RaelStringValue *single_char_strings[256];
+static pthread_once_t single_char_strings_once = PTHREAD_ONCE_INIT;
+
+/* the interned strings, in an open addressing table. the strings are never freed */
+static struct {
+    RaelStringValue **strings;
+    size_t allocated, amount;
+    pthread_mutex_t lock;
+} interned_strings = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+
+/* counters of the substrings that are alive (see RaelStringStats) */
+static RaelStringStats substring_stats = { 0, 0, 0 };
+
+/* FNV-1a. 0 means that a hash wasn't computed, so it's never returned */
+static size_t hash_chars(const char *source, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char)source[i];
+        hash *= 1099511628211ull;
+    }
+    return (size_t)hash ? (size_t)hash : 1;
+}
+
+/* a string with room for `length` chars in its source, which are stored in the value if they fit */
+static RaelStringValue *string_new_sized(size_t length) {
+    RaelStringValue *string;
+
+    if (length <= RAEL_STRING_SHORT_LENGTH) {
+        string = (RaelStringValue*)value_new(&RaelStringType, sizeof(RaelStringValue) + length * sizeof(char));
+        string->type = StringTypeShort;
+        string->source = string->short_source;
+    } else {
+        string = RAEL_VALUE_NEW(RaelStringType, RaelStringValue);
+        string->type = StringTypePure;
+        string->can_be_freed = true;
+        string->source = malloc(length * sizeof(char));
+    }
+    string->interned = false;
+    string->length = length;
+    string->hash = 0;
+    return string;
+}
+
+static void single_char_strings_init(void) {
+    for (size_t i = 0; i < 256; ++i) {
+        RaelStringValue *string = string_new_sized(1);
+        string->source[0] = (char)i;
+        string->interned = true;
+        string->hash = hash_chars(string->source, 1);
+        ((RaelValue*)string)->reference_count = RAEL_REFCOUNT_IMMORTAL;
+        single_char_strings[i] = string;
+    }
+}
+
+RaelValue *string_new_char(char c) {
+    pthread_once(&single_char_strings_once, single_char_strings_init);
+    return (RaelValue*)single_char_strings[(unsigned char)c];
+}
 
 RaelValue *string_new_pure(char *source, size_t length, bool can_free) {
-    RaelStringValue *string = RAEL_VALUE_NEW(RaelStringType, RaelStringValue);
+    RaelStringValue *string;
+
+    if (length <= 1) {
+        RaelValue *shared = length == 0 ? (RaelValue*)&empty_string : string_new_char(source[0]);
+        if (can_free)
+            free(source);
+        return shared;
+    }
+    string = RAEL_VALUE_NEW(RaelStringType, RaelStringValue);
     string->type = StringTypePure;
+    string->interned = false;
     string->can_be_freed = can_free;
     string->source = source;
     string->length = length;
+    string->hash = 0;
     return (RaelValue*)string;
 }
 
+static void substring_stats_add(RaelStringValue *substring) {
+    __atomic_add_fetch(&substring_stats.substring_bytes, substring->length, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&substring_stats.retained_bytes, substring->reference_string->length, __ATOMIC_RELAXED);
+}
+
+static void substring_stats_remove(RaelStringValue *substring) {
+    __atomic_sub_fetch(&substring_stats.substring_bytes, substring->length, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&substring_stats.retained_bytes, substring->reference_string->length, __ATOMIC_RELAXED);
+}
+
 RaelValue *string_new_substr(char *source, size_t length, RaelStringValue *reference_string) {
-    RaelStringValue *string = RAEL_VALUE_NEW(RaelStringType, RaelStringValue);
+    RaelStringValue *string;
+
+    // short substrings are copied, because a copy is as cheap as a reference
+    if (length <= RAEL_STRING_SHORT_LENGTH)
+        return string_new_pure_cpy(source, length);
+    string = RAEL_VALUE_NEW(RaelStringType, RaelStringValue);
     string->type = StringTypeSub;
+    string->interned = false;
     string->source = source;
     string->length = length;
+    string->hash = 0;
     value_ref((RaelValue*)reference_string);
     string->reference_string = reference_string;
+    substring_stats_add(string);
     return (RaelValue*)string;
 }
 
-/* create a new value from a string pointer and its length */
-RaelValue *string_new_pure_cpy(char *source, size_t length) {
-    char *allocated;
+void string_compact(RaelValue *value) {
+    RaelStringValue *self = (RaelStringValue*)value;
+    RaelStringValue *reference_string;
+    char *source;
 
-    // don't even try to malloc(0), just get set a NULL
-    if (length == 0) {
-        allocated = NULL;
-    } else {
-        allocated = malloc(length * sizeof(char));
-        memcpy(allocated, source, length * sizeof(char));
+    if (value->type != &RaelStringType || self->type != StringTypeSub)
+        return;
+    reference_string = self->reference_string;
+    if (self->length * RAEL_STRING_COMPACT_RATIO > reference_string->length)
+        return;
+
+    // the contents stay the same, so the value can be changed even if it's referenced elsewhere
+    source = malloc(self->length * sizeof(char));
+    memcpy(source, self->source, self->length * sizeof(char));
+    substring_stats_remove(self);
+    self->type = StringTypePure;
+    self->can_be_freed = true;
+    self->source = source;
+    value_deref((RaelValue*)reference_string);
+    __atomic_add_fetch(&substring_stats.compacted, 1, __ATOMIC_RELAXED);
+}
+
+void string_stats(RaelStringStats *out) {
+    out->substring_bytes = __atomic_load_n(&substring_stats.substring_bytes, __ATOMIC_RELAXED);
+    out->retained_bytes = __atomic_load_n(&substring_stats.retained_bytes, __ATOMIC_RELAXED);
+    out->compacted = __atomic_load_n(&substring_stats.compacted, __ATOMIC_RELAXED);
+}
+
+RaelValue *string_intern(char *source, size_t length) {
+    RaelStringValue *string;
+    size_t hash, idx;
+
+    // empty and single char strings are already unique
+    if (length <= 1)
+        return string_new_pure(source, length, false);
+
+    hash = hash_chars(source, length);
+    pthread_mutex_lock(&interned_strings.lock);
+    // keep the table at most half full
+    if (2 * (interned_strings.amount + 1) > interned_strings.allocated) {
+        size_t allocated = interned_strings.allocated ? interned_strings.allocated * 2 : 64;
+        RaelStringValue **strings = calloc(allocated, sizeof(RaelStringValue*));
+
+        for (size_t i = 0; i < interned_strings.allocated; ++i) {
+            RaelStringValue *moved = interned_strings.strings[i];
+            if (!moved)
+                continue;
+            for (idx = moved->hash & (allocated - 1); strings[idx]; idx = (idx + 1) & (allocated - 1))
+                ;
+            strings[idx] = moved;
+        }
+        free(interned_strings.strings);
+        interned_strings.strings = strings;
+        interned_strings.allocated = allocated;
+    }
+
+    for (idx = hash & (interned_strings.allocated - 1); (string = interned_strings.strings[idx]);
+         idx = (idx + 1) & (interned_strings.allocated - 1)) {
+        if (string->hash == hash && string->length == length && memcmp(string->source, source, length) == 0)
+            break;
     }
-    return string_new_pure(allocated, length, true);
+    if (!string) {
+        string = string_new_sized(length);
+        memcpy(string->source, source, length * sizeof(char));
+        string->interned = true;
+        string->hash = hash;
+        ((RaelValue*)string)->reference_count = RAEL_REFCOUNT_IMMORTAL;
+        interned_strings.strings[idx] = string;
+        ++interned_strings.amount;
+    }
+    pthread_mutex_unlock(&interned_strings.lock);
+    return (RaelValue*)string;
 }
 
+size_t string_hash(RaelStringValue *self) {
+    size_t hash = self->hash;
 
-static RaelValue *string_new_empty(void) {
-    return string_new_pure(NULL, 0, true);
+    if (hash == 0) {
+        hash = hash_chars(self->source, self->length);
+        // immortal strings are shared between threads, so they aren't written to (the shared strings get their hash when they're made)
+        if (((RaelValue*)self)->reference_count != RAEL_REFCOUNT_IMMORTAL)
+            self->hash = hash;
+    }
+    return hash;
+}
+
+/* create a new value from a string pointer and its length */
+RaelValue *string_new_unshared(RaelStringValue *self) {
+    RaelStringValue *string = string_new_sized(self->length);
+
+    memcpy(string->source, self->source, self->length * sizeof(char));
+    return (RaelValue*)string;
+}
+
+RaelValue *string_new_pure_cpy(char *source, size_t length) {
+    RaelStringValue *string;
+
+    if (length <= 1)
+        return string_new_pure(source, length, false);
+    string = string_new_sized(length);
+    memcpy(string->source, source, length * sizeof(char));
+    return (RaelValue*)string;
 }
 
 char *string_to_cstr(RaelStringValue *self) {
@@ -63,7 +251,6 @@ char string_get_char(RaelStringValue *self, size_t idx) {
 
 /* get a string at idx */
 RaelValue *string_get(RaelStringValue *self, size_t idx) {
-    RaelValue *new_string;
     size_t str_len;
 
     // get string length
@@ -72,15 +259,10 @@ RaelValue *string_get(RaelStringValue *self, size_t idx) {
         return NULL;
 
     if (idx == str_len) { // if you indexed the last character, return an empty string
-        new_string = string_new_pure(NULL, 0, true);
+        return (RaelValue*)&empty_string;
     } else {
-        // allocate a 1-lengthed string and put the character into it
-        char *ptr = malloc(1 * sizeof(char));
-        ptr[0] = self->source[idx];
-        new_string = string_new_pure(ptr, 1, true);
+        return string_new_char(self->source[idx]);
     }
-
-    return new_string;
 }
 
 RaelValue *string_slice(RaelStringValue *self, size_t start, size_t end) {
@@ -96,7 +278,8 @@ RaelValue *string_slice(RaelStringValue *self, size_t start, size_t end) {
     length = end - start;
 
     switch (self->type) {
-    case StringTypePure: reference_string = self; break;
+    case StringTypePure:
+    case StringTypeShort: reference_string = self; break;
     case StringTypeSub: reference_string = self->reference_string; break;
     default: RAEL_UNREACHABLE();
     }
@@ -108,7 +291,7 @@ RaelValue *string_slice(RaelStringValue *self, size_t start, size_t end) {
 }
 
 static RaelValue *string_add_string(RaelStringValue *string, RaelStringValue *string2) {
-    char *source;
+    RaelStringValue *new_string;
     size_t length, str1len, str2len;
 
     // calculate length of strings
@@ -117,20 +300,24 @@ static RaelValue *string_add_string(RaelStringValue *string, RaelStringValue *st
 
     // calculate size of new string and allocate it
     length = str1len + str2len;
-    source = malloc(length * sizeof(char));
+    if (length <= 1)
+        return string_new_pure_cpy(str1len > 0 ? string->source : string2->source, length);
+    new_string = string_new_sized(length);
 
     // copy other strings' contents into the new string
-    strncpy(source, string->source, str1len);
-    strncpy(source + str1len, string2->source, str2len);
+    if (str1len > 0)
+        memcpy(new_string->source, string->source, str1len);
+    if (str2len > 0)
+        memcpy(new_string->source + str1len, string2->source, str2len);
 
     // return the new string object
-    return string_new_pure(source, length, true);
+    return (RaelValue*)new_string;
 }
 
 /* string + number */
 static RaelValue *string_add_number(RaelStringValue *string, RaelNumberValue *number) {
     RaelInt n;
-    char *source;
+    RaelStringValue *new_string;
     size_t str_len;
 
     if (!number_is_whole(number)) {
@@ -144,15 +331,17 @@ static RaelValue *string_add_number(RaelStringValue *string, RaelNumberValue *nu
 
     // get length of rhs
     str_len = string_length(string);
+    if (str_len == 0)
+        return string_new_char((char)n);
     // allocate the string
-    source = malloc((str_len + 1) * sizeof(char));
+    new_string = string_new_sized(str_len + 1);
 
     // copy the string
-    strncpy(source, string->source, str_len);
+    memcpy(new_string->source, string->source, str_len);
     // add the ascii character
-    source[str_len] = (char)n;
+    new_string->source[str_len] = (char)n;
 
-    return string_new_pure(source, str_len + 1, true);
+    return (RaelValue*)new_string;
 }
 
 RaelValue *string_add(RaelStringValue *self, RaelValue *value) {
@@ -172,8 +361,11 @@ void string_delete(RaelStringValue *self) {
             free(self->source);
         break;
     case StringTypeSub:
+        substring_stats_remove(self);
         value_deref((RaelValue*)self->reference_string);
         break;
+    case StringTypeShort:
+        break;
     default:
         RAEL_UNREACHABLE();
     }
@@ -220,6 +412,13 @@ bool string_eq(RaelStringValue *self, RaelStringValue *value) {
     str1_len = string_length(self);
     str2_len = string_length(value);
 
+    // interned strings are only equal to themselves
+    if (self->interned && value->interned)
+        return self == value;
+    // if both hashes are known, they must be equal
+    if (self->hash != 0 && value->hash != 0 && self->hash != value->hash)
+        return false;
+
     // if the strings have to have the same length
     if (str1_len == str2_len) {
         // if the base value is the same (e.g they inherit from the same constant value or are equal substrings)
@@ -234,6 +433,10 @@ bool string_eq(RaelStringValue *self, RaelStringValue *value) {
     }
 }
 
+RaelValue *string_copy(RaelStringValue *self) {
+    return string_new_pure_cpy(self->source, self->length);
+}
+
 RaelValue *string_cast(RaelStringValue *self, RaelTypeValue *type) {
     if (type == &RaelNumberType) {
         struct RaelHybridNumber hybrid;
@@ -268,6 +471,21 @@ bool string_as_bool(RaelStringValue *self) {
     return string_length(self) > 0;
 }
 
+/* find the first occurrence of `search` in `source`. returns NULL if it isn't found */
+static char *find_chars(char *source, char *end, char *search, size_t search_length) {
+    if (search_length == 0)
+        return source;
+    while ((size_t)(end - source) >= search_length) {
+        // look for the first char, and compare the rest only where it's found
+        if (!(source = memchr(source, search[0], (size_t)(end - source) - search_length + 1)))
+            return NULL;
+        if (memcmp(source + 1, search + 1, search_length - 1) == 0)
+            return source;
+        ++source;
+    }
+    return NULL;
+}
+
 /*
  * Given a string self and a search string, the function returns the index of the first occurance of the
  * search string in the self.
@@ -277,52 +495,44 @@ bool string_as_bool(RaelStringValue *self) {
  * it returns -1.
  */
 static RaelInt string_find(RaelStringValue *self, RaelStringValue *search_string, size_t start_index) {
-    size_t length = string_length(self);
-    size_t search_length = string_length(search_string);
-    RaelInt index = -1; // not found yet
-
-    // you can only search the string when the search string is shorter or the same length as the searched string
-    if (search_length <= length) {
-        bool found = false;
-        for (size_t i = start_index; !found && i < length - search_length + 1; ++i) {
-            bool matching = true;
-            for (size_t j = 0; matching && j < search_length; ++j) {
-                if (self->source[i + j] != search_string->source[j]) {
-                    matching = false;
-                }
-            }
-            if (matching) {
-                index = i;
-                found = true;
-            }
-        }
-    }
-    return index;
+    char *found;
+
+    if (start_index > self->length)
+        return -1;
+    found = find_chars(self->source + start_index, self->source + self->length, search_string->source, search_string->length);
+    return found ? (RaelInt)(found - self->source) : -1;
 }
 
-/*
- * Probably temporary function until I have a stringbuilder.
- * Copies a string to the end of self.
- */
-static void string_extend(RaelStringValue *self, char *source, size_t length) {
-    size_t self_length = string_length(self);
-
-    assert(self->type != StringTypeSub);
-    assert(self->can_be_freed);
-    // allocate more/new space
-    if (self_length == 0) {
-        if (length > 0) {
-            self->source = malloc(length * sizeof(char));
-        }
-    } else {
-        self->source = realloc(self->source, (self_length + length) * sizeof(char));
+/* the string that substrings of self should reference */
+static RaelStringValue *string_reference(RaelStringValue *self) {
+    return self->type == StringTypeSub ? self->reference_string : self;
+}
+
+/* the substrings that a split produces, which are collected and then become the values of a stack */
+typedef struct StringPieces {
+    RaelStringValue *reference;
+    RaelValue **values;
+    size_t amount, allocated;
+} StringPieces;
+
+static void pieces_new(StringPieces *out, RaelStringValue *self) {
+    out->reference = string_reference(self);
+    out->values = NULL;
+    out->amount = 0;
+    out->allocated = 0;
+}
+
+static void pieces_add(StringPieces *pieces, char *source, size_t length) {
+    if (pieces->amount == pieces->allocated) {
+        pieces->allocated = pieces->allocated ? pieces->allocated * 2 : 16;
+        pieces->values = realloc(pieces->values, pieces->allocated * sizeof(RaelValue*));
     }
-    self->length += length;
-    // copy into self
-    if (length > 0)
-        strncpy(&self->source[self_length], source, length);
+    pieces->values[pieces->amount++] = string_new_substr(source, length, pieces->reference);
 }
 
+static RaelValue *pieces_to_stack(StringPieces *pieces) {
+    return stack_new_from(pieces->values, pieces->amount, pieces->allocated);
+}
 /*
  * Returns a new lowercase string created from self.
  * "Rael":toLower() = "rael"
@@ -521,14 +731,14 @@ RaelValue *string_method_chunkSplit(RaelStringValue *self, RaelArgumentList *arg
     stack = (RaelStackValue*)stack_new(amount_full_chunks + (additional_chunk_length > 0));
 
     for (size_t i = 0; i < amount_full_chunks; ++i) {
-        RaelValue *substr = string_new_substr(&self->source[i * (size_t)chunk_size], (size_t)chunk_size, self);
+        RaelValue *substr = string_new_substr(&self->source[i * (size_t)chunk_size], (size_t)chunk_size, string_reference(self));
         stack_push(stack, substr);
         value_deref(substr);
     }
 
     // if there was an additional chunk add it
     if (additional_chunk_length > 0) {
-        RaelValue *substr = string_new_substr(&self->source[amount_full_chunks * (size_t)chunk_size], additional_chunk_length, self);
+        RaelValue *substr = string_new_substr(&self->source[amount_full_chunks * (size_t)chunk_size], additional_chunk_length, string_reference(self));
         stack_push(stack, substr);
         value_deref(substr);
     }
@@ -541,11 +751,10 @@ RaelValue *string_method_chunkSplit(RaelStringValue *self, RaelArgumentList *arg
  * "Apple, Banana, Orange":split(", ") = { "Apple", "Banana", "Orange" }
  */
 RaelValue *string_method_split(RaelStringValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
-    RaelStackValue *stack;
-    RaelValue *arg1, *rest;
+    RaelValue *arg1;
     RaelStringValue *splitter;
-    size_t length, splitter_length;
-    size_t last_index = 0;
+    StringPieces pieces;
+    char *cur, *end, *match;
 
     (void)interpreter;
     arg1 = arguments_get(args, 0);
@@ -554,47 +763,54 @@ RaelValue *string_method_split(RaelStringValue *self, RaelArgumentList *args, Ra
     }
 
     splitter = (RaelStringValue*)arg1;
-
-    // get length of string and splitter
-    length = string_length(self);
-    splitter_length = string_length(splitter);
-
-    if (splitter_length == 0) {
+    if (string_length(splitter) == 0) {
         return BLAME_NEW_CSTR_ST("Empty separator not allowed", *arguments_state(args, 0));
     }
 
-    stack = (RaelStackValue*)stack_new(0);
-
-    // if the length of the splitter is bigger, it wouldn't be able to split the string
-    if (splitter_length <= length) {
-        while (last_index < length - splitter_length + 1) {
-            RaelInt match = string_find(self, splitter, last_index);
+    // push the substrings between the separators, and then the rest
+    pieces_new(&pieces, self);
+    cur = self->source;
+    end = self->source + self->length;
+    while ((match = find_chars(cur, end, splitter->source, splitter->length))) {
+        pieces_add(&pieces, cur, (size_t)(match - cur));
+        cur = match + splitter->length;
+    }
+    pieces_add(&pieces, cur, (size_t)(end - cur));
 
-            // if the separator is not found again, break
-            if (match == -1) {
-                break;
-            } else {
-                RaelValue *substr;
-                size_t substr_length = (size_t)match - last_index;
+    return pieces_to_stack(&pieces);
+}
 
-                // get the substring and push it
-                substr = string_new_substr(&self->source[last_index], substr_length, self);
-                stack_push(stack, substr);
-                value_deref(substr);
+/*
+ * Splits the string into its lines, which end with "\n" or "\r\n".
+ * A newline at the end of the string doesn't start another line.
+ * "a\r\nb\n":splitLines() = { "a", "b" }
+ */
+RaelValue *string_method_splitLines(RaelStringValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    StringPieces pieces;
+    char *cur, *end, *newline;
 
-                last_index = (size_t)match + splitter_length;
-            }
+    (void)args;
+    (void)interpreter;
+    pieces_new(&pieces, self);
+    cur = self->source;
+    end = self->source + self->length;
+    while (cur < end) {
+        size_t line_length;
+
+        if ((newline = memchr(cur, '\n', (size_t)(end - cur)))) {
+            line_length = (size_t)(newline - cur);
+            if (line_length > 0 && cur[line_length - 1] == '\r')
+                --line_length;
+            pieces_add(&pieces, cur, line_length);
+            cur = newline + 1;
+        } else {
+            pieces_add(&pieces, cur, (size_t)(end - cur));
+            cur = end;
         }
     }
 
-    // push the rest
-    rest = string_new_substr(&self->source[last_index], length - last_index, self);
-    stack_push(stack, rest);
-    value_deref(rest);
-
-    return (RaelValue*)stack;
+    return pieces_to_stack(&pieces);
 }
-
 /*
  * Returns the index of the first occurrence of the string argument in self.
  * "Banana":findIndexOf("na") = 2
@@ -649,7 +865,8 @@ RaelValue *string_method_contains(RaelStringValue *self, RaelArgumentList *args,
 RaelValue *string_method_replace(RaelStringValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
     RaelValue *arg1, *arg2;
     RaelStringValue *search_string, *replace_string, *new_string;
-    size_t length, search_length, replace_length, last_index = 0;
+    char *cur, *end, *match, *dest;
+    size_t *matches = NULL, amount_matches = 0, allocated_matches = 0;
 
     (void)interpreter;
     arg1 = arguments_get(args, 0);
@@ -664,38 +881,46 @@ RaelValue *string_method_replace(RaelStringValue *self, RaelArgumentList *args,
     // get the string to replace and the string to replace it with
     search_string = (RaelStringValue*)arg1;
     replace_string = (RaelStringValue*)arg2;
-    // initialize an empty string
-    new_string = (RaelStringValue*)string_new_empty();
-
-    // get lengths
-    length = string_length(self);
-    search_length = string_length(search_string);
-    replace_length = string_length(replace_string);
-
-    while (last_index < length - search_length + 1) {
-        // try to find the next occurrance to replace
-        RaelInt index = string_find(self, search_string, last_index);
+    if (string_length(search_string) == 0) {
+        return BLAME_NEW_CSTR_ST("Empty search string not allowed", *arguments_state(args, 0));
+    }
 
-        // if there is no future occurrance
-        if (index == -1) {
-            break;
-        } else {
-            // extand string with things up until now
-            string_extend(new_string, &self->source[last_index], (size_t)index - last_index);
+    // find all of the occurrences, so the new string can be allocated once
+    cur = self->source;
+    end = self->source + self->length;
+    while ((match = find_chars(cur, end, search_string->source, search_string->length))) {
+        if (amount_matches == allocated_matches) {
+            allocated_matches = allocated_matches ? allocated_matches * 2 : 16;
+            matches = realloc(matches, allocated_matches * sizeof(size_t));
+        }
+        matches[amount_matches++] = (size_t)(match - self->source);
+        cur = match + search_string->length;
+    }
 
-            // add replacement
-            string_extend(new_string, replace_string->source, replace_length);
+    // strings can't be changed, so if there is nothing to replace the string itself is returned
+    if (amount_matches == 0) {
+        value_ref((RaelValue*)self);
+        return (RaelValue*)self;
+    }
 
-            // calculate new index
-            last_index = (size_t)index + search_length;
-        }
+    new_string = string_new_sized(self->length - amount_matches * search_string->length + amount_matches * replace_string->length);
+    dest = new_string->source;
+    cur = self->source;
+    for (size_t i = 0; i < amount_matches; ++i) {
+        size_t before_length = (size_t)(self->source + matches[i] - cur);
+
+        memcpy(dest, cur, before_length);
+        dest += before_length;
+        if (replace_string->length > 0)
+            memcpy(dest, replace_string->source, replace_string->length);
+        dest += replace_string->length;
+        cur = self->source + matches[i] + search_string->length;
     }
+    memcpy(dest, cur, (size_t)(end - cur));
+    free(matches);
 
-    // add the rest
-    string_extend(new_string, &self->source[last_index], length - last_index);
     return (RaelValue*)new_string;
 }
-
 /*
  * Returns the amount of times a string argument can be found inside of self.
  * "a string is a string":timesContains("string") = 2
@@ -732,15 +957,55 @@ RaelValue *string_method_timesContains(RaelStringValue *self, RaelArgumentList *
     return number_newi(times_contained);
 }
 
+/*
+ * Create a new string from strings, with `separator` between every two of them.
+ * The length of the new string is measured first, so it's allocated once.
+ */
+static RaelValue *strings_join(RaelStringValue *separator, RaelStringValue **strings, size_t amount_strings) {
+    RaelStringValue *new_string;
+    size_t length = amount_strings > 0 ? (amount_strings - 1) * separator->length : 0;
+    char *dest;
+
+    for (size_t i = 0; i < amount_strings; ++i)
+        length += strings[i]->length;
+    if (length <= 1) {
+        for (size_t i = 0; i < amount_strings; ++i) {
+            if (strings[i]->length > 0)
+                return string_new_pure_cpy(strings[i]->source, length);
+        }
+        return string_new_pure_cpy(separator->source, length);
+    }
+
+    new_string = string_new_sized(length);
+    dest = new_string->source;
+    for (size_t i = 0; i < amount_strings; ++i) {
+        if (i > 0 && separator->length > 0) {
+            memcpy(dest, separator->source, separator->length);
+            dest += separator->length;
+        }
+        if (strings[i]->length > 0) {
+            memcpy(dest, strings[i]->source, strings[i]->length);
+            dest += strings[i]->length;
+        }
+    }
+
+    return (RaelValue*)new_string;
+}
+
+static void strings_deref(RaelStringValue **strings, size_t amount_strings) {
+    for (size_t i = 0; i < amount_strings; ++i)
+        value_deref((RaelValue*)strings[i]);
+    free(strings);
+}
+
 /*
  * Create a new string from a string iterator, separating it with self.
  * ", ":separate({ "Banana", "Apple", "Beans" }) = "Banana, Apple, Beans"
  */
 RaelValue *string_method_separate(RaelStringValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
-    RaelValue *arg1;
-    RaelStackValue *strings;
-    size_t amount_strings, length;
-    RaelStringValue *new_string;
+    RaelValue *arg1, *new_string;
+    RaelStringValue **strings;
+    size_t amount_strings;
 
     (void)interpreter;
     arg1 = arguments_get(args, 0);
@@ -749,41 +1014,130 @@ RaelValue *string_method_separate(RaelStringValue *self, RaelArgumentList *args,
         return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 0));
     }
 
-    // initialize strings array
-    strings = (RaelStackValue*)stack_new(0);
-
-    for (size_t i = 0; i < value_length(arg1); ++i) {
+    amount_strings = value_length(arg1);
+    strings = malloc(amount_strings * sizeof(RaelStringValue*));
+    for (size_t i = 0; i < amount_strings; ++i) {
         RaelValue *maybe_string = value_get(arg1, i);
-        // verify the number is a string
+        // verify the value is a string
         if (maybe_string->type != &RaelStringType) {
             value_deref(maybe_string);
-            value_deref((RaelValue*)strings);
+            strings_deref(strings, i);
             return BLAME_NEW_CSTR_ST("Iterable does not produce strings", *arguments_state(args, 0));
         }
-        // push the string to the strings array
-        stack_push(strings, maybe_string);
-        value_deref(maybe_string);
+        strings[i] = (RaelStringValue*)maybe_string;
     }
 
-    amount_strings = stack_length(strings);
-    // get length of separator
-    length = string_length(self);
-    // create the string that will be filled
-    new_string = (RaelStringValue*)string_new_empty();
+    new_string = strings_join(self, strings, amount_strings);
+    strings_deref(strings, amount_strings);
+    return new_string;
+}
+
+/* cast a value to a string. returns NULL if the value can't be a string */
+static RaelStringValue *value_to_string(RaelValue *value) {
+    RaelValue *casted = value_cast(value, &RaelStringType);
+
+    if (casted && casted->type != &RaelStringType) {
+        value_deref(casted);
+        return NULL;
+    }
+    return (RaelStringValue*)casted;
+}
 
+/*
+ * Like separate, but the values of the iterable are casted to strings.
+ * ", ":join({ 1, "Apple", 2.5 }) = "1, Apple, 2.5"
+ */
+RaelValue *string_method_join(RaelStringValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    RaelValue *arg1, *new_string;
+    RaelStringValue **strings;
+    size_t amount_strings;
+
+    (void)interpreter;
+    arg1 = arguments_get(args, 0);
+
+    if (!value_is_iterable(arg1)) {
+        return BLAME_NEW_CSTR_ST("Expected an iterable", *arguments_state(args, 0));
+    }
+
+    amount_strings = value_length(arg1);
+    strings = malloc(amount_strings * sizeof(RaelStringValue*));
     for (size_t i = 0; i < amount_strings; ++i) {
-        RaelStringValue *sep = (RaelStringValue*)stack_get(strings, i);
-        size_t sep_length = string_length(sep);
+        RaelValue *value = value_get(arg1, i);
+
+        strings[i] = value_to_string(value);
+        value_deref(value);
+        if (!strings[i]) {
+            strings_deref(strings, i);
+            return BLAME_NEW_CSTR_ST("Iterable produces a value that can't be casted to a string",
+                                     *arguments_state(args, 0));
+        }
+    }
+
+    new_string = strings_join(self, strings, amount_strings);
+    strings_deref(strings, amount_strings);
+    return new_string;
+}
+
+/*
+ * Replace every {} in self with the next argument, casted to a string.
+ * {{ and }} are replaced with { and }.
+ * "{} has {} apples":format("Dan", 3) = "Dan has 3 apples"
+ */
+RaelValue *string_method_format(RaelStringValue *self, RaelArgumentList *args, RaelInterpreter *interpreter) {
+    size_t amount_args = arguments_amount(args), amount_placeholders = 0, length = 0;
+    RaelStringValue **strings;
+    RaelStringValue *new_string;
+    char *source = self->source, *end = self->source + self->length, *dest;
+
+    (void)interpreter;
+
+    // measure the formatted string, without the arguments
+    for (char *c = source; c < end; ++c) {
+        if (c + 1 < end && c[0] == '{' && c[1] == '}') {
+            ++amount_placeholders;
+            ++c;
+        } else {
+            if (c + 1 < end && (c[0] == '{' || c[0] == '}') && c[1] == c[0])
+                ++c;
+            ++length;
+        }
+    }
 
-        if (i > 0) {
-            string_extend(new_string, self->source, length);
+    if (amount_placeholders > amount_args) {
+        return BLAME_NEW_CSTR("Not enough arguments for the format string");
+    } else if (amount_placeholders < amount_args) {
+        return BLAME_NEW_CSTR_ST("Too many arguments for the format string",
+                                 *arguments_state(args, amount_placeholders));
+    }
+
+    strings = malloc(amount_args * sizeof(RaelStringValue*));
+    for (size_t i = 0; i < amount_args; ++i) {
+        if (!(strings[i] = value_to_string(arguments_get(args, i)))) {
+            strings_deref(strings, i);
+            return BLAME_NEW_CSTR_ST("Can't cast value to a string", *arguments_state(args, i));
         }
-        string_extend(new_string, sep->source, sep_length);
-        value_deref((RaelValue*)sep);
+        length += strings[i]->length;
     }
 
-    // remove the temp stack and return the new string
-    value_deref((RaelValue*)strings);
+    // fill the new string
+    new_string = string_new_sized(length);
+    dest = new_string->source;
+    for (size_t arg_idx = 0; source < end; ++source) {
+        if (source + 1 < end && source[0] == '{' && source[1] == '}') {
+            if (strings[arg_idx]->length > 0) {
+                memcpy(dest, strings[arg_idx]->source, strings[arg_idx]->length);
+                dest += strings[arg_idx]->length;
+            }
+            ++arg_idx;
+            ++source;
+        } else {
+            if (source + 1 < end && (source[0] == '{' || source[0] == '}') && source[1] == source[0])
+                ++source;
+            *dest++ = *source;
+        }
+    }
+    strings_deref(strings, amount_args);
+
     return (RaelValue*)new_string;
 }
 
@@ -815,11 +1169,16 @@ RaelTypeValue RaelStringType = {
     .logger = (RaelSingleFunc)string_complex_repr, /* fallbacks */
 
     .cast = (RaelCastFunc)string_cast,
+    .copy = (RaelCopyFunc)string_copy,
 
     .at_index = (RaelGetFunc)string_get,
     .at_range = (RaelSliceFunc)string_slice,
 
     .length = (RaelLengthFunc)string_length,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = (MethodDecl[]) {
         RAEL_CMETHOD("toLower", string_method_toLower, 0, 0),
@@ -831,11 +1190,14 @@ RaelTypeValue RaelStringType = {
         RAEL_CMETHOD("isDigit", string_method_isDigit, 0, 0),
         RAEL_CMETHOD("chunkSplit", string_method_chunkSplit, 1, 1),
         RAEL_CMETHOD("split", string_method_split, 1, 1),
+        RAEL_CMETHOD("splitLines", string_method_splitLines, 0, 0),
         RAEL_CMETHOD("findIndexOf", string_method_findIndexOf, 1, 1),
         RAEL_CMETHOD("contains", string_method_contains, 1, 1),
         RAEL_CMETHOD("replace", string_method_replace, 2, 2),
         RAEL_CMETHOD("timesContains", string_method_timesContains, 1, 1),
         RAEL_CMETHOD("separate", string_method_separate, 1, 1),
+        RAEL_CMETHOD("join", string_method_join, 1, 1),
+        RAEL_CMETHOD_UNRESTRICTED("format", string_method_format),
         RAEL_CMETHOD_TERMINATOR
     }
 };
@@ -9,6 +9,10 @@
 #include <stddef.h>
 
 #define RAEL_STRING_FROM_CSTR(string) (string_new_pure_cpy(string, sizeof(string) / sizeof(char) - 1))
+/* strings that are created with up to this many chars are stored inside of the value */
+#define RAEL_STRING_SHORT_LENGTH 32
+/* substrings that are this many times smaller than the string they reference are copied when they're stored */
+#define RAEL_STRING_COMPACT_RATIO 8
 
 struct RaelStringValue;
 
@@ -18,24 +22,65 @@ struct RaelStringValue {
     RAEL_VALUE_BASE;
     enum {
         StringTypePure,
-        StringTypeSub
+        StringTypeSub,
+        /* the source is stored in `short_source` */
+        StringTypeShort
     } type;
+    /* interned strings are unique by their contents, so they are equal only if they are the same value */
+    bool interned;
     char *source;
     size_t length;
+    /* the hash of the string, or 0 if it wasn't computed yet */
+    size_t hash;
     union {
         bool can_be_freed;
         RaelStringValue *reference_string;
     };
+    char short_source[];
 };
 
+/* counters of the substrings that are alive */
+typedef struct RaelStringStats {
+    /* the bytes of the substrings */
+    size_t substring_bytes;
+    /* the bytes of the strings that the substrings keep alive, counted once for every substring */
+    size_t retained_bytes;
+    /* the amount of substrings that were copied to their own buffer */
+    size_t compacted;
+} RaelStringStats;
+
 extern RaelTypeValue RaelStringType;
 
+/* strings of one char (and the empty string) are shared and immortal */
 RaelValue *string_new_pure(char *source, size_t length, bool can_free);
 
 RaelValue *string_new_pure_cpy(char *source, size_t length);
 
 RaelValue *string_new_substr(char *source, size_t length, RaelStringValue *reference_string);
 
+/* returns the shared string of a single char, which never allocates */
+RaelValue *string_new_char(char c);
+
+/* returns the immortal string with these contents, which is shared by everyone who interns them */
+RaelValue *string_intern(char *source, size_t length);
+
+/*
+ * returns a new string with the same contents, which isn't shared even if it's empty or a single char.
+ * it's used to give keys to a variable that stores a shared string
+ */
+RaelValue *string_new_unshared(RaelStringValue *self);
+
+/* the hash of the string, which is computed once */
+size_t string_hash(RaelStringValue *self);
+
+/*
+ * called for a value that is stored in a variable or a stack. if it's a substring which is much
+ * smaller than the string it references, it's copied so it doesn't keep the whole string alive
+ */
+void string_compact(RaelValue *value);
+
+void string_stats(RaelStringStats *out);
+
 void string_delete(RaelStringValue *self);
 
 char *string_to_cstr(RaelStringValue *self);
@@ -2,6 +2,7 @@
 
 RaelStructValue *struct_new(char *name) {
     RaelStructValue *self = RAEL_VALUE_NEW(RaelStructType, RaelStructValue);
+    fields_new(&self->fields);
     self->name = name;
     return self;
 }
@@ -11,24 +12,20 @@ void struct_add_entry(RaelStructValue *self, char *name, RaelValue *value) {
 }
 
 void struct_repr(RaelStructValue *self) {
-    const struct VariableMap *map = &((RaelValue*)self)->keys;
-    size_t pairs_left = map->pairs;
+    RaelShape *shape = self->fields.shape;
 
     printf("[Struct %s { ", self->name);
-    for (size_t i = 0; pairs_left > 0 && i < map->allocated; ++i) {
-        for (struct BucketNode *bucket_ptr = map->buckets[i]; bucket_ptr; bucket_ptr = bucket_ptr->next) {
-            if (pairs_left < map->pairs)
-                printf(", ");
-            printf(":%s ?= ", bucket_ptr->key);
-            value_repr(bucket_ptr->value);
-            --pairs_left;
-        }
+    for (size_t i = 0; i < shape->amount_keys; ++i) {
+        if (i > 0)
+            printf(", ");
+        printf(":%s ?= ", shape->keys[i]);
+        value_repr(self->fields.values[i]);
     }
     printf(" }]");
 }
 
 size_t struct_length(RaelStructValue *self) {
-    return ((RaelValue*)self)->keys.pairs;
+    return self->fields.shape->amount_keys;
 }
 
 void struct_delete(RaelStructValue *self) {
@@ -63,11 +60,16 @@ RaelTypeValue RaelStructType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = NULL,
+    .copy = NULL,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = (RaelLengthFunc)struct_length,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = offsetof(RaelStructValue, fields),
 
     .methods = NULL
 };
@@ -9,6 +9,7 @@
 
 typedef struct RaelStructValue {
     RAEL_VALUE_BASE;
+    RaelFields fields;
     char *name;
 } RaelStructValue;
 
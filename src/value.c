@@ -1,5 +1,7 @@
 #include "rael.h"
 
+#include <pthread.h>
+
 bool type_eq(RaelTypeValue *self, RaelTypeValue *value) {
     // types are constant values that are only created, statically, once
     return self == value;
@@ -17,6 +19,11 @@ RaelValue *type_cast(RaelTypeValue *self, RaelTypeValue *type) {
     }
 }
 
+/* types are immortal, so every thread can use the same type value */
+RaelValue *type_copy(RaelTypeValue *self) {
+    return (RaelValue*)self;
+}
+
 RaelInt type_validate_args(RaelTypeValue *self, size_t amount) {
     assert(self->constructor_info);
 
@@ -78,11 +85,16 @@ RaelTypeValue RaelTypeType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = (RaelCastFunc)type_cast,
+    .copy = (RaelCopyFunc)type_copy,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = NULL
 };
@@ -98,6 +110,11 @@ RaelValue *void_cast(RaelValue *self, RaelTypeValue *type) {
     }
 }
 
+RaelValue *void_copy(RaelValue *self) {
+    (void)self;
+    return void_new();
+}
+
 bool void_as_bool(RaelValue *self) {
     (void)self;
     return false;
@@ -141,47 +158,166 @@ RaelTypeValue RaelVoidType = {
     .logger = NULL, /* fallbacks to .repr */
 
     .cast = void_cast,
+    .copy = void_copy,
 
     .at_index = NULL,
     .at_range = NULL,
 
     .length = NULL,
+    .op_iter_next = NULL,
+
+    .keys_offset = 0,
+    .fields_offset = 0,
 
     .methods = NULL
 };
 
 RaelValue RaelVoid = (RaelValue) {
     .type = &RaelVoidType,
-    .reference_count = 1
+    .reference_count = RAEL_REFCOUNT_IMMORTAL
 };
 
+/*
+ * keys that are set on values whose type doesn't store keys. they are rare (most keys are set on
+ * modules and structs), so they are kept out of the value header, and only values that have
+ * RAEL_VALUE_FLAG_SIDE_KEYS are looked up in the table. values can be created and freed by
+ * different threads, so the table is locked
+ */
+struct SideKeys {
+    struct SideKeys *next;
+    RaelValue *value;
+    struct VariableMap keys;
+};
+
+static struct {
+    struct SideKeys **buckets;
+    size_t allocated, amount;
+    pthread_mutex_t lock;
+} side_keys = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER };
+
+static inline size_t side_keys_hash(RaelValue *value, size_t allocated) {
+    return (size_t)(((uintptr_t)value >> 4) * 11400714819323198485ull) & (allocated - 1);
+}
+
+/* the side keys of a value. the side table must be locked */
+static struct SideKeys **side_keys_find(RaelValue *value) {
+    struct SideKeys **node;
+
+    if (side_keys.allocated == 0)
+        return NULL;
+    for (node = &side_keys.buckets[side_keys_hash(value, side_keys.allocated)]; *node; node = &(*node)->next) {
+        if ((*node)->value == value)
+            return node;
+    }
+    return NULL;
+}
+
+/* add side keys to a value. the side table must be locked */
+static struct SideKeys *side_keys_add(RaelValue *value) {
+    struct SideKeys *added;
+    size_t idx;
+
+    // grow the table when it's full
+    if (side_keys.amount >= side_keys.allocated) {
+        size_t allocated = side_keys.allocated ? side_keys.allocated * 2 : 16;
+        struct SideKeys **buckets = calloc(allocated, sizeof(struct SideKeys*));
+
+        for (size_t i = 0; i < side_keys.allocated; ++i) {
+            struct SideKeys *next;
+            for (struct SideKeys *node = side_keys.buckets[i]; node; node = next) {
+                next = node->next;
+                idx = side_keys_hash(node->value, allocated);
+                node->next = buckets[idx];
+                buckets[idx] = node;
+            }
+        }
+        free(side_keys.buckets);
+        side_keys.buckets = buckets;
+        side_keys.allocated = allocated;
+    }
+
+    added = malloc(sizeof(struct SideKeys));
+    added->value = value;
+    varmap_new(&added->keys);
+    idx = side_keys_hash(value, side_keys.allocated);
+    added->next = side_keys.buckets[idx];
+    side_keys.buckets[idx] = added;
+    ++side_keys.amount;
+    return added;
+}
+
+/* delete the side keys of a value that is deallocated, if it has any */
+static void side_keys_remove(RaelValue *value) {
+    struct SideKeys **node, *removed = NULL;
+
+    if (!(value->flags & RAEL_VALUE_FLAG_SIDE_KEYS))
+        return;
+    pthread_mutex_lock(&side_keys.lock);
+    if ((node = side_keys_find(value))) {
+        removed = *node;
+        *node = removed->next;
+        --side_keys.amount;
+    }
+    pthread_mutex_unlock(&side_keys.lock);
+
+    // the keys are deleted outside of the lock, because deleting them can free other values
+    if (removed) {
+        varmap_delete(&removed->keys);
+        free(removed);
+    }
+}
+
+/*
+ * the map of keys of a value whose type doesn't store fields. if `create` is false and no keys were set, NULL is returned.
+ * the lock only protects the table: the map that is returned belongs to a value that isn't immortal, so it's
+ * only used by the instance that owns the value
+ */
+static struct VariableMap *value_keys(RaelValue *self, bool create) {
+    struct SideKeys **node;
+    struct VariableMap *keys;
+
+    if (self->type->keys_offset != 0)
+        return (struct VariableMap*)((char*)self + self->type->keys_offset);
+    assert(!create || self->reference_count != RAEL_REFCOUNT_IMMORTAL);
+    if (!(self->flags & RAEL_VALUE_FLAG_SIDE_KEYS) && !create)
+        return NULL;
+
+    pthread_mutex_lock(&side_keys.lock);
+    if (self->flags & RAEL_VALUE_FLAG_SIDE_KEYS) {
+        node = side_keys_find(self);
+        assert(node);
+        keys = &(*node)->keys;
+    } else {
+        keys = &side_keys_add(self)->keys;
+        self->flags |= RAEL_VALUE_FLAG_SIDE_KEYS;
+    }
+    pthread_mutex_unlock(&side_keys.lock);
+    return keys;
+}
+
+static inline RaelFields *value_fields(RaelValue *self) {
+    return (RaelFields*)((char*)self + self->type->fields_offset);
+}
+
 /* create a new RaelValue with RaelTypeValue and size `size` */
 RaelValue *value_new(RaelTypeValue *type, size_t size) {
     RaelValue *value;
     assert(size >= sizeof(RaelValue));
 
-    // re-reference the type because it's going to be used for the type
-    value_ref((RaelValue*)type);
+    // types are immortal, so there's no need to reference the type
     value = malloc(size);
     value->type = type;
     value->reference_count = 1;
-    // initialize members
-    varmap_new(&value->keys);
-
-    // if there are methods defines, add them
-    if (type->methods) {
-        for (MethodDecl *m = type->methods; m->method; ++m) {
-            RaelValue *method = method_cfunc_new(value, m);
-            varmap_set(&value->keys, m->name, method, true, false);
-            value_deref(method);
-        }
-    }
-
+    value->flags = 0;
     return value;
 }
 
 void value_ref(RaelValue *value) {
     RaelSingleFunc maybe_ref = value->type->op_ref;
+
+    // immortal values are shared between interpreters, so they must never be modified
+    if (value->reference_count == RAEL_REFCOUNT_IMMORTAL)
+        return;
     ++value->reference_count;
     // call the reference function if there is one defined
     if (maybe_ref) {
@@ -192,6 +328,8 @@ void value_ref(RaelValue *value) {
 void value_deref(RaelValue *value) {
     RaelSingleFunc maybe_deref = value->type->op_deref;
 
+    if (value->reference_count == RAEL_REFCOUNT_IMMORTAL)
+        return;
     --value->reference_count;
     if (value->reference_count == 0) {
         RaelSingleFunc possible_deallocator = value->type->deallocator;
@@ -202,9 +340,12 @@ void value_deref(RaelValue *value) {
         }
 
         // delete set keys
-        varmap_delete(&value->keys);
-        // dereference the type
-        value_deref((RaelValue*)value->type);
+        if (value->type->fields_offset != 0)
+            fields_delete(value_fields(value));
+        else if (value->type->keys_offset != 0)
+            varmap_delete(value_keys(value, false));
+        else
+            side_keys_remove(value);
         // remove the allocated space of the dynamic value in memory
         free(value);
     } else if (maybe_deref) {
@@ -300,14 +441,39 @@ RaelValue *value_get(RaelValue *self, size_t idx) {
 }
 
 /* :Value:Key */
-RaelValue *value_get_key(RaelValue *self, char *key, RaelInterpreter *interpreter) {
+RaelValue *value_get_key(RaelValue *self, char *key, struct KeyCache *cache, RaelInterpreter *interpreter) {
+    RaelValue *value = NULL;
+
     // get value at that key
-    RaelValue *value = varmap_get(&self->keys, key);
+    if (self->type->fields_offset != 0) {
+        RaelValue **value_ptr = fields_get_ptr(value_fields(self), key, cache);
+        if (value_ptr) {
+            value = *value_ptr;
+            value_ref(value);
+        }
+    } else {
+        struct VariableMap *keys = value_keys(self, false);
+        if (keys)
+            value = cache ? varmap_get_cached(keys, key, &cache->map) : varmap_get(keys, key);
+    }
 
-    // if the key is found, return it, otherwise return a Void
+    // if the key is found, return it, otherwise try the methods of the type, or return a Void
     if (value) {
         return value;
     }
+    if (cache && cache->type == self->type)
+        return method_cfunc_new(self, cache->method);
+    if (self->type->methods) {
+        for (MethodDecl *m = self->type->methods; m->method; ++m) {
+            if (strcmp(m->name, key) == 0) {
+                if (cache) {
+                    cache->type = self->type;
+                    cache->method = m;
+                }
+                return method_cfunc_new(self, m);
+            }
+        }
+    }
 
     if (interpreter->warn_undefined) {
         rael_show_warning_key(key);
@@ -316,8 +482,31 @@ RaelValue *value_get_key(RaelValue *self, char *key, RaelInterpreter *interprete
     return void_new();
 }
 
-void value_set_key(RaelValue *self, char *key, RaelValue *value) {
-    varmap_set(&self->keys, key, value, true, true);
+RaelValue **value_get_key_ptr(RaelValue *self, char *key) {
+    struct VariableMap *keys;
+
+    if (self->type->fields_offset != 0)
+        return fields_get_ptr(value_fields(self), key, NULL);
+    keys = value_keys(self, false);
+    return keys ? varmap_get_ptr(keys, key) : NULL;
+}
+
+bool value_has_side_keys(RaelValue *self) {
+    return self->flags & RAEL_VALUE_FLAG_SIDE_KEYS;
+}
+
+bool value_set_key(RaelValue *self, char *key, RaelValue *value) {
+    if (self->type->fields_offset != 0) {
+        fields_set(value_fields(self), key, value);
+    } else if (self->type->keys_offset == 0 && self->reference_count == RAEL_REFCOUNT_IMMORTAL) {
+        // immortal values (like interned strings) are shared by everything that uses them, even
+        // between threads, so a key that is set on one would be seen by all of them
+        free(key);
+        return false;
+    } else {
+        varmap_set(value_keys(self, true), key, value, true, true);
+    }
+    return true;
 }
 
 void value_set_int(RaelValue *value, char *key, RaelInt i) {
@@ -479,6 +668,16 @@ RaelValue *value_cast(RaelValue *value, RaelTypeValue *type) {
     }
 }
 
+RaelValue *value_copy(RaelValue *value) {
+    RaelCopyFunc possible_copy = value->type->copy;
+
+    if (possible_copy) {
+        return possible_copy(value);
+    } else {
+        return NULL; // value can't be copied
+    }
+}
+
 RaelValue *value_call(RaelValue *value, RaelArgumentList *args, RaelInterpreter *interpreter) {
     RaelCallerFunc possible_call;
     RaelValue *return_value;
@@ -518,6 +717,15 @@ bool value_is_iterable(RaelValue *value) {
            value->type->length != NULL;
 }
 
+bool value_is_iterator(RaelValue *value) {
+    return value->type->op_iter_next != NULL;
+}
+
+RaelValue *value_iter_next(RaelValue *value) {
+    assert(value_is_iterator(value));
+    return value->type->op_iter_next(value);
+}
+
 bool value_is_callable(RaelValue *value) {
     return value->type->callable_info != NULL;
 }
@@ -2,19 +2,25 @@
 #define RAEL_VALUE_H
 
 #include "varmap.h"
+#include "shape.h"
 #include "common.h"
 #include "interpreter.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 /* create a value from a `RaelTypeValue` and a C type that inherits from RaelValue */
 #define RAEL_VALUE_NEW(value_type, c_type) ((c_type*)value_new(&value_type, sizeof(c_type)))
 /* header to put on top of custom rael runtime values which lets the values inherit from RaelValue */
 #define RAEL_VALUE_BASE RaelValue _base
+/* reference count of statically allocated values which are never freed (types, Void) */
+#define RAEL_REFCOUNT_IMMORTAL UINT32_MAX
+/* a flag of values that have keys in the side table (see value_set_key) */
+#define RAEL_VALUE_FLAG_SIDE_KEYS 0x1
 /* header for type definitions */
-#define RAEL_TYPE_DEF_INIT ._base = { \
-    .reference_count = 1,             \
-    .type = &RaelTypeType             \
+#define RAEL_TYPE_DEF_INIT ._base = {             \
+    .reference_count = RAEL_REFCOUNT_IMMORTAL,    \
+    .type = &RaelTypeType                         \
 }
 
 struct RaelTypeValue;
@@ -35,12 +41,20 @@ typedef RaelValue* (*RaelNegFunc)(RaelValue*);
 typedef size_t (*RaelLengthFunc)(RaelValue*);
 typedef RaelValue* (*RaelMethodFunc)(RaelValue*, RaelArgumentList*, RaelInterpreter*);
 typedef RaelInt (*RaelCanTakeFunc)(RaelValue*, size_t);
-
-/* the dynamic value abstraction layer */
+typedef RaelValue* (*RaelCopyFunc)(RaelValue*);
+typedef RaelValue* (*RaelIterNextFunc)(RaelValue*);
+
+/*
+ * the dynamic value abstraction layer. values don't carry keys: modules keep their keys in their
+ * own struct (see keys_offset), struct-like values keep them as fields (see fields_offset), keys
+ * that are set on other values are kept in a side table, and methods are looked up in the type
+ * when they're accessed
+ */
 typedef struct RaelValue {
     RaelTypeValue *type;
-    size_t reference_count;
-    struct VariableMap keys;
+    /* a 32 bit count leaves room for the flags, so the header stays 16 bytes */
+    uint32_t reference_count;
+    uint32_t flags;
 } RaelValue;
 
 typedef struct RaelCallableInfo {
@@ -115,6 +129,11 @@ typedef struct RaelTypeValue {
 
     /* Cast the value to a new type */
     RaelCastFunc cast;
+    /*
+     * Create a copy of the value which shares no mutable state with it,
+     * so it can be moved to a different thread. NULL if the value can't be copied
+     */
+    RaelCopyFunc copy;
 
     /* Indexing operations */
     RaelGetFunc at_index;
@@ -122,6 +141,19 @@ typedef struct RaelTypeValue {
 
     /* Get length */
     RaelLengthFunc length;
+    /*
+     * Get the next value of a value that produces its values one by one (an iterator),
+     * or NULL when there are no more values. Iterators are consumed by iterating them
+     */
+    RaelIterNextFunc op_iter_next;
+
+    /*
+     * The offset of a `struct VariableMap` of keys in the type's values, for types that are
+     * collections of keys. If it's 0, keys that are set on the values are kept in a side table
+     */
+    size_t keys_offset;
+    /* The offset of `RaelFields` in the type's values, for types whose values have a fixed set of keys */
+    size_t fields_offset;
 
     /* Methods */
     MethodDecl *methods;
@@ -161,6 +193,12 @@ bool values_eq(RaelValue *value, RaelValue *value2);
 /* returns a boolean saying if the value is an iterable */
 bool value_is_iterable(RaelValue *value);
 
+/* returns a boolean saying if the value is an iterator, which produces its values one by one */
+bool value_is_iterator(RaelValue *value);
+
+/* get the next value of an iterator, or NULL if the iterator is exhausted */
+RaelValue *value_iter_next(RaelValue *value);
+
 /* returns a boolean saying if the value is callable */
 bool value_is_callable(RaelValue *value);
 
@@ -215,11 +253,23 @@ RaelValue *value_neg(RaelValue *value);
 /* value to type */
 RaelValue *value_cast(RaelValue *value, RaelTypeValue *type);
 
-/* value:key */
-RaelValue *value_get_key(RaelValue *self, char *key, RaelInterpreter *interpreter);
+/* deep copy of a value, which can be moved to another thread. returns NULL if the value can't be copied */
+RaelValue *value_copy(RaelValue *value);
+
+/* value:key. `cache` is an optional cache of the last lookup at the same place */
+RaelValue *value_get_key(RaelValue *self, char *key, struct KeyCache *cache, RaelInterpreter *interpreter);
+
+/* a pointer to the value that is set at a key of a value, or NULL if the key wasn't set */
+RaelValue **value_get_key_ptr(RaelValue *self, char *key);
+
+/*
+ * value:key ?= value. notice that key will be freed, so it mustn't be a shared key (like an ast one).
+ * returns false if the value is immortal and can't have keys
+ */
+bool value_set_key(RaelValue *self, char *key, RaelValue *value);
 
-/* value:key ?= value. notice that key will be freed, so it mustn't be a shared key (like an ast one) */
-void value_set_key(RaelValue *self, char *key, RaelValue *value);
+/* were keys set on a value whose type doesn't store them (see keys_offset)? */
+bool value_has_side_keys(RaelValue *self);
 
 /* value:key ?= i. same rules as value_set_key are applied here */
 void value_set_int(RaelValue *value, char *key, RaelInt i);
@@ -1,9 +1,96 @@
 #include "rael.h"
 
+#define VARMAP_BUCKETS 8
+#define VARMAP_POOL_MAX 256
+
+/*
+ * Bucket arrays and nodes of deleted varmaps are kept in per-thread pools and reused,
+ * because a varmap is created for every scope. Bucket arrays are linked through their first bucket.
+ */
+static __thread struct BucketNode **bucket_array_pool = NULL;
+static __thread size_t bucket_array_pool_size = 0;
+static __thread struct BucketNode *node_pool = NULL;
+static __thread size_t node_pool_size = 0;
+
+static struct BucketNode **bucket_array_new(void) {
+    struct BucketNode **buckets;
+
+    if (bucket_array_pool) {
+        buckets = bucket_array_pool;
+        bucket_array_pool = (struct BucketNode**)buckets[0];
+        --bucket_array_pool_size;
+        memset(buckets, 0, VARMAP_BUCKETS * sizeof(struct BucketNode*));
+    } else {
+        buckets = calloc(VARMAP_BUCKETS, sizeof(struct BucketNode*));
+    }
+    return buckets;
+}
+
+static void bucket_array_delete(struct BucketNode **buckets) {
+    if (bucket_array_pool_size < VARMAP_POOL_MAX) {
+        buckets[0] = (struct BucketNode*)bucket_array_pool;
+        bucket_array_pool = buckets;
+        ++bucket_array_pool_size;
+    } else {
+        free(buckets);
+    }
+}
+
+static struct BucketNode *bucket_node_new(void) {
+    struct BucketNode *node;
+
+    if (node_pool) {
+        node = node_pool;
+        node_pool = node->next;
+        --node_pool_size;
+    } else {
+        node = malloc(sizeof(struct BucketNode));
+    }
+    return node;
+}
+
+static void bucket_node_delete(struct BucketNode *node) {
+    if (node_pool_size < VARMAP_POOL_MAX) {
+        node->next = node_pool;
+        node_pool = node;
+        ++node_pool_size;
+    } else {
+        free(node);
+    }
+}
+
+void varmap_free_pool(void) {
+    struct BucketNode *next_node;
+    struct BucketNode **next_buckets;
+
+    for (struct BucketNode *node = node_pool; node; node = next_node) {
+        next_node = node->next;
+        free(node);
+    }
+    for (struct BucketNode **buckets = bucket_array_pool; buckets; buckets = next_buckets) {
+        next_buckets = (struct BucketNode**)buckets[0];
+        free(buckets);
+    }
+    node_pool = NULL;
+    node_pool_size = 0;
+    bucket_array_pool = NULL;
+    bucket_array_pool_size = 0;
+}
+
+/* the last version that was given to a map. versions are never reused, so caches of deleted maps never match */
+static size_t varmap_last_version = 0;
+
 void varmap_new(struct VariableMap *out) {
     out->buckets = NULL;
     out->allocated = 0;
     out->pairs = 0;
+    out->version = 0;
+}
+
+size_t varmap_version(struct VariableMap *varmap) {
+    if (varmap->version == 0)
+        varmap->version = __atomic_add_fetch(&varmap_last_version, 1, __ATOMIC_RELAXED);
+    return varmap->version;
 }
 
 /* hash according to the size of the varmap */
@@ -35,6 +122,8 @@ struct BucketNode *varmap_find_key_node(struct VariableMap *varmap, char *key) {
 bool varmap_set(struct VariableMap *varmap, char *key, RaelValue *value, bool set_if_not_found, bool dealloc_key_on_free) {
     struct BucketNode *node, *last_node = NULL;
 
+    // invalidate the caches of the map
+    varmap->version = 0;
     if (varmap->allocated > 0) { // look for a matching bucket node
         size_t hash_result = varmap_hash(varmap, key);
         // loop all nodes in bucket and find a matching key
@@ -62,12 +151,12 @@ bool varmap_set(struct VariableMap *varmap, char *key, RaelValue *value, bool se
         return false;
 
     if (varmap->allocated == 0)
-        varmap->buckets = calloc((varmap->allocated = 8), sizeof(struct BucketNode *));
+        varmap->buckets = bucket_array_new(), varmap->allocated = VARMAP_BUCKETS;
 
     // reference the value you set
     value_ref(value);
     // create new node
-    node = malloc(sizeof(struct BucketNode));
+    node = bucket_node_new();
     node->key = key;
     node->value = value;
     node->dealloc_key_on_free = dealloc_key_on_free;
@@ -105,6 +194,21 @@ RaelValue *varmap_get(struct VariableMap *varmap, char *key) {
     return *ptr;
 }
 
+RaelValue *varmap_get_cached(struct VariableMap *varmap, char *key, struct VariableMapCache *cache) {
+    struct BucketNode *node;
+
+    if (varmap->version != 0 && cache->version == varmap->version) {
+        node = cache->node;
+    } else {
+        if (!(node = varmap_find_key_node(varmap, key)))
+            return NULL;
+        cache->version = varmap_version(varmap);
+        cache->node = node;
+    }
+    value_ref(node->value);
+    return node->value;
+}
+
 void varmap_delete(struct VariableMap *varmap) {
     if (varmap->allocated > 0) {
         for (size_t i = 0; i < varmap->allocated; ++i) {
@@ -114,9 +218,9 @@ void varmap_delete(struct VariableMap *varmap) {
                 next = node->next;
                 if (node->dealloc_key_on_free)
                     free(node->key);
-                free(node);
+                bucket_node_delete(node);
             }
         }
-        free(varmap->buckets);
+        bucket_array_delete(varmap->buckets);
     }
 }
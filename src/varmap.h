@@ -15,6 +15,14 @@ struct VariableMap {
         RaelValue *value;
     } **buckets;
     size_t allocated, pairs;
+    /* identifies the current contents of the map. 0 means it wasn't given one since it was last changed */
+    size_t version;
+};
+
+/* remembers where a key was found in a map, so looking it up again doesn't need to hash it */
+struct VariableMapCache {
+    size_t version;
+    struct BucketNode *node;
 };
 
 void varmap_new(struct VariableMap *out);
@@ -25,6 +33,17 @@ RaelValue **varmap_get_ptr(struct VariableMap *varmap, char *key);
 
 RaelValue *varmap_get(struct VariableMap *varmap, char *key);
 
+struct BucketNode *varmap_find_key_node(struct VariableMap *varmap, char *key);
+
+/* get the version of the map, which is unique among all versions of all maps */
+size_t varmap_version(struct VariableMap *varmap);
+
+/* like varmap_get, but uses and updates a cache of the last lookup */
+RaelValue *varmap_get_cached(struct VariableMap *varmap, char *key, struct VariableMapCache *cache);
+
 void varmap_delete(struct VariableMap *varmap);
 
+/* free the bucket arrays and nodes that are kept for reuse by the current thread */
+void varmap_free_pool(void);
+
 #endif /* RAEL_VARMAP_H */
@@ -0,0 +1,131 @@
+/*
+ * A test of the embedding API (src/rael_api.h), which is linked with build/librael.a.
+ * Run it with `make apitest`.
+ */
+#include "rael_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define AMOUNT_THREADS 4
+
+static int failures = 0;
+
+#define CHECK(condition)                                                   \
+    do {                                                                   \
+        if (!(condition)) {                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                    \
+        }                                                                  \
+    } while (0)
+
+/* evaluate an expression that is expected to be a whole number */
+static bool eval_int(RaelContext *context, const char *expression, long *out) {
+    RaelObject *object = rael_context_eval(context, expression);
+    bool result = object && rael_object_to_int(object, out);
+
+    rael_object_release(object);
+    return result;
+}
+
+static void test_values(void) {
+    RaelContext *context = rael_context_new(0, NULL);
+    RaelObject *object;
+    char *cstr;
+    double f;
+    long n;
+
+    rael_context_set_int(context, "n", 20);
+    rael_context_set_float(context, "f", 0.5);
+    rael_context_set_string(context, "s", "embedded");
+
+    CHECK(eval_int(context, ":n * 2 + 2", &n) && n == 42);
+
+    object = rael_context_eval(context, ":f + 1");
+    CHECK(rael_object_to_float(object, &f) && f == 1.5);
+    CHECK(!rael_object_to_int(object, &n));
+    CHECK(strcmp(rael_object_type_name(object), "Number") == 0);
+    rael_object_release(object);
+
+    object = rael_context_eval(context, ":s + \"!\"");
+    CHECK(strcmp(rael_object_type_name(object), "String") == 0);
+    cstr = rael_object_to_cstr(object);
+    CHECK(cstr && strcmp(cstr, "embedded!") == 0);
+    free(cstr);
+    rael_object_release(object);
+
+    // releasing NULL does nothing
+    rael_object_release(NULL);
+
+    rael_context_delete(context);
+}
+
+static void test_separate_contexts(void) {
+    RaelContext *first = rael_context_new(0, NULL);
+    RaelContext *second = rael_context_new(0, NULL);
+    long n;
+
+    CHECK(rael_context_run_string(first, ":x ?= 1\n:double ?= routine(:n) {\n^:n * 2\n}\n", NULL) == 0);
+    CHECK(rael_context_run_string(second, ":x ?= 100\n:double ?= routine(:n) {\n^:n + :n + 1\n}\n", "second") == 0);
+    CHECK(eval_int(first, ":double(:x)", &n) && n == 2);
+    CHECK(eval_int(second, ":double(:x)", &n) && n == 201);
+
+    // deleting a context doesn't affect the others
+    rael_context_delete(first);
+    CHECK(eval_int(second, ":x", &n) && n == 100);
+    rael_context_delete(second);
+}
+
+static void *run_context(void *arg) {
+    long id = (long)(size_t)arg;
+    long *result = malloc(sizeof(long));
+    RaelContext *context = rael_context_new(0, NULL);
+
+    rael_context_set_int(context, "id", id);
+    if (rael_context_run_string(context,
+            ":sum ?= 0\n"
+            "loop :i through 0 to 10000 {\n"
+            "    :sum ?= :sum + :i % 7 + :id\n"
+            "}\n"
+            ":words ?= { \"a\", \"b\", \"c\" }\n"
+            ":text ?= \", \":join(:words)\n", NULL) != 0
+        || !eval_int(context, ":sum + sizeof :text", result)) {
+        *result = -1;
+    }
+    rael_context_delete(context);
+    return result;
+}
+
+static void test_concurrent_contexts(void) {
+    pthread_t threads[AMOUNT_THREADS];
+    long expected_sum = 0;
+
+    for (long i = 0; i < 10000; ++i)
+        expected_sum += i % 7;
+
+    for (size_t i = 0; i < AMOUNT_THREADS; ++i)
+        pthread_create(&threads[i], NULL, run_context, (void*)i);
+
+    for (size_t i = 0; i < AMOUNT_THREADS; ++i) {
+        long *result;
+
+        pthread_join(threads[i], (void**)&result);
+        CHECK(*result == expected_sum + 10000 * (long)i + 7);
+        free(result);
+    }
+}
+
+int main(void) {
+    test_values();
+    test_separate_contexts();
+    test_concurrent_contexts();
+
+    if (failures) {
+        fprintf(stderr, "%d API checks failed\n", failures);
+        return 1;
+    }
+    printf("API tests passed!\n");
+    return 0;
+}